@@ -32,6 +32,15 @@ struct PyChannelObject;
 
 typedef int( schedule_hook_func )( struct PyTaskletObject* from, struct PyTaskletObject* to );
 
+/* Scheduler counters filled in by PyScheduler_GetThreadStatistics and PyScheduler_GetProcessStatistics */
+struct SchedulerStatistics
+{
+	long allTimeTaskletCount;
+	long activeTaskletCount;
+	long taskletsCompletedLastRunWithTimeout;
+	long taskletsSwitchedLastRunWithTimeout;
+};
+
 struct SchedulerCAPI
 {
     // =============== function pointer types ===============
@@ -47,6 +56,9 @@ struct SchedulerCAPI
     using PyTasklet_Kill_Routine                                        = std::add_pointer_t<int(struct PyTaskletObject*)>;
     using PyTasklet_GetTimesSwitchedTo_Routine                          = std::add_pointer_t<long(struct PyTaskletObject*)>;
     using PyTasklet_GetContext_Routine                                  = std::add_pointer_t<const char*(struct PyTaskletObject*)>;
+    using PyTasklet_AllocateLocalSlot_Routine                           = std::add_pointer_t<int(void)>;
+    using PyTasklet_GetLocal_Routine                                    = std::add_pointer_t<PyObject*(struct PyTaskletObject*, int)>;
+    using PyTasklet_SetLocal_Routine                                    = std::add_pointer_t<int(struct PyTaskletObject*, int, PyObject*)>;
 
     //channel functions
 	using PyChannel_New_Routine           		                        = std::add_pointer_t<struct PyChannelObject*(PyTypeObject*)>;
@@ -77,6 +89,8 @@ struct SchedulerCAPI
     using PyScheduler_GetActiveTaskletCount_Routine                     = std::add_pointer_t<int(void)>;
     using PyScheduler_GetTaskletsCompletedLastRunWithTimeout_Routine    = std::add_pointer_t<int(void)>;
     using PyScheduler_GetTaskletsSwitchedLastRunWithTimeout_Routine     = std::add_pointer_t<int(void)>;
+    using PyScheduler_GetThreadStatistics_Routine                       = std::add_pointer_t<void(struct SchedulerStatistics*)>;
+    using PyScheduler_GetProcessStatistics_Routine                      = std::add_pointer_t<void(struct SchedulerStatistics*)>;
 
     // =============== member function pointers ===============
 
@@ -130,6 +144,13 @@ struct SchedulerCAPI
 
     PyTasklet_GetTimesSwitchedTo_Routine PyTasklet_GetTimesSwitchedTo;
 	PyTasklet_GetContext_Routine PyTasklet_GetContext;
+
+	PyTasklet_AllocateLocalSlot_Routine PyTasklet_AllocateLocalSlot;
+	PyTasklet_GetLocal_Routine PyTasklet_GetLocal;
+	PyTasklet_SetLocal_Routine PyTasklet_SetLocal;
+
+	PyScheduler_GetThreadStatistics_Routine PyScheduler_GetThreadStatistics;
+	PyScheduler_GetProcessStatistics_Routine PyScheduler_GetProcessStatistics;
 };
 
 
@@ -1,6 +1,7 @@
 import collections
 import contextlib
 import threading
+import time
 
 
 import _scheduler
@@ -85,3 +86,51 @@ def block_trap(trap=True):
         yield
     finally:
         c.block_trap = old
+
+
+class CancelScope(object):
+    """
+    Bounds every blocking operation of the current tasklet inside a with block.
+    Once `timeout` seconds have passed the blocked operation raises TimeoutError.
+    Scopes nest, an inner scope can only shorten the deadline of an outer one.
+    With `move_on` set the scope suppresses its own TimeoutError and sets
+    `cancelled_caught` instead of propagating it.
+    """
+    def __init__(self, timeout, move_on=False):
+        self.timeout = timeout
+        self.move_on = move_on
+        self.deadline = None
+        self.cancelled_caught = False
+        self._tasklet = None
+        self._previous = None
+
+    def __enter__(self):
+        self._tasklet = _scheduler.getcurrent()
+        self._previous = self._tasklet.deadline
+        self.deadline = time.monotonic() + self.timeout
+        if self._previous is not None and self._previous < self.deadline:
+            self.deadline = self._previous
+        self._tasklet.deadline = self.deadline
+        # Read back the deadline as rounded to the scheduler clock
+        self.deadline = self._tasklet.deadline
+        return self
+
+    def __exit__(self, exc_type, exc_value, tb):
+        self._tasklet.deadline = self._previous
+        self._tasklet = None
+        if exc_type is not None and issubclass(exc_type, TimeoutError) and self.move_on:
+            # Only swallow the timeout if this scope's own deadline caused it
+            if self.deadline != self._previous and time.monotonic() >= self.deadline:
+                self.cancelled_caught = True
+                return True
+        return False
+
+
+def fail_after(timeout):
+    """Cancel scope raising TimeoutError from blocking operations after timeout seconds."""
+    return CancelScope(timeout)
+
+
+def move_on_after(timeout):
+    """Cancel scope abandoning its block when a blocking operation times out after timeout seconds."""
+    return CancelScope(timeout, move_on=True)
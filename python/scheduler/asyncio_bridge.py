@@ -0,0 +1,132 @@
+"""
+Interoperability between the scheduler and asyncio.
+
+AsyncioDriver runs the scheduler of the current thread from an asyncio event
+loop. Coroutines can await channels with channel.receive_async() and tasklets
+can block on asyncio futures with wait_future(), in both cases without polling.
+"""
+import asyncio
+import weakref
+
+import _scheduler
+
+
+_drivers = weakref.WeakKeyDictionary()
+
+
+def _wakeup(loop):
+    driver = _drivers.get(loop)
+    if driver is not None:
+        driver.wakeup()
+
+
+class AsyncioDriver(object):
+    """
+    Runs the scheduler from an event loop callback for at most `budget` seconds
+    at a time. The driver keeps rescheduling itself while tasklets are runnable.
+    Once the runnables queue is empty it only runs again when a tasklet is woken
+    by the bridge or a pending tasklet timeout expires.
+    """
+    def __init__(self, loop=None, budget=0.002):
+        self.loop = loop if loop is not None else asyncio.get_event_loop()
+        self.budget = budget
+        self._handle = None
+        self._running = False
+
+    def start(self):
+        self._running = True
+        _drivers[self.loop] = self
+        self.wakeup()
+
+    def stop(self):
+        self._running = False
+        if _drivers.get(self.loop) is self:
+            del _drivers[self.loop]
+        if self._handle is not None:
+            self._handle.cancel()
+            self._handle = None
+
+    def wakeup(self):
+        """Ensure the scheduler runs on the next loop iteration."""
+        if not self._running:
+            return
+        if self._handle is not None:
+            if isinstance(self._handle, asyncio.TimerHandle):
+                self._handle.cancel()
+            else:
+                return
+        self._handle = self.loop.call_soon(self._pump)
+
+    def _pump(self):
+        self._handle = None
+        try:
+            _scheduler.run(self.budget)
+        finally:
+            if self._running:
+                if _scheduler.getruncount() > 1:
+                    self._handle = self.loop.call_soon(self._pump)
+                else:
+                    delay = _scheduler.time_until_next_timeout()
+                    if delay is not None:
+                        self._handle = self.loop.call_later(delay, self._pump)
+
+
+async def receive_async(channel):
+    """
+    Receive from a channel inside a coroutine.
+    A helper tasklet blocks on the channel and resolves a future when a value
+    arrives, cancelling the coroutine kills the helper tasklet.
+    """
+    if channel.balance > 0:
+        # A sender is waiting so the receive completes without blocking
+        return channel.receive()
+
+    loop = asyncio.get_running_loop()
+    future = loop.create_future()
+
+    def receiver():
+        try:
+            value = channel.receive()
+        except _scheduler.TaskletExit:
+            if not future.done():
+                future.cancel()
+            return
+        except BaseException as e:
+            if not future.done():
+                future.set_exception(e)
+            return
+        if not future.done():
+            future.set_result(value)
+
+    helper = _scheduler.tasklet(receiver)()
+    # Run the helper until it blocks on the channel
+    helper.run()
+
+    try:
+        return await future
+    finally:
+        if helper.alive:
+            helper.kill()
+
+
+def wait_future(future):
+    """
+    Block the current tasklet until an asyncio future completes.
+    :return: The result of the future, raising its exception if it failed
+    """
+    if not future.done():
+        waiter = _scheduler.channel()
+        waiter.preference = 1  # waking never switches away from the event loop
+
+        def done(f):
+            if waiter.balance < 0:
+                waiter.send(None)
+                _wakeup(f.get_loop())
+
+        future.add_done_callback(done)
+        try:
+            waiter.receive()
+        finally:
+            future.remove_done_callback(done)
+
+    return future.result()
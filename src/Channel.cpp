@@ -1,5 +1,6 @@
 #include "Channel.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "Tasklet.h"
@@ -15,11 +16,20 @@ Channel::Channel( PyObject* pythonObject ) :
 	m_firstBlockedOnReceive( nullptr ),
 	m_lastBlockedOnReceive( nullptr ),
 	m_closing( false ),
-	m_closed( false )
+	m_closed( false ),
+	m_channelCallbackEnabled( true ),
+	m_firstSelectOnReceive( nullptr ),
+	m_lastSelectOnReceive( nullptr ),
+	m_firstSelectOnSend( nullptr ),
+	m_lastSelectOnSend( nullptr ),
+	m_numberOfSelectCases( 0 ),
+	m_nextWaiterSequence( 0 )
 {
     // Store weak reference in central store
     // Required just in case we lose all references to channel
     // The module will then be able to unblock if needed
+	ThreadLockRAII lock( s_activeChannelsLock );
+
     s_activeChannels.insert( this );
 }
 
@@ -28,22 +38,31 @@ Channel::~Channel()
 	// Note: Destructor will never be called while there are tasklets blocking
 
 	// Remove weak ref from store
+	ThreadLockRAII lock( s_activeChannelsLock );
+
 	s_activeChannels.erase( this );
 }
 
-bool Channel::Send( PyObject* args, PyObject* exception /* = nullptr */, bool restoreException /* = false */)
+// timeout is in nanoseconds, a negative value waits indefinitely
+// Raises TimeoutError if no receiver arrives before the timeout or the cancel scope deadline
+bool Channel::Send( PyObject* args, PyObject* exception /* = nullptr */, bool restoreException /* = false */, long long timeout /* = -1 */ )
 {
     ScheduleManager* scheduleManager = ScheduleManager::GetThreadScheduleManager();
 
     Tasklet* current = scheduleManager->GetCurrentTasklet();
 
-	RunChannelCallback( this, current, true, m_lastBlockedOnReceive == nullptr );
+	RunChannelCallback( this, current, true, !HasWaitingReceiver() );
 
     current->SetTransferInProgress(true);
 
 	ChannelDirection direction = ChannelDirection::SENDER;
 
-	if( m_firstBlockedOnReceive == nullptr )
+	// Taking a receiver and blocking must be a single step with respect to other threads
+	ThreadLockRAII lock( m_lock );
+
+	Tasklet* receivingTasklet = PopNextTaskletBlockedOnReceive();
+
+	if( !receivingTasklet )
 	{
 		direction = ChannelDirection::RECEIVER;
 
@@ -71,6 +90,17 @@ bool Channel::Send( PyObject* args, PyObject* exception /* = nullptr */, bool re
 			return false;
         }
 
+		scheduleManager->ApplyCancelDeadline( current, timeout );
+
+		if( timeout == 0 )
+		{
+			current->SetTransferInProgress( false );
+
+			PyErr_SetString( PyExc_TimeoutError, "Send operation timed out" );
+
+			return false;
+		}
+
 		// Block as there is no tasklet receiving
 		current->Incref();
 
@@ -82,12 +112,45 @@ bool Channel::Send( PyObject* args, PyObject* exception /* = nullptr */, bool re
 
         current->SetTransferArguments( args, exception, restoreException );
 
+		lock.Unlock();
+
+		if( timeout > 0 )
+		{
+			scheduleManager->AddTimeout( current, timeout );
+		}
+
          // Continue scheduler
-		if( !scheduleManager->Yield() )
+		bool success = scheduleManager->Yield();
+
+		scheduleManager->RemoveTimeout( current );
+
+		if( success && current->TimedOut() )
 		{
+			// Expiry already unlinked the tasklet from the channel, the value was never taken
+			current->SetTimedOut( false );
+
 			current->SetTransferInProgress( false );
 
-            RemoveTaskletFromBlocked( current );
+			Py_DecRef( current->GetTransferArguments() );
+
+			current->ClearTransferArguments();
+
+			current->Decref();
+
+			UpdateCloseState();
+
+			PyErr_SetString( PyExc_TimeoutError, "Send operation timed out" );
+
+			return false;
+		}
+
+		if( !success )
+		{
+			current->SetTimedOut( false );
+
+			current->SetTransferInProgress( false );
+
+            UnblockTaskletFromChannel( current );
 
             auto transferArguments = current->GetTransferArguments();
 
@@ -112,31 +175,16 @@ bool Channel::Send( PyObject* args, PyObject* exception /* = nullptr */, bool re
     }
     else
     {
-		Tasklet* receivingTasklet = PopNextTaskletBlockedOnReceive();
-
 		receivingTasklet->Unblock();
 
 		// Store for retrieval from receiving tasklet
 		receivingTasklet->SetTransferArguments( args, exception, restoreException );
 
-		Tasklet* current_tasklet = scheduleManager->GetCurrentTasklet();
+		lock.Unlock();
 
-		UpdateCloseState();
-
-		if( m_preference == ChannelPreference::RECEIVER )
-		{
-			receivingTasklet->GetScheduleManager()->InsertTaskletToRunNext( receivingTasklet );
-			receivingTasklet->Decref();
-			if( !scheduleManager->Schedule( RescheduleType::BACK ) )
-			{
-				UpdateCloseState();
-				return false;
-			}
-		}
-		else
+		if( !ResumeReceiver( receivingTasklet ) )
 		{
-			receivingTasklet->GetScheduleManager()->InsertTasklet( receivingTasklet );
-			receivingTasklet->Decref();
+			return false;
 		}
     }
 
@@ -148,7 +196,9 @@ bool Channel::Send( PyObject* args, PyObject* exception /* = nullptr */, bool re
 
 }
 
-PyObject* Channel::Receive()
+// timeout is in nanoseconds, a negative value waits indefinitely
+// Raises TimeoutError if no sender arrives before the timeout or the cancel scope deadline
+PyObject* Channel::Receive( long long timeout /* = -1 */ )
 {
     ScheduleManager* scheduleManager = ScheduleManager::GetThreadScheduleManager();
 
@@ -157,7 +207,7 @@ PyObject* Channel::Receive()
 	// Block as there is no tasklet sending
 	Tasklet* current = scheduleManager->GetCurrentTasklet();
 
-	RunChannelCallback( this , current, false, m_lastBlockedOnSend == nullptr );
+	RunChannelCallback( this , current, false, !HasWaitingSender() );
 
     if( current == nullptr )
 	{
@@ -166,7 +216,12 @@ PyObject* Channel::Receive()
 		return nullptr;
 	}
 
-    if( m_firstBlockedOnSend == nullptr )
+	// Taking a sender and blocking must be a single step with respect to other threads
+	ThreadLockRAII lock( m_lock );
+
+	Tasklet* sendingTasklet = PopNextTaskletBlockedOnSend();
+
+    if( !sendingTasklet )
 	{
 		current->Incref();
 		AddTaskletToWaitingToReceive( current );
@@ -196,16 +251,60 @@ PyObject* Channel::Receive()
 
 			return nullptr;
 		}
+
+		scheduleManager->ApplyCancelDeadline( current, timeout );
+
+		if( timeout == 0 )
+		{
+			RemoveTaskletFromBlocked( current );
+
+			current->SetTransferInProgress( false );
+
+			current->Decref();
+
+			PyErr_SetString( PyExc_TimeoutError, "receive operation timed out" );
+
+			return nullptr;
+		}
 		
 		current->Block( this );
 
         UpdateCloseState();
 
+		lock.Unlock();
+
+		if( timeout > 0 )
+		{
+			scheduleManager->AddTimeout( current, timeout );
+		}
+
 		// Continue scheduler
-		if( !scheduleManager->Yield() )
+		bool success = scheduleManager->Yield();
+
+		scheduleManager->RemoveTimeout( current );
+
+		if( success && current->TimedOut() )
+		{
+			// Expiry already unlinked the tasklet from the channel
+			current->SetTimedOut( false );
+
+			current->SetTransferInProgress( false );
+
+			current->Decref();
+
+			UpdateCloseState();
+
+			PyErr_SetString( PyExc_TimeoutError, "receive operation timed out" );
+
+			return nullptr;
+		}
+
+		if( !success )
 		// Will enter here if an exception has been thrown on a tasklet
 		{
-			RemoveTaskletFromBlocked( current );
+			current->SetTimedOut( false );
+
+			UnblockTaskletFromChannel( current );
 
 			current->Unblock();
 
@@ -241,40 +340,105 @@ PyObject* Channel::Receive()
 	}
 	else
 	{
-		Tasklet* sendingTasklet = PopNextTaskletBlockedOnSend();
-		sendingTasklet->Unblock();
-		sendingTasklet->SetTransferInProgress( false );
+		TakeSenderTransfer( sendingTasklet, current );
+
+		lock.Unlock();
 
-        current->SetTransferArguments(
-            sendingTasklet->GetTransferArguments(),
-            sendingTasklet->TransferException(), 
-            sendingTasklet->ShouldRestoreTransferException()
-        );
+		if( !ResumeSender( sendingTasklet, current ) )
+		{
+			return nullptr;
+		}
+	}
 
-        Py_DECREF( sendingTasklet->GetTransferArguments() );
-        sendingTasklet->ClearTransferArguments();
+	return ProcessReceivedTransfer( current );
+}
 
-        UpdateCloseState();
-        
-        if (m_preference == ChannelPreference::SENDER)
-        {
-			sendingTasklet->GetScheduleManager()->InsertTaskletToRunNext( sendingTasklet );
-			sendingTasklet->Decref();
-			if( !scheduleManager->Schedule( RescheduleType::BACK ) )
-            {
-				current->Decref();
-				UpdateCloseState();
-				return nullptr;
-            }
-        }
-        else
+// Move the value of a sender popped from the blocked queue to the receiving tasklet, call holding m_lock
+void Channel::TakeSenderTransfer( Tasklet* sendingTasklet, Tasklet* current )
+{
+	sendingTasklet->Unblock();
+	sendingTasklet->SetTransferInProgress( false );
+
+    current->SetTransferArguments(
+        sendingTasklet->GetTransferArguments(),
+        sendingTasklet->TransferException(), 
+        sendingTasklet->ShouldRestoreTransferException()
+    );
+
+    Py_DECREF( sendingTasklet->GetTransferArguments() );
+    sendingTasklet->ClearTransferArguments();
+}
+
+// Requeue a sender whose value has been taken, following the channel preference
+// Call once m_lock is released, the reference held on behalf of the channel passes to the runnables queue
+bool Channel::ResumeSender( Tasklet* sendingTasklet, Tasklet* current )
+{
+	ScheduleManager* scheduleManager = ScheduleManager::GetThreadScheduleManager();
+
+    UpdateCloseState();
+    
+    if (m_preference == ChannelPreference::SENDER)
+    {
+		sendingTasklet->GetScheduleManager()->InsertTaskletToRunNext( sendingTasklet );
+		sendingTasklet->Decref();
+		if( !scheduleManager->Schedule( RescheduleType::BACK ) )
         {
-			sendingTasklet->GetScheduleManager()->InsertTasklet(sendingTasklet);
-			sendingTasklet->Decref();
+			current->Decref();
+			UpdateCloseState();
+			return false;
         }
+    }
+    else
+    {
+		sendingTasklet->GetScheduleManager()->InsertTasklet(sendingTasklet);
+		sendingTasklet->Decref();
+    }
+
+	return true;
+}
+
+// Requeue a receiver that has been handed its value, following the channel preference
+// Call once m_lock is released, the reference held on behalf of the channel passes to the runnables queue
+bool Channel::ResumeReceiver( Tasklet* receivingTasklet )
+{
+	ScheduleManager* scheduleManager = ScheduleManager::GetThreadScheduleManager();
+
+	UpdateCloseState();
+
+	if( m_preference == ChannelPreference::RECEIVER && scheduleManager->CanHandoffTo( receivingTasklet ) )
+	{
+		// Switch straight to the receiver, skipping the round trip through the main tasklet
+		scheduleManager->InsertTaskletToRunNext( receivingTasklet );
+		receivingTasklet->Decref();
+		if( !scheduleManager->HandoffTo( receivingTasklet ) )
+		{
+			UpdateCloseState();
+			return false;
+		}
+	}
+	else if( m_preference == ChannelPreference::RECEIVER )
+	{
+		receivingTasklet->GetScheduleManager()->InsertTaskletToRunNext( receivingTasklet );
+		receivingTasklet->Decref();
+		if( !scheduleManager->Schedule( RescheduleType::BACK ) )
+		{
+			UpdateCloseState();
+			return false;
+		}
+	}
+	else
+	{
+		receivingTasklet->GetScheduleManager()->InsertTasklet( receivingTasklet );
+		receivingTasklet->Decref();
 	}
 
-    
+	return true;
+}
+
+// Completes a receive once the transfer arguments have been set on the current tasklet
+// Raises the transferred exception if one was sent
+PyObject* Channel::ProcessReceivedTransfer( Tasklet* current )
+{
     //Process the exception
 	PyObject* transferException = current->TransferException();
 
@@ -326,359 +490,1177 @@ PyObject* Channel::Receive()
 	return ret;
 }
 
-int Channel::Balance() const
+// Send a sequence of values
+// Values are handed to waiting receivers in a single pass and the current tasklet yields at most once
+// Any values left once no receivers remain are sent as with Send, blocking as required
+bool Channel::SendMany( PyObject* const* items, Py_ssize_t numberOfItems )
 {
-	return m_balance;
-}
+	ScheduleManager* scheduleManager = ScheduleManager::GetThreadScheduleManager();
 
-void Channel::UnblockTaskletFromChannel( Tasklet* tasklet )
-{
-    // Public exposed remove_tasklet_from_blocked wrapped in lock for thread safety
-    RemoveTaskletFromBlocked( tasklet );
-}
+	Tasklet* current = scheduleManager->GetCurrentTasklet();
 
-void Channel::RemoveTaskletFromBlocked( Tasklet* tasklet )
-{
-	bool endNode = false;
-    if (tasklet == m_lastBlockedOnReceive)
-    {
-		m_lastBlockedOnReceive = tasklet->NextBlocked();
-        if (m_lastBlockedOnReceive != nullptr)
-        {
-			m_lastBlockedOnReceive->SetPreviousBlocked( nullptr );
-        }
+	Py_ssize_t numberSent = 0;
 
-		endNode = true;
-    }
+	while( numberSent < numberOfItems && HasWaitingReceiver() )
+	{
+		RunChannelCallback( this, current, true, false );
 
-    if (tasklet == m_lastBlockedOnSend)
-    {
-		m_lastBlockedOnSend = tasklet->NextBlocked();
-        if (m_lastBlockedOnSend != nullptr)
-        {
-			m_lastBlockedOnSend->SetPreviousBlocked( nullptr );
-        }
+		ThreadLockRAII lock( m_lock );
 
-        endNode = true;
-    }
+		Tasklet* receivingTasklet = PopNextTaskletBlockedOnReceive();
 
-    if (tasklet == m_firstBlockedOnReceive)
-    {
-		m_firstBlockedOnReceive = tasklet->PreviousBlocked();
-        if (m_firstBlockedOnReceive != nullptr)
-        {
-			m_firstBlockedOnReceive->SetNextBlocked( nullptr );
-        }
-		
-		endNode = true;
-    }
+		if( !receivingTasklet )
+		{
+			// Taken by another thread since the check
+			break;
+		}
 
-    if (tasklet == m_firstBlockedOnSend)
-    {
-		m_firstBlockedOnSend = tasklet->PreviousBlocked();
-        if (m_firstBlockedOnSend != nullptr)
-        {
-			m_firstBlockedOnSend->SetNextBlocked( nullptr );
-        }
-		
-		endNode = true;
-    }
+		receivingTasklet->Unblock();
 
-    if (!endNode)
-    {
-        if (tasklet->PreviousBlocked())
-        {
-			tasklet->PreviousBlocked()->SetNextBlocked( tasklet->NextBlocked() );
-        }
-        if (tasklet->NextBlocked())
-        {
-			tasklet->NextBlocked()->SetPreviousBlocked( tasklet->PreviousBlocked() );
-        }
-    }
+		receivingTasklet->SetTransferArguments( items[numberSent], nullptr, false );
 
-    tasklet->SetNextBlocked( nullptr );
-	tasklet->SetPreviousBlocked( nullptr );
+		lock.Unlock();
 
-    if (tasklet->GetBlockedDirection() == ChannelDirection::SENDER)
-    {
-		DecrementBalance();
-    }
-	else if( tasklet->GetBlockedDirection() == ChannelDirection ::RECEIVER)
-    {
-		IncrementBalance();
-    }
+		receivingTasklet->GetScheduleManager()->InsertTasklet( receivingTasklet );
 
-    tasklet->SetBlockedDirection( ChannelDirection::NEITHER );
-    
+		receivingTasklet->Decref();
+
+		numberSent++;
+	}
+
+	UpdateCloseState();
+
+	if( numberSent == numberOfItems )
+	{
+		if( numberSent > 0 && m_preference == ChannelPreference::RECEIVER )
+		{
+			return scheduleManager->Schedule( RescheduleType::BACK );
+		}
+
+		return true;
+	}
+
+	// Remaining values block until received
+	for( ; numberSent < numberOfItems; numberSent++ )
+	{
+		if( !Send( items[numberSent] ) )
+		{
+			return false;
+		}
+	}
+
+	return true;
 }
 
-void Channel::RunChannelCallback( Channel* channel, Tasklet* tasklet, bool sending, bool willBlock ) const
+// Receive up to maxItems values as a list
+// Blocks for the first value only if no sender is waiting
+// Further values are taken from senders already waiting in a single pass, yielding at most once
+// A waiting sent exception ends the batch and is left for the following receive
+PyObject* Channel::ReceiveMany( Py_ssize_t maxItems )
 {
-	if( s_channelCallback )
+	ScheduleManager* scheduleManager = ScheduleManager::GetThreadScheduleManager();
+
+	Tasklet* current = scheduleManager->GetCurrentTasklet();
+
+	PyObject* received = PyList_New( 0 );
+
+	if( received == nullptr )
 	{
-		PyObject* args = PyTuple_New( 4 );
+		return nullptr;
+	}
 
-		channel->Incref();
+	ThreadLockRAII frontLock( m_lock );
 
-		PyTuple_SetItem( args, 0, channel->PythonObject() );
+	bool blocked = !HasWaitingSender();
 
-		tasklet->Incref();
+	bool receiveFirst = blocked || WaitingSenderSentException();
 
-		PyTuple_SetItem( args, 1, tasklet->PythonObject() );
+	frontLock.Unlock();
 
-		PyTuple_SetItem( args, 2, sending ? Py_True : Py_False );
+	if( receiveFirst )
+	{
+		PyObject* value = Receive();
 
-		PyTuple_SetItem( args, 3, willBlock ? Py_True : Py_False );
+		if( value == nullptr )
+		{
+			Py_DecRef( received );
+
+			return nullptr;
+		}
 
-		PyObject_Call( s_channelCallback, args, nullptr );
+		int appended = PyList_Append( received, value );
 
-		Py_DecRef( args );
+		Py_DecRef( value );
+
+		if( appended < 0 )
+		{
+			Py_DecRef( received );
+
+			return nullptr;
+		}
 	}
-}
 
-void Channel::AddTaskletToWaitingToSend( Tasklet* tasklet )
-{
-    if( m_lastBlockedOnSend == nullptr )
-    {
+	bool handedOff = false;
+
+	while( PyList_GET_SIZE( received ) < maxItems && HasWaitingSender() )
+	{
+		ThreadLockRAII checkLock( m_lock );
+
+		if( WaitingSenderSentException() )
+		{
+			break;
+		}
+
+		checkLock.Unlock();
+
+		RunChannelCallback( this, current, false, false );
+
+		ThreadLockRAII lock( m_lock );
+
+		if( WaitingSenderSentException() )
+		{
+			break;
+		}
+
+		Tasklet* sendingTasklet = PopNextTaskletBlockedOnSend();
+
+		if( !sendingTasklet )
+		{
+			// Taken by another thread since the check
+			break;
+		}
+
+		sendingTasklet->Unblock();
+
+		sendingTasklet->SetTransferInProgress( false );
+
+		PyObject* value = sendingTasklet->GetTransferArguments();
+
+		sendingTasklet->ClearTransferArguments();
+
+		lock.Unlock();
+
+		int appended = PyList_Append( received, value );
+
+		Py_DecRef( value );
+
+		sendingTasklet->GetScheduleManager()->InsertTasklet( sendingTasklet );
+
+		sendingTasklet->Decref();
+
+		if( appended < 0 )
+		{
+			Py_DecRef( received );
+
+			return nullptr;
+		}
+
+		handedOff = true;
+	}
+
+	UpdateCloseState();
+
+	if( handedOff && !blocked && m_preference == ChannelPreference::SENDER )
+	{
+		if( !scheduleManager->Schedule( RescheduleType::BACK ) )
+		{
+			Py_DecRef( received );
+
+			return nullptr;
+		}
+	}
+
+	return received;
+}
+
+// Deliver the same value to every waiting receiver without blocking
+// Receivers are appended to the runnables queue together and the current tasklet yields at most once
+// Returns the number of receivers woken or -1 on error
+int Channel::Broadcast( PyObject* args )
+{
+	ScheduleManager* scheduleManager = ScheduleManager::GetThreadScheduleManager();
+
+	Tasklet* current = scheduleManager->GetCurrentTasklet();
+
+	if( !HasWaitingReceiver() )
+	{
+		return 0;
+	}
+
+	RunChannelCallback( this, current, true, false );
+
+	Tasklet* first = nullptr;
+
+	Tasklet* last = nullptr;
+
+	int numberOfReceivers = 0;
+
+	int numberChained = 0;
+
+	ThreadLockRAII lock( m_lock );
+
+	while( Tasklet* receivingTasklet = PopNextTaskletBlockedOnReceive() )
+	{
+		receivingTasklet->Unblock();
+
+		receivingTasklet->SetTransferArguments( args, nullptr, false );
+
+		numberOfReceivers++;
+
+		if( receivingTasklet->GetScheduleManager() != scheduleManager || receivingTasklet->IsScheduled() )
+		{
+			receivingTasklet->GetScheduleManager()->InsertTasklet( receivingTasklet );
+
+			receivingTasklet->Decref();
+
+			continue;
+		}
+
+		// Chain receivers so they can be added to the runnables queue in one step
+		receivingTasklet->SetNext( nullptr );
+
+		receivingTasklet->SetPrevious( last );
+
+		if( last == nullptr )
+		{
+			first = receivingTasklet;
+		}
+		else
+		{
+			last->SetNext( receivingTasklet );
+		}
+
+		last = receivingTasklet;
+
+		numberChained++;
+	}
+
+	lock.Unlock();
+
+	// Reference held by the block list is handed to the runnables queue
+	if( first != nullptr )
+	{
+		scheduleManager->InsertTaskletChain( first, last, numberChained );
+	}
+
+	UpdateCloseState();
+
+	if( m_preference == ChannelPreference::RECEIVER )
+	{
+		if( !scheduleManager->Schedule( RescheduleType::BACK ) )
+		{
+			return -1;
+		}
+	}
+
+	return numberOfReceivers;
+}
+
+int Channel::Balance() const
+{
+	return m_balance;
+}
+
+void Channel::UnblockTaskletFromChannel( Tasklet* tasklet )
+{
+    // Public exposed remove_tasklet_from_blocked wrapped in lock for thread safety
+	ThreadLockRAII lock( m_lock );
+
+    RemoveTaskletFromBlocked( tasklet );
+}
+
+// Take a Tasklet whose wait timed out off the block list and unblock it
+// Returns false if another thread took it off first, that thread then wakes it with its transfer
+bool Channel::WithdrawTimedOutTasklet( Tasklet* tasklet )
+{
+	ThreadLockRAII lock( m_lock );
+
+	if( tasklet->GetBlockedDirection() == ChannelDirection::NEITHER )
+	{
+		return false;
+	}
+
+	RemoveTaskletFromBlocked( tasklet );
+
+	tasklet->Unblock();
+
+	return true;
+}
+
+void Channel::RemoveTaskletFromBlocked( Tasklet* tasklet )
+{
+	bool endNode = false;
+    if (tasklet == m_lastBlockedOnReceive)
+    {
+		m_lastBlockedOnReceive = tasklet->NextBlocked();
+        if (m_lastBlockedOnReceive != nullptr)
+        {
+			m_lastBlockedOnReceive->SetPreviousBlocked( nullptr );
+        }
+
+		endNode = true;
+    }
+
+    if (tasklet == m_lastBlockedOnSend)
+    {
+		m_lastBlockedOnSend = tasklet->NextBlocked();
+        if (m_lastBlockedOnSend != nullptr)
+        {
+			m_lastBlockedOnSend->SetPreviousBlocked( nullptr );
+        }
+
+        endNode = true;
+    }
+
+    if (tasklet == m_firstBlockedOnReceive)
+    {
+		m_firstBlockedOnReceive = tasklet->PreviousBlocked();
+        if (m_firstBlockedOnReceive != nullptr)
+        {
+			m_firstBlockedOnReceive->SetNextBlocked( nullptr );
+        }
+		
+		endNode = true;
+    }
+
+    if (tasklet == m_firstBlockedOnSend)
+    {
+		m_firstBlockedOnSend = tasklet->PreviousBlocked();
+        if (m_firstBlockedOnSend != nullptr)
+        {
+			m_firstBlockedOnSend->SetNextBlocked( nullptr );
+        }
+		
+		endNode = true;
+    }
+
+    if (!endNode)
+    {
+        if (tasklet->PreviousBlocked())
+        {
+			tasklet->PreviousBlocked()->SetNextBlocked( tasklet->NextBlocked() );
+        }
+        if (tasklet->NextBlocked())
+        {
+			tasklet->NextBlocked()->SetPreviousBlocked( tasklet->PreviousBlocked() );
+        }
+    }
+
+    tasklet->SetNextBlocked( nullptr );
+	tasklet->SetPreviousBlocked( nullptr );
+
+    if (tasklet->GetBlockedDirection() == ChannelDirection::SENDER)
+    {
+		DecrementBalance();
+    }
+	else if( tasklet->GetBlockedDirection() == ChannelDirection ::RECEIVER)
+    {
+		IncrementBalance();
+    }
+
+    tasklet->SetBlockedDirection( ChannelDirection::NEITHER );
+    
+}
+
+void Channel::RunChannelCallback( Channel* channel, Tasklet* tasklet, bool sending, bool willBlock ) const
+{
+	if( s_channelCallback && channel->m_channelCallbackEnabled )
+	{
+		// Held while calling as another thread may replace the callback
+		PyObject* callback = ChannelCallbackReference();
+
+		if( !callback )
+		{
+			return;
+		}
+
+		PyObject* args = PyTuple_New( 4 );
+
+		channel->Incref();
+
+		PyTuple_SetItem( args, 0, channel->PythonObject() );
+
+		tasklet->Incref();
+
+		PyTuple_SetItem( args, 1, tasklet->PythonObject() );
+
+		PyTuple_SetItem( args, 2, sending ? Py_True : Py_False );
+
+		PyTuple_SetItem( args, 3, willBlock ? Py_True : Py_False );
+
+		PyObject_Call( callback, args, nullptr );
+
+		Py_DecRef( args );
+
+		Py_DecRef( callback );
+	}
+}
+
+// Returns a new reference to the channel callback or nullptr if none is set
+PyObject* Channel::ChannelCallbackReference()
+{
+	ThreadLockRAII lock( s_channelCallbackLock );
+
+	Py_XINCREF( s_channelCallback );
+
+	return s_channelCallback;
+}
+
+// Channels used internally as wait queues don't report to the channel callback
+void Channel::SetChannelCallbackEnabled( bool enabled )
+{
+	m_channelCallbackEnabled = enabled;
+}
+
+void Channel::AddTaskletToWaitingToSend( Tasklet* tasklet )
+{
+    if( m_lastBlockedOnSend == nullptr )
+    {
 		m_lastBlockedOnSend = tasklet;
 		m_firstBlockedOnSend = tasklet;
     }
 	else
 	{
-		m_lastBlockedOnSend->SetPreviousBlocked( tasklet );
-		tasklet->SetNextBlocked( m_lastBlockedOnSend );
-		m_lastBlockedOnSend = tasklet;
-    }
-
-    tasklet->SetBlockedDirection( ChannelDirection::SENDER );
-    IncrementBalance();
+		m_lastBlockedOnSend->SetPreviousBlocked( tasklet );
+		tasklet->SetNextBlocked( m_lastBlockedOnSend );
+		m_lastBlockedOnSend = tasklet;
+    }
+
+    tasklet->SetBlockedDirection( ChannelDirection::SENDER );
+    tasklet->SetBlockedSequence( m_nextWaiterSequence++ );
+    IncrementBalance();
+}
+
+void Channel::AddTaskletToWaitingToReceive( Tasklet* tasklet )
+{
+	if( m_lastBlockedOnReceive == nullptr )
+    {
+		m_lastBlockedOnReceive = tasklet;
+        m_firstBlockedOnReceive = tasklet;
+    }
+    else
+    {
+		m_lastBlockedOnReceive->SetPreviousBlocked( tasklet );
+		tasklet->SetNextBlocked( m_lastBlockedOnReceive );
+		m_lastBlockedOnReceive = tasklet;
+    }
+
+    tasklet->SetBlockedDirection( ChannelDirection::RECEIVER );
+    tasklet->SetBlockedSequence( m_nextWaiterSequence++ );
+    DecrementBalance();
+}
+
+// Must be called holding m_lock, returns nullptr if nothing is waiting to send
+// Plain senders and select cases are served in the order they started waiting
+Tasklet* Channel::PopNextTaskletBlockedOnSend()
+{
+	if( m_numberOfSelectCases > 0 )
+	{
+		ThreadLockRAII selectLock( s_selectLock );
+
+		if( m_firstSelectOnSend != nullptr && ( m_firstBlockedOnSend == nullptr || m_firstSelectOnSend->m_sequence < m_firstBlockedOnSend->BlockedSequence() ) )
+		{
+			return CompleteSelectCase( m_firstSelectOnSend );
+		}
+	}
+
+	Tasklet* next = m_firstBlockedOnSend;
+
+    if( next != nullptr )
+    {
+		RemoveTaskletFromBlocked( next );
+    }
+
+    return next;
+}
+
+// Must be called holding m_lock, returns nullptr if nothing is waiting to receive
+// Plain receivers and select cases are served in the order they started waiting
+Tasklet* Channel::PopNextTaskletBlockedOnReceive()
+{
+	if( m_numberOfSelectCases > 0 )
+	{
+		ThreadLockRAII selectLock( s_selectLock );
+
+		if( m_firstSelectOnReceive != nullptr && ( m_firstBlockedOnReceive == nullptr || m_firstSelectOnReceive->m_sequence < m_firstBlockedOnReceive->BlockedSequence() ) )
+		{
+			return CompleteSelectCase( m_firstSelectOnReceive );
+		}
+	}
+
+	Tasklet* next = m_firstBlockedOnReceive;
+
+    if( next != nullptr )
+    {
+		RemoveTaskletFromBlocked( next );
+    }
+
+    return next;
+}
+
+PyObject* Channel::ChannelCallback()
+{
+	return s_channelCallback;
+}
+
+void Channel::SetChannelCallback( PyObject* callback )
+{
+	PyObject* previousCallback = nullptr;
+
+	{
+		ThreadLockRAII lock( s_channelCallbackLock );
+
+		previousCallback = s_channelCallback;
+
+		s_channelCallback = callback;
+	}
+
+	// Released outside the lock as it may run arbitrary code
+	Py_XDECREF( previousCallback );
+}
+
+int Channel::PreferenceAsInt() const
+{
+	return DirectionToInt( m_preference );
+}
+
+void Channel::SetPreferenceFromInt( int value )
+{
+	m_preference = DirectionFromInt( value );
+}
+
+// The waiter the next transfer would be served to, receivers before senders
+// Plain waiters and select cases are compared in the order PopNextTaskletBlockedOnReceive and PopNextTaskletBlockedOnSend serve them
+Tasklet* Channel::BlockedQueueFront() const
+{
+	ThreadLockRAII lock( m_lock );
+
+	ThreadLockRAII selectLock( s_selectLock );
+
+	if( m_firstBlockedOnReceive != nullptr || m_firstSelectOnReceive != nullptr )
+	{
+		if( m_firstSelectOnReceive != nullptr && ( m_firstBlockedOnReceive == nullptr || m_firstSelectOnReceive->m_sequence < m_firstBlockedOnReceive->BlockedSequence() ) )
+		{
+			return m_firstSelectOnReceive->m_tasklet;
+		}
+
+		return m_firstBlockedOnReceive;
+	}
+
+	if( m_firstSelectOnSend != nullptr && ( m_firstBlockedOnSend == nullptr || m_firstSelectOnSend->m_sequence < m_firstBlockedOnSend->BlockedSequence() ) )
+	{
+		return m_firstSelectOnSend->m_tasklet;
+	}
+
+	return m_firstBlockedOnSend;
+}
+
+void Channel::ClearBlocked( bool pending )
+{
+	// Kill all blocked tasklets, receivers first then senders, each in the order they started waiting
+	while( Tasklet* tasklet = BlockedQueueFront() )
+	{
+		tasklet->Kill( pending );
+	}
+
+}
+
+long Channel::NumberOfActiveChannels()
+{
+	ThreadLockRAII lock( s_activeChannelsLock );
+
+	return static_cast<long>(s_activeChannels.size());
+}
+
+int Channel::UnblockAllActiveChannels()
+{
+	int numberOfChannelsUnblocked = 0;
+
+	std::vector<Channel*> channelsToUnblock;
+
+	{
+		ThreadLockRAII lock( s_activeChannelsLock );
+
+		auto iter = s_activeChannels.begin();
+
+		while(iter != s_activeChannels.end())
+		{
+			Channel* channel = *iter;
+			if (channel->m_balance != 0)
+			{
+				channelsToUnblock.push_back(channel);
+			}
+			iter++;
+		}
+	}
+
+	for (auto chan : channelsToUnblock)
+	{
+		numberOfChannelsUnblocked++;
+
+		chan->ClearBlocked( false );
+	}
+
+    return numberOfChannelsUnblocked;
+}
+
+void Channel::Close()
+{
+	m_closing = true;
+
+    UpdateCloseState();
+}
+
+void Channel::Open()
+{
+	m_closing = false;
+
+	m_closed = false;
+}
+
+bool Channel::IsClosed() const
+{
+	return m_closed;
+}
+
+bool Channel::IsClosing() const
+{
+	return m_closing;
+}
+
+void Channel::IncrementBalance()
+{
+	m_balance++;
+}
+
+void Channel::DecrementBalance()
+{
+	m_balance--;
+}
+
+void Channel::UpdateCloseState()
+{
+    // If channel is set to close and the balance is zero then set as closed
+
+	if((m_closing) && ( m_balance == 0 ))
+	{
+
+		m_closed = true;
+
+	}
+}
+
+int Channel::DirectionToInt( ChannelDirection preference ) const
+{
+    switch (preference)
+	{
+	
+        case ChannelDirection::RECEIVER:
+		    return -1;
+
+        case ChannelDirection::NEITHER:
+            return 0;
+
+        case ChannelDirection::SENDER:
+			return 1;
+
+        default:
+			return -1;
+
+    }
+}
+
+ChannelDirection Channel::DirectionFromInt( int preference ) const
+{
+	switch( preference )
+	{
+        case -1: 
+	        return ChannelDirection::RECEIVER;
+
+        case 0:
+			return ChannelDirection::NEITHER;
+
+        case 1:
+			return ChannelDirection::SENDER;
+
+        default:
+			return ChannelDirection::RECEIVER;
+	}
+}
+
+ChannelDirection Channel::InvertDirection( ChannelDirection direction ) const
+{
+	switch( direction )
+	{
+	case ChannelDirection::RECEIVER:
+		return ChannelDirection::SENDER;
+
+	case ChannelDirection::SENDER:
+		return ChannelDirection::RECEIVER;
+
+	case ChannelDirection::NEITHER:
+		return ChannelDirection::NEITHER;
+
+    default:
+		return ChannelDirection::NEITHER;
+	}
+}
+bool Channel::HasWaitingReceiver() const
+{
+	return m_firstBlockedOnReceive != nullptr || m_firstSelectOnReceive != nullptr;
+}
+
+bool Channel::HasWaitingSender() const
+{
+	return m_firstBlockedOnSend != nullptr || m_firstSelectOnSend != nullptr;
+}
+
+// Index of the first case with a waiting counterpart or -1, call holding the lock of every case channel
+// Plain waiters cannot leave while the channel locks are held, select cases can until s_selectLock is released
+int Channel::ReadySelectCase( const std::vector<SelectCase>& cases )
+{
+	ThreadLockRAII selectLock( s_selectLock );
+
+	for( size_t i = 0; i < cases.size(); i++ )
+	{
+		const SelectCase& selectCase = cases[i];
+
+		if( selectCase.m_direction == ChannelDirection::RECEIVER ? selectCase.m_channel->HasWaitingSender() : selectCase.m_channel->HasWaitingReceiver() )
+		{
+			return static_cast<int>( i );
+		}
+	}
+
+	return -1;
+}
+
+void Channel::UnlockChannels( const std::vector<Channel*>& channels )
+{
+	for( Channel* channel : channels )
+	{
+		channel->m_lock.Unlock();
+	}
+}
+
+// Whether the front plain sender is waiting to raise an exception, call holding m_lock
+bool Channel::WaitingSenderSentException() const
+{
+	return m_firstBlockedOnSend != nullptr && m_firstBlockedOnSend->TransferException() != nullptr;
+}
+
+void Channel::AddSelectCase( SelectCase* selectCase )
+{
+	bool receiving = selectCase->m_direction == ChannelDirection::RECEIVER;
+
+	SelectCase*& first = receiving ? m_firstSelectOnReceive : m_firstSelectOnSend;
+
+	SelectCase*& last = receiving ? m_lastSelectOnReceive : m_lastSelectOnSend;
+
+	selectCase->m_previousWaiting = last;
+
+	selectCase->m_nextWaiting = nullptr;
+
+	if( last == nullptr )
+	{
+		first = selectCase;
+	}
+	else
+	{
+		last->m_nextWaiting = selectCase;
+	}
+
+	last = selectCase;
+
+	selectCase->m_sequence = m_nextWaiterSequence++;
+
+	selectCase->m_waiting = true;
+
+	m_numberOfSelectCases++;
+
+	if( receiving )
+	{
+		DecrementBalance();
+	}
+	else
+	{
+		IncrementBalance();
+	}
+}
+
+void Channel::RemoveSelectCase( SelectCase* selectCase )
+{
+	if( !selectCase->m_waiting )
+	{
+		return;
+	}
+
+	bool receiving = selectCase->m_direction == ChannelDirection::RECEIVER;
+
+	SelectCase*& first = receiving ? m_firstSelectOnReceive : m_firstSelectOnSend;
+
+	SelectCase*& last = receiving ? m_lastSelectOnReceive : m_lastSelectOnSend;
+
+	if( selectCase->m_previousWaiting )
+	{
+		selectCase->m_previousWaiting->m_nextWaiting = selectCase->m_nextWaiting;
+	}
+	else
+	{
+		first = selectCase->m_nextWaiting;
+	}
+
+	if( selectCase->m_nextWaiting )
+	{
+		selectCase->m_nextWaiting->m_previousWaiting = selectCase->m_previousWaiting;
+	}
+	else
+	{
+		last = selectCase->m_previousWaiting;
+	}
+
+	selectCase->m_nextWaiting = nullptr;
+
+	selectCase->m_previousWaiting = nullptr;
+
+	selectCase->m_waiting = false;
+
+	m_numberOfSelectCases--;
+
+	if( receiving )
+	{
+		IncrementBalance();
+	}
+	else
+	{
+		DecrementBalance();
+	}
 }
 
-void Channel::AddTaskletToWaitingToReceive( Tasklet* tasklet )
+// Marks the case as the one chosen by its selecting tasklet and withdraws the rest
+// The tasklet is returned in the same state as a tasklet popped from a block list
+Tasklet* Channel::CompleteSelectCase( SelectCase* selectCase )
 {
-	if( m_lastBlockedOnReceive == nullptr )
-    {
-		m_lastBlockedOnReceive = tasklet;
-        m_firstBlockedOnReceive = tasklet;
-    }
-    else
-    {
-		m_lastBlockedOnReceive->SetPreviousBlocked( tasklet );
-		tasklet->SetNextBlocked( m_lastBlockedOnReceive );
-		m_lastBlockedOnReceive = tasklet;
-    }
+	Tasklet* tasklet = selectCase->m_tasklet;
 
-    tasklet->SetBlockedDirection( ChannelDirection::RECEIVER );
-    DecrementBalance();
+	tasklet->SetSelectedCase( static_cast<int>( selectCase - tasklet->SelectCases() ) );
+
+	if( selectCase->m_direction == ChannelDirection::SENDER )
+	{
+		tasklet->SetTransferArguments( selectCase->m_value, nullptr, false );
+	}
+
+	WithdrawSelectCases( tasklet );
+
+	return tasklet;
 }
 
-Tasklet* Channel::PopNextTaskletBlockedOnSend()
+void Channel::CancelSelect( Tasklet* tasklet )
 {
-	Tasklet* next = nullptr;
-    if (m_firstBlockedOnSend != nullptr)
-    {
-		next = m_firstBlockedOnSend;
+	ThreadLockRAII selectLock( s_selectLock );
 
-		RemoveTaskletFromBlocked( next );
-    }
-	
-    return next;
+	WithdrawSelectCases( tasklet );
 }
 
-Tasklet* Channel::PopNextTaskletBlockedOnReceive()
+// Withdraw the cases of a select whose wait timed out
+// Returns false if another thread completed one of the cases first, that thread then wakes the Tasklet
+bool Channel::WithdrawTimedOutSelect( Tasklet* tasklet )
 {
-	Tasklet* next = nullptr;
-    if (m_firstBlockedOnReceive != nullptr)
-    {
-		next = m_firstBlockedOnReceive;
+	ThreadLockRAII selectLock( s_selectLock );
 
-		RemoveTaskletFromBlocked( next );
-    }
+	SelectCase* cases = tasklet->SelectCases();
 
-    return next;
-}
+	for( size_t i = 0; i < tasklet->NumberOfSelectCases(); i++ )
+	{
+		if( cases[i].m_waiting )
+		{
+			WithdrawSelectCases( tasklet );
 
-PyObject* Channel::ChannelCallback()
-{
-	return s_channelCallback;
+			return true;
+		}
+	}
+
+	return false;
 }
 
-void Channel::SetChannelCallback( PyObject* callback )
+// Must be called holding s_selectLock
+void Channel::WithdrawSelectCases( Tasklet* tasklet )
 {
-	Py_XDECREF( s_channelCallback ); 
+	SelectCase* cases = tasklet->SelectCases();
 
-    s_channelCallback = callback;
-}
+	for( size_t i = 0; i < tasklet->NumberOfSelectCases(); i++ )
+	{
+		if( cases[i].m_waiting )
+		{
+			cases[i].m_channel->RemoveSelectCase( &cases[i] );
 
-int Channel::PreferenceAsInt() const
-{
-	return DirectionToInt( m_preference );
+			cases[i].m_channel->UpdateCloseState();
+		}
+	}
 }
 
-void Channel::SetPreferenceFromInt( int value )
+// Wait on multiple channel operations, completing exactly one of them
+// Cases are tried in order, if none can proceed the current tasklet blocks on all of them
+// timeout is in nanoseconds, 0 polls without blocking and a negative value waits indefinitely
+// On return selectedIndex is the completed case or -1 if the timeout expired
+// Reaching the cancel scope deadline of the current tasklet raises TimeoutError instead
+bool Channel::Select( std::vector<SelectCase>& cases, long long timeout, int& selectedIndex, PyObject*& received )
 {
-	m_preference = DirectionFromInt( value );
-}
+	selectedIndex = -1;
 
-Tasklet* Channel::BlockedQueueFront() const
-{
-	if( m_firstBlockedOnReceive != nullptr )
-    {
-		return m_firstBlockedOnReceive;
-    }
-    else if (m_firstBlockedOnSend != nullptr)
-    {
-		return m_firstBlockedOnSend;
-    }
-	return nullptr;
-}
+	received = nullptr;
 
-void Channel::ClearBlocked( bool pending )
-{
-	// Kill all blocked tasklets
-	while( m_firstBlockedOnReceive )
+	ScheduleManager* scheduleManager = ScheduleManager::GetThreadScheduleManager();
+
+	Tasklet* current = scheduleManager->GetCurrentTasklet();
+
+	if( current == nullptr )
 	{
-		m_firstBlockedOnReceive->Kill( pending );
+		PyErr_SetString( PyExc_RuntimeError, "No current tasklet set" );
+
+		return false;
 	}
 
-	while( m_firstBlockedOnSend )
+	bool cancelScoped = !cases.empty() && scheduleManager->ApplyCancelDeadline( current, timeout );
+
+	// Lock every channel in address order so completing a ready case or blocking on all of them is a single step
+	std::vector<Channel*> channels;
+
+	for( SelectCase& selectCase : cases )
 	{
-		m_firstBlockedOnSend->Kill( pending );
+		channels.push_back( selectCase.m_channel );
 	}
 
-}
+	std::sort( channels.begin(), channels.end() );
 
-long Channel::NumberOfActiveChannels()
-{
-	return static_cast<long>(s_activeChannels.size());
-}
+	channels.erase( std::unique( channels.begin(), channels.end() ), channels.end() );
 
-int Channel::UnblockAllActiveChannels()
-{
-	int numberOfChannelsUnblocked = 0;
+	bool callbacksRun = false;
 
-	auto iter = s_activeChannels.begin();
+	for( ;; )
+	{
+		for( Channel* channel : channels )
+		{
+			channel->m_lock.Lock();
+		}
 
-	std::vector<Channel*> channelsToUnblock;
+		// Complete the first case that has a waiting counterpart
+		int readyIndex = ReadySelectCase( cases );
 
-	while(iter != s_activeChannels.end())
-	{
-		Channel* channel = *iter;
-		if (channel->m_balance != 0)
+		if( readyIndex >= 0 )
 		{
-			channelsToUnblock.push_back(channel);
+			SelectCase& selectCase = cases[readyIndex];
+
+			Channel* channel = selectCase.m_channel;
+
+			bool receiving = selectCase.m_direction == ChannelDirection::RECEIVER;
+
+			Tasklet* counterpart = receiving ? channel->PopNextTaskletBlockedOnSend() : channel->PopNextTaskletBlockedOnReceive();
+
+			if( counterpart != nullptr )
+			{
+				current->SetTransferInProgress( true );
+
+				if( receiving )
+				{
+					channel->TakeSenderTransfer( counterpart, current );
+				}
+				else
+				{
+					counterpart->Unblock();
+
+					counterpart->SetTransferArguments( selectCase.m_value, nullptr, false );
+				}
+			}
+
+			UnlockChannels( channels );
+
+			if( counterpart == nullptr )
+			{
+				// A select case on another thread completed first, check again
+				continue;
+			}
+
+			selectedIndex = readyIndex;
+
+			channel->RunChannelCallback( channel, current, !receiving, false );
+
+			if( !receiving )
+			{
+				if( !channel->ResumeReceiver( counterpart ) )
+				{
+					return false;
+				}
+
+				current->SetTransferInProgress( false );
+
+				channel->UpdateCloseState();
+
+				return true;
+			}
+
+			if( !channel->ResumeSender( counterpart, current ) )
+			{
+				return false;
+			}
+
+			received = channel->ProcessReceivedTransfer( current );
+
+			return received != nullptr;
 		}
-		iter++;
-	}
 
-	for (auto chan : channelsToUnblock)
-	{
-		numberOfChannelsUnblocked++;
+		if( timeout == 0 || cases.empty() )
+		{
+			UnlockChannels( channels );
 
-		chan->ClearBlocked( false );
-	}
+			if( cancelScoped )
+			{
+				PyErr_SetString( PyExc_TimeoutError, "select operation timed out" );
 
-    return numberOfChannelsUnblocked;
-}
+				return false;
+			}
 
-void Channel::Close()
-{
-	m_closing = true;
+			return true;
+		}
 
-    UpdateCloseState();
-}
+		if( current->IsBlocktrapped() )
+		{
+			UnlockChannels( channels );
 
-void Channel::Open()
-{
-	m_closing = false;
+			PyErr_SetString( PyExc_RuntimeError, "Channel cannot block on main tasklet with block_trap set true" );
 
-	m_closed = false;
-}
+			return false;
+		}
 
-bool Channel::IsClosed() const
-{
-	return m_closed;
-}
+		bool closed = false;
 
-bool Channel::IsClosing() const
-{
-	return m_closing;
-}
+		for( SelectCase& selectCase : cases )
+		{
+			closed = closed || selectCase.m_channel->m_closed || selectCase.m_channel->m_closing;
+		}
 
-void Channel::IncrementBalance()
-{
-	m_balance++;
-}
+		if( closed )
+		{
+			UnlockChannels( channels );
 
-void Channel::DecrementBalance()
-{
-	m_balance--;
-}
+			PyErr_SetString( PyExc_ValueError, "select operation on a closed channel" );
 
-void Channel::UpdateCloseState()
-{
-    // If channel is set to close and the balance is zero then set as closed
+			return false;
+		}
 
-	if((m_closing) && ( m_balance == 0 ))
-	{
+		if( !callbacksRun )
+		{
+			// Callbacks may run arbitrary code so are run unlocked, a counterpart may arrive meanwhile
+			UnlockChannels( channels );
 
-		m_closed = true;
+			for( SelectCase& selectCase : cases )
+			{
+				selectCase.m_channel->RunChannelCallback( selectCase.m_channel, current, selectCase.m_direction == ChannelDirection::SENDER, true );
+			}
+
+			callbacksRun = true;
 
+			continue;
+		}
+
+		// Block on all cases, the reference is held on behalf of the channels
+		s_selectLock.Lock();
+
+		current->Incref();
+
+		current->SetSelectCases( cases.data(), cases.size() );
+
+		current->SetSelectedCase( -1 );
+
+		current->Block( nullptr );
+
+		current->SetTransferInProgress( true );
+
+		for( SelectCase& selectCase : cases )
+		{
+			selectCase.m_tasklet = current;
+
+			selectCase.m_channel->AddSelectCase( &selectCase );
+		}
+
+		s_selectLock.Unlock();
+
+		UnlockChannels( channels );
+
+		break;
 	}
-}
 
-int Channel::DirectionToInt( ChannelDirection preference ) const
-{
-    switch (preference)
+	if( timeout > 0 )
 	{
-	
-        case ChannelDirection::RECEIVER:
-		    return -1;
+		scheduleManager->AddTimeout( current, timeout );
+	}
 
-        case ChannelDirection::NEITHER:
-            return 0;
+	bool success = scheduleManager->Yield();
 
-        case ChannelDirection::SENDER:
-			return 1;
+	scheduleManager->RemoveTimeout( current );
 
-        default:
-			return -1;
+	CancelSelect( current );
 
-    }
-}
+	current->SetSelectCases( nullptr, 0 );
 
-ChannelDirection Channel::DirectionFromInt( int preference ) const
-{
-	switch( preference )
+	selectedIndex = current->SelectedCase();
+
+	current->SetSelectedCase( -1 );
+
+	current->SetTimedOut( false );
+
+	current->SetTransferInProgress( false );
+
+	if( !success )
 	{
-        case -1: 
-	        return ChannelDirection::RECEIVER;
+		current->Unblock();
 
-        case 0:
-			return ChannelDirection::NEITHER;
+		PyObject* transferArguments = current->GetTransferArguments();
 
-        case 1:
-			return ChannelDirection::SENDER;
+		if( transferArguments )
+		{
+			// A receive case completed before the error was raised
+			Py_DecRef( transferArguments );
 
-        default:
-			return ChannelDirection::RECEIVER;
+			current->ClearTransferArguments();
+		}
+
+		if( selectedIndex < 0 )
+		{
+			// No case completed so the reference still belongs to the channels
+			current->Decref();
+		}
+
+		selectedIndex = -1;
+
+		return false;
 	}
-}
 
-ChannelDirection Channel::InvertDirection( ChannelDirection direction ) const
-{
-	switch( direction )
+	if( selectedIndex < 0 )
 	{
-	case ChannelDirection::RECEIVER:
-		return ChannelDirection::SENDER;
+		// Timed out
+		current->Decref();
 
-	case ChannelDirection::SENDER:
-		return ChannelDirection::RECEIVER;
+		if( cancelScoped )
+		{
+			PyErr_SetString( PyExc_TimeoutError, "select operation timed out" );
 
-	case ChannelDirection::NEITHER:
-		return ChannelDirection::NEITHER;
+			return false;
+		}
 
-    default:
-		return ChannelDirection::NEITHER;
+		return true;
+	}
+
+	if( cases[selectedIndex].m_direction == ChannelDirection::RECEIVER )
+	{
+		received = cases[selectedIndex].m_channel->ProcessReceivedTransfer( current );
+
+		if( received == nullptr )
+		{
+			selectedIndex = -1;
+
+			return false;
+		}
 	}
-}
\ No newline at end of file
+
+	return true;
+}
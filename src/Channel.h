@@ -22,8 +22,11 @@
 #include "stdafx.h"
 
 #include "PythonCppType.h"
+#include "ThreadLock.h"
 
+#include <atomic>
 #include <unordered_set>
+#include <vector>
 
 enum class ChannelDirection
 {
@@ -36,6 +39,30 @@ typedef ChannelDirection ChannelPreference;
 
 class Tasklet;
 
+class Channel;
+
+// A single operation of a select call
+// While the selecting Tasklet is blocked each case is linked into
+// the select waiting list of its Channel
+struct SelectCase
+{
+	Channel* m_channel = nullptr;
+
+	ChannelDirection m_direction = ChannelDirection::NEITHER; // RECEIVER for receive, SENDER for send
+
+	PyObject* m_value = nullptr; // Weak ref, value to send
+
+	Tasklet* m_tasklet = nullptr; // Weak ref, selecting tasklet
+
+	SelectCase* m_nextWaiting = nullptr;
+
+	SelectCase* m_previousWaiting = nullptr;
+
+	unsigned long long m_sequence = 0; // Order the case started waiting on its channel
+
+	bool m_waiting = false;
+};
+
 class Channel : public PythonCppType
 {
 public:
@@ -44,14 +71,22 @@ public:
 
     ~Channel();
 
-	bool Send( PyObject * args, PyObject* exception = nullptr, bool restoreException = false );
+	bool Send( PyObject * args, PyObject* exception = nullptr, bool restoreException = false, long long timeout = -1 );
 
-    PyObject* Receive();
+    PyObject* Receive( long long timeout = -1 );
+
+    bool SendMany( PyObject* const* items, Py_ssize_t numberOfItems );
+
+    PyObject* ReceiveMany( Py_ssize_t maxItems );
+
+    int Broadcast( PyObject* args );
 
     int Balance() const;
 
     void UnblockTaskletFromChannel( Tasklet* tasklet );
 
+    bool WithdrawTimedOutTasklet( Tasklet* tasklet );
+
     static PyObject* ChannelCallback();
 
     static void SetChannelCallback(PyObject* callback);
@@ -76,8 +111,42 @@ public:
 
     static int UnblockAllActiveChannels();
 
+    static bool Select( std::vector<SelectCase>& cases, long long timeout, int& selectedIndex, PyObject*& received );
+
+    void SetChannelCallbackEnabled( bool enabled );
+
+    static void CancelSelect( Tasklet* tasklet );
+
+    static bool WithdrawTimedOutSelect( Tasklet* tasklet );
+
 private:
 
+    bool HasWaitingReceiver() const;
+
+    bool HasWaitingSender() const;
+
+    bool WaitingSenderSentException() const;
+
+    void AddSelectCase( SelectCase* selectCase );
+
+	void RemoveSelectCase( SelectCase* selectCase );
+
+    static Tasklet* CompleteSelectCase( SelectCase* selectCase );
+
+    static void WithdrawSelectCases( Tasklet* tasklet );
+
+    static int ReadySelectCase( const std::vector<SelectCase>& cases );
+
+    static void UnlockChannels( const std::vector<Channel*>& channels );
+
+    PyObject* ProcessReceivedTransfer( Tasklet* current );
+
+    void TakeSenderTransfer( Tasklet* sendingTasklet, Tasklet* current );
+
+    bool ResumeSender( Tasklet* sendingTasklet, Tasklet* current );
+
+    bool ResumeReceiver( Tasklet* receivingTasklet );
+
     void RemoveTaskletFromBlocked( Tasklet* tasklet );
 
     void IncrementBalance();
@@ -86,6 +155,8 @@ private:
 
     void RunChannelCallback( Channel* channel, Tasklet* tasklet, bool sending, bool willBlock ) const;
 
+    static PyObject* ChannelCallbackReference();
+
     void AddTaskletToWaitingToSend( Tasklet* tasklet );
 
     void AddTaskletToWaitingToReceive( Tasklet* tasklet );
@@ -106,16 +177,22 @@ private:
 
 private:
 
-    int m_balance;
+    // Guards the block lists, select case lists are guarded by s_selectLock
+    // Only one channel lock may be held at a time unless s_selectLock is held
+    mutable ThreadLock m_lock;
+
+    std::atomic<int> m_balance;
 
 	ChannelPreference m_preference;
 
-    bool m_closing;
+    std::atomic<bool> m_closing;
 
-    bool m_closed;
+    std::atomic<bool> m_closed;
 
     inline static PyObject* s_channelCallback = nullptr; // This is global, not per channel
 
+    inline static ThreadLock s_channelCallbackLock;
+
     Tasklet* m_firstBlockedOnReceive;
 
 	Tasklet* m_lastBlockedOnReceive;
@@ -124,7 +201,29 @@ private:
 
     Tasklet* m_lastBlockedOnSend;
 
+    bool m_channelCallbackEnabled;
+
+    SelectCase* m_firstSelectOnReceive;
+
+	SelectCase* m_lastSelectOnReceive;
+
+	SelectCase* m_firstSelectOnSend;
+
+	SelectCase* m_lastSelectOnSend;
+
+    // Only increased while holding m_lock, a count of zero read under m_lock stays zero until it is released
+    std::atomic<int> m_numberOfSelectCases;
+
+    // Stamped on blocked Tasklets and select cases as they start waiting, guarded by m_lock
+    // Plain waiters and select cases are served in stamp order
+    unsigned long long m_nextWaiterSequence;
+
+    // Acquired after any channel locks
+    inline static ThreadLock s_selectLock;
+
     inline static std::unordered_set<Channel*> s_activeChannels;
+
+    inline static ThreadLock s_activeChannelsLock;
 };
 
 #endif // Channel_H
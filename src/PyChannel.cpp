@@ -238,7 +238,7 @@ static PyGetSetDef Channel_getsetters[] = {
 };
 
 static PyObject*
-	ChannelSend( PyChannelObject* self, PyObject* args, PyObject* Py_UNUSED( kwds ) )
+	ChannelSend( PyChannelObject* self, PyObject* args, PyObject* kwds )
 {
 	// Ensure PyChannelObject is in a valid state
 	if( !PyChannelObjectIsValid( self ) )
@@ -246,14 +246,25 @@ static PyObject*
 		return nullptr;
 	}
 
+	const char* kwlist[] = { "value", "timeout", NULL };
+
 	PyObject* value;
 
-	if( !PyArg_ParseTuple( args, "O:Channel.send", &value ) )
+	PyObject* timeoutArgument = Py_None;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "O|O:Channel.send", (char**)kwlist, &value, &timeoutArgument ) )
+	{
+		return nullptr;
+	}
+
+	long long timeout;
+
+	if( !TimeoutFromPyObject( timeoutArgument, timeout ) )
 	{
 		return nullptr;
 	}
 
-	if( !self->m_implementation->Send( value ) )
+	if( !self->m_implementation->Send( value, nullptr, false, timeout ) )
 	{
 		return nullptr;
 	}
@@ -264,7 +275,7 @@ static PyObject*
 }
 
 static PyObject*
-	ChannelReceive( PyChannelObject* self, PyObject* Py_UNUSED( ignored ) )
+	ChannelReceive( PyChannelObject* self, PyObject* args, PyObject* kwds )
 {
 	// Ensure PyChannelObject is in a valid state
 	if( !PyChannelObjectIsValid( self ) )
@@ -272,7 +283,141 @@ static PyObject*
 		return nullptr;
 	}
 
-	return self->m_implementation->Receive();
+	long long timeout = -1;
+
+	// Skip argument parsing for the common receive() call
+	if( PyTuple_GET_SIZE( args ) > 0 || kwds )
+	{
+		const char* kwlist[] = { "timeout", NULL };
+
+		PyObject* timeoutArgument = Py_None;
+
+		if( !PyArg_ParseTupleAndKeywords( args, kwds, "|O:Channel.receive", (char**)kwlist, &timeoutArgument ) )
+		{
+			return nullptr;
+		}
+
+		if( !TimeoutFromPyObject( timeoutArgument, timeout ) )
+		{
+			return nullptr;
+		}
+	}
+
+	return self->m_implementation->Receive( timeout );
+}
+
+static PyObject*
+	ChannelSendMany( PyChannelObject* self, PyObject* args, PyObject* Py_UNUSED( kwds ) )
+{
+	// Ensure PyChannelObject is in a valid state
+	if( !PyChannelObjectIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	PyObject* values;
+
+	if( !PyArg_ParseTuple( args, "O:Channel.send_many", &values ) )
+	{
+		return nullptr;
+	}
+
+	// Tuple keeps the values alive and unchanged while the send blocks
+	PyObject* items = PySequence_Tuple( values );
+
+	if( !items )
+	{
+		return nullptr;
+	}
+
+	bool result = self->m_implementation->SendMany( PySequence_Fast_ITEMS( items ), PyTuple_GET_SIZE( items ) );
+
+	Py_DecRef( items );
+
+	if( !result )
+	{
+		return nullptr;
+	}
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyObject*
+	ChannelReceiveMany( PyChannelObject* self, PyObject* args, PyObject* Py_UNUSED( kwds ) )
+{
+	// Ensure PyChannelObject is in a valid state
+	if( !PyChannelObjectIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	Py_ssize_t maxItems;
+
+	if( !PyArg_ParseTuple( args, "n:Channel.receive_many", &maxItems ) )
+	{
+		return nullptr;
+	}
+
+	if( maxItems < 1 )
+	{
+		PyErr_SetString( PyExc_ValueError, "max_n must be at least 1" );
+
+		return nullptr;
+	}
+
+	return self->m_implementation->ReceiveMany( maxItems );
+}
+
+static PyObject*
+	ChannelBroadcast( PyChannelObject* self, PyObject* args, PyObject* Py_UNUSED( kwds ) )
+{
+	// Ensure PyChannelObject is in a valid state
+	if( !PyChannelObjectIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	PyObject* value;
+
+	if( !PyArg_ParseTuple( args, "O:Channel.broadcast", &value ) )
+	{
+		return nullptr;
+	}
+
+	int numberOfReceivers = self->m_implementation->Broadcast( value );
+
+	if( numberOfReceivers < 0 )
+	{
+		return nullptr;
+	}
+
+	return PyLong_FromLong( numberOfReceivers );
+}
+
+// Awaitable receive for asyncio coroutines, implemented by the scheduler.asyncio_bridge module
+static PyObject*
+	ChannelReceiveAsync( PyChannelObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	// Ensure PyChannelObject is in a valid state
+	if( !PyChannelObjectIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	PyObject* bridgeModule = PyImport_ImportModule( "scheduler.asyncio_bridge" );
+
+	if( !bridgeModule )
+	{
+		return nullptr;
+	}
+
+	PyObject* ret = PyObject_CallMethod( bridgeModule, "receive_async", "O", reinterpret_cast<PyObject*>( self ) );
+
+	Py_DecRef( bridgeModule );
+
+	return ret;
 }
 
 static PyObject*
@@ -409,7 +554,7 @@ static PyObject*
 		return nullptr;
     }
 
-	PyObject* ret = ChannelReceive( self, nullptr );
+	PyObject* ret = self->m_implementation->Receive();
 
     if (!ret)
     {
@@ -472,17 +617,55 @@ static PyObject*
 static PyMethodDef Channel_methods[] = {
 	{ "send",
         (PyCFunction)ChannelSend,
-        METH_VARARGS,
+        METH_VARARGS | METH_KEYWORDS,
         "Send an object over the channel. \n\n\
             :param value: Value to send \n\
-            :type value: Object" },
+            :type value: Object \n\
+            :param timeout: Seconds to wait for a receiver, None waits indefinitely \n\
+            :type timeout: Float \n\
+            :raises TimeoutError: If no receiver arrived in time" },
 
 	{ "receive",
         (PyCFunction)ChannelReceive,
-        METH_NOARGS,
+        METH_VARARGS | METH_KEYWORDS,
         "Receive an object over the channel. \n\n\
+            :param timeout: Seconds to wait for a sender, None waits indefinitely \n\
+            :type timeout: Float \n\
+            :raises TimeoutError: If no sender arrived in time \n\
             :return received value" },
 
+	{ "send_many",
+        (PyCFunction)ChannelSendMany,
+        METH_VARARGS,
+        "Send each value of an iterable over the channel. \n\n\
+            Values are handed to waiting receivers in a single pass yielding at most once, remaining values block as with send. \n\n\
+            :param values: Values to send \n\
+            :type values: Iterable" },
+
+	{ "receive_many",
+        (PyCFunction)ChannelReceiveMany,
+        METH_VARARGS,
+        "Receive up to max_n objects over the channel. \n\n\
+            Blocks for the first value only if no sender is waiting, further values are taken from waiting senders in a single pass. \n\n\
+            :param max_n: Maximum number of values to receive \n\
+            :type max_n: Integer \n\
+            :return: List of received values" },
+
+	{ "receive_async",
+        (PyCFunction)ChannelReceiveAsync,
+        METH_NOARGS,
+        "Receive an object over the channel from an asyncio coroutine without blocking the event loop. \n\n\
+            :return: Awaitable resolving to the received value" },
+
+	{ "broadcast",
+        (PyCFunction)ChannelBroadcast,
+        METH_VARARGS,
+        "Send an object to every tasklet currently waiting to receive on the channel. Never blocks. \n\n\
+            :param value: Value to send \n\
+            :type value: Object \n\
+            :return: Number of receivers woken \n\
+            :rtype: Integer" },
+
 	{ "send_exception",
         (PyCFunction)ChannelSendException,
         METH_VARARGS,
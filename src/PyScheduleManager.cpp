@@ -4,6 +4,8 @@
 
 #include "PyScheduleManager.h"
 
+#include "Tasklet.h"
+
 static PyObject*
 	ScheduleManagerNew( PyTypeObject* type, PyObject* args, PyObject* kwds )
 {
@@ -80,7 +82,329 @@ static void
     Py_TYPE( self )->tp_free( (PyObject*)self );
 }
 
+static PyObject*
+	ScheduleManagerStopRunForever( PyScheduleManagerObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	self->m_implementation->StopRunForever();
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static const char* s_detachedQueueCapsuleName = "scheduler.detached_queue";
+
+// Releases the Tasklets of a detached queue that was never attached
+static void
+	DetachedQueueDestructor( PyObject* capsule )
+{
+	auto tasklets = static_cast<std::vector<Tasklet*>*>( PyCapsule_GetPointer( capsule, s_detachedQueueCapsuleName ) );
+
+	if( !tasklets )
+	{
+		PyErr_Clear();
+
+		return;
+	}
+
+	for( Tasklet* tasklet : *tasklets )
+	{
+		tasklet->Decref();
+	}
+
+	delete tasklets;
+}
+
+static PyObject*
+	ScheduleManagerDetachQueue( PyScheduleManagerObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	auto tasklets = new std::vector<Tasklet*>();
+
+	if( !self->m_implementation->DetachQueue( *tasklets ) )
+	{
+		delete tasklets;
+
+		return nullptr;
+	}
+
+	PyObject* handle = PyCapsule_New( tasklets, s_detachedQueueCapsuleName, DetachedQueueDestructor );
+
+	if( !handle )
+	{
+		// Put everything back rather than losing the queue
+		self->m_implementation->AttachQueue( *tasklets );
+
+		delete tasklets;
+	}
+
+	return handle;
+}
+
+static PyObject*
+	ScheduleManagerAttachQueue( PyScheduleManagerObject* self, PyObject* args, PyObject* kwds )
+{
+	const char* kwlist[] = { "handle", nullptr };
+
+	PyObject* handle = nullptr;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "O:attach_queue", (char**)kwlist, &handle ) )
+	{
+		return nullptr;
+	}
+
+	if( !PyCapsule_IsValid( handle, s_detachedQueueCapsuleName ) )
+	{
+		PyErr_SetString( PyExc_TypeError, "handle must be the result of detach_queue" );
+
+		return nullptr;
+	}
+
+	auto tasklets = static_cast<std::vector<Tasklet*>*>( PyCapsule_GetPointer( handle, s_detachedQueueCapsuleName ) );
+
+	// A handle can only be attached once, afterwards it is empty
+	if( !self->m_implementation->AttachQueue( *tasklets ) )
+	{
+		return nullptr;
+	}
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+// Fair share state is only touched by the owning thread while it runs the scheduler
+static bool
+	ScheduleManagerOnOwningThread( PyScheduleManagerObject* self, const char* message )
+{
+	if( self->m_implementation->ThreadId() != PyThread_get_thread_ident() )
+	{
+		PyErr_SetString( PyExc_RuntimeError, message );
+
+		return false;
+	}
+
+	return true;
+}
+
+static PyObject*
+	ScheduleManagerSetFairShare( PyScheduleManagerObject* self, PyObject* args, PyObject* kwds )
+{
+	const char* kwlist[] = { "enabled", nullptr };
+
+	int enabled = 0;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "p:set_fair_share", (char**)kwlist, &enabled ) )
+	{
+		return nullptr;
+	}
+
+	if( !ScheduleManagerOnOwningThread( self, "set_fair_share can only be called from the thread owning the schedule manager" ) )
+	{
+		return nullptr;
+	}
+
+	self->m_implementation->SetFairShare( enabled );
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyObject*
+	ScheduleManagerGetFairShare( PyScheduleManagerObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	return PyBool_FromLong( self->m_implementation->FairShare() );
+}
+
+static PyObject*
+	ScheduleManagerSetGroupWeight( PyScheduleManagerObject* self, PyObject* args, PyObject* kwds )
+{
+	const char* kwlist[] = { "group", "weight", nullptr };
+
+	const char* group = nullptr;
+
+	double weight = 1.0;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "sd:set_group_weight", (char**)kwlist, &group, &weight ) )
+	{
+		return nullptr;
+	}
+
+	if( !( weight > 0.0 ) )
+	{
+		PyErr_SetString( PyExc_ValueError, "weight must be greater than 0" );
+
+		return nullptr;
+	}
+
+	if( !ScheduleManagerOnOwningThread( self, "set_group_weight can only be called from the thread owning the schedule manager" ) )
+	{
+		return nullptr;
+	}
+
+	self->m_implementation->SetGroupWeight( group, weight );
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyObject*
+	ScheduleManagerGetGroupRunTimes( PyScheduleManagerObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	if( !ScheduleManagerOnOwningThread( self, "get_group_run_times can only be called from the thread owning the schedule manager" ) )
+	{
+		return nullptr;
+	}
+
+	PyObject* runTimes = PyDict_New();
+
+	if( !runTimes )
+	{
+		return nullptr;
+	}
+
+	for( auto& entry : self->m_implementation->FairShareQueues() )
+	{
+		if( !entry.second.m_ranLastRunWithTimeout )
+		{
+			continue;
+		}
+
+		PyObject* runTime = PyFloat_FromDouble( entry.second.m_runTimeLastRunWithTimeout / 1e9 );
+
+		if( !runTime )
+		{
+			Py_DecRef( runTimes );
+
+			return nullptr;
+		}
+
+		int result = PyDict_SetItemString( runTimes, entry.first.c_str(), runTime );
+
+		Py_DecRef( runTime );
+
+		if( result < 0 )
+		{
+			Py_DecRef( runTimes );
+
+			return nullptr;
+		}
+	}
+
+	return runTimes;
+}
+
+static PyObject*
+	ScheduleManagerSetFrameBudget( PyScheduleManagerObject* self, PyObject* args, PyObject* kwds )
+{
+	const char* kwlist[] = { "enabled", nullptr };
+
+	int enabled = 0;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "p:set_frame_budget", (char**)kwlist, &enabled ) )
+	{
+		return nullptr;
+	}
+
+	if( !ScheduleManagerOnOwningThread( self, "set_frame_budget can only be called from the thread owning the schedule manager" ) )
+	{
+		return nullptr;
+	}
+
+	self->m_implementation->SetFrameBudget( enabled );
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyObject*
+	ScheduleManagerGetFrameBudget( PyScheduleManagerObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	return PyBool_FromLong( self->m_implementation->FrameBudget() );
+}
+
+static PyObject*
+	ScheduleManagerGetFrameDebt( PyScheduleManagerObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	return PyFloat_FromDouble( self->m_implementation->FrameDebt() / 1e9 );
+}
+
+static PyObject*
+	ScheduleManagerSetAdaptiveBatching( PyScheduleManagerObject* self, PyObject* args, PyObject* kwds )
+{
+	const char* kwlist[] = { "enabled", "max_batch_size", nullptr };
+
+	int enabled = 0;
+
+	int maximumBatchSize = self->m_implementation->MaximumBatchSize();
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "p|i:set_adaptive_batching", (char**)kwlist, &enabled, &maximumBatchSize ) )
+	{
+		return nullptr;
+	}
+
+	if( maximumBatchSize < 1 )
+	{
+		PyErr_SetString( PyExc_ValueError, "max_batch_size must be at least 1" );
+
+		return nullptr;
+	}
+
+	if( !ScheduleManagerOnOwningThread( self, "set_adaptive_batching can only be called from the thread owning the schedule manager" ) )
+	{
+		return nullptr;
+	}
+
+	self->m_implementation->SetAdaptiveBatching( enabled, maximumBatchSize );
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyObject*
+	ScheduleManagerGetAdaptiveBatching( PyScheduleManagerObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	return PyBool_FromLong( self->m_implementation->AdaptiveBatching() );
+}
+
 static PyMethodDef ScheduleManager_methods[] = {
+	{ "stop_run_forever", (PyCFunction)ScheduleManagerStopRunForever, METH_NOARGS, "Stop run_forever on the thread owning this schedule manager, may be called from any thread." },
+	{ "detach_queue", (PyCFunction)ScheduleManagerDetachQueue, METH_NOARGS, "Take every tasklet out of the runnables queue, keeping their order.\n\n\
+:return: An opaque handle to pass to attach_queue" },
+	{ "attach_queue", (PyCFunction)ScheduleManagerAttachQueue, METH_VARARGS | METH_KEYWORDS, "Append the tasklets of a handle returned by detach_queue to the back of the runnables queue.\n\n\
+Only tasklets that have not started may be attached to the schedule manager of another thread.\n\n\
+:param handle: Handle returned by detach_queue" },
+	{ "set_fair_share", (PyCFunction)ScheduleManagerSetFairShare, METH_VARARGS | METH_KEYWORDS, "Share the budget of runs with a timeout between tasklet groups rather than running the queue strictly in order.\n\n\
+Groups take turns by deficit round robin, each receiving its weighted share of the timeout every round.\n\n\
+:param enabled: True to enable fair share scheduling" },
+	{ "get_fair_share", (PyCFunction)ScheduleManagerGetFairShare, METH_NOARGS, "Get whether fair share scheduling is enabled.\n\n\
+:return: True if fair share scheduling is enabled\n\
+:rtype: Bool" },
+	{ "set_group_weight", (PyCFunction)ScheduleManagerSetGroupWeight, METH_VARARGS | METH_KEYWORDS, "Set the relative share of the run budget a tasklet group receives in fair share mode, groups default to 1.\n\n\
+:param group: Name of the group, a tasklet group or context\n\
+:param weight: Relative weight, greater than 0" },
+	{ "get_group_run_times", (PyCFunction)ScheduleManagerGetGroupRunTimes, METH_NOARGS, "Get the time each tasklet group ran for during the last run with a timeout in fair share mode.\n\n\
+:return: Dictionary of group name to run time in seconds\n\
+:rtype: Dict" },
+	{ "set_frame_budget", (PyCFunction)ScheduleManagerSetFrameBudget, METH_VARARGS | METH_KEYWORDS, "Treat runs with a timeout from the main tasklet as consecutive frames.\n\n\
+Time a frame overruns its timeout is taken from the budget of the next frame, and tasklets a frame leaves queued run first in the next. In fair share mode they run first within their group.\n\n\
+:param enabled: True to enable frame budgets, changing the setting clears any debt" },
+	{ "get_frame_budget", (PyCFunction)ScheduleManagerGetFrameBudget, METH_NOARGS, "Get whether frame budgets are enabled.\n\n\
+:return: True if frame budgets are enabled\n\
+:rtype: Bool" },
+	{ "get_frame_debt", (PyCFunction)ScheduleManagerGetFrameDebt, METH_NOARGS, "Get the overrun to be taken from the budget of the next frame.\n\n\
+:return: Debt in seconds, at most one frame timeout\n\
+:rtype: Float" },
+	{ "set_adaptive_batching", (PyCFunction)ScheduleManagerSetAdaptiveBatching, METH_VARARGS | METH_KEYWORDS, "Check the timeout of a run once per batch of tasklets rather than before every tasklet.\n\n\
+Batch sizes adapt to the average cost of the tasklets run so far, so queues of many short tasklets read the clock far less often.\n\n\
+:param enabled: True to enable adaptive batching\n\
+:param max_batch_size: Largest number of tasklets run between checks, defaults to the current setting of 64" },
+	{ "get_adaptive_batching", (PyCFunction)ScheduleManagerGetAdaptiveBatching, METH_NOARGS, "Get whether adaptive batching is enabled.\n\n\
+:return: True if adaptive batching is enabled\n\
+:rtype: Bool" },
 	{ NULL } /* Sentinel */
 };
 
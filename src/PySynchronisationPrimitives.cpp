@@ -0,0 +1,1179 @@
+#include "SynchronisationPrimitives.h"
+
+#include <new>
+
+#include "Channel.h"
+#include "PyChannel.h"
+#include "PySynchronisationPrimitives.h"
+#include "PyTasklet.h"
+#include "Tasklet.h"
+#include "Utils.h"
+
+// Create the private channel a synchronisation primitive parks waiting tasklets on
+static Channel* NewWaitQueue()
+{
+	PyObject* channel = PyObject_CallNoArgs( reinterpret_cast<PyObject*>( &ChannelType ) );
+
+	if( !channel )
+	{
+		return nullptr;
+	}
+
+	return reinterpret_cast<PyChannelObject*>( channel )->m_implementation;
+}
+
+template <typename PyObjectType>
+static PyObject*
+	SynchronisationPrimitiveNew( PyTypeObject* type, PyObject* args, PyObject* kwds )
+{
+	PyObjectType* self;
+
+	self = (PyObjectType*)type->tp_alloc( type, 0 );
+
+	if( self != nullptr )
+	{
+		self->m_implementation = nullptr;
+
+		self->m_weakrefList = nullptr;
+	}
+
+	return (PyObject*)self;
+}
+
+template <typename ImplementationType, typename PyObjectType, typename... Arguments>
+static int
+	SynchronisationPrimitiveInit( PyObjectType* self, Arguments... arguments )
+{
+	if( self->m_implementation )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "Object is already initialised." );
+
+		return -1;
+	}
+
+	Channel* waitQueue = NewWaitQueue();
+
+	if( !waitQueue )
+	{
+		return -1;
+	}
+
+	// Allocate the memory for the implementation member
+	ImplementationType* implementation = (ImplementationType*)PyObject_Malloc( sizeof( ImplementationType ) );
+
+	if( !implementation )
+	{
+		waitQueue->Decref();
+
+		PyErr_SetString( PyExc_RuntimeError, "Failed to allocate memory for implementation object." );
+
+		return -1;
+	}
+
+	// Call constructor
+	try
+	{
+		new( implementation ) ImplementationType( reinterpret_cast<PyObject*>( self ), waitQueue, arguments... );
+	}
+	catch( ... )
+	{
+		PyObject_Free( implementation );
+
+		waitQueue->Decref();
+
+		PyErr_SetString( PyExc_RuntimeError, "Failed to construct implementation object." );
+
+		return -1;
+	}
+
+	self->m_implementation = implementation;
+
+	return 0;
+}
+
+template <typename ImplementationType, typename PyObjectType>
+static void
+	SynchronisationPrimitiveDealloc( PyObjectType* self )
+{
+	if( self->m_implementation )
+	{
+		// Call destructor
+		self->m_implementation->~ImplementationType();
+
+		PyObject_Free( self->m_implementation );
+	}
+
+	// Handle weakrefs
+	if( self->m_weakrefList != nullptr )
+	{
+		PyObject_ClearWeakRefs( (PyObject*)self );
+	}
+
+	Py_TYPE( self )->tp_free( (PyObject*)self );
+}
+
+template <typename PyObjectType>
+static bool SynchronisationPrimitiveIsValid( PyObjectType* self )
+{
+	if( !self->m_implementation )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "Object is not valid. Most likely cause being __init__ not called on base type." );
+
+		return false;
+	}
+
+	if( !self->m_implementation->IsOnOwningThread() )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "Synchronisation primitives can only be used from the thread that created them" );
+
+		return false;
+	}
+
+	return true;
+}
+
+// Converts the result of a wait, 1 success, 0 timeout and -1 error
+static PyObject* WaitResultToPyObject( int result )
+{
+	if( result < 0 )
+	{
+		return nullptr;
+	}
+
+	return PyBool_FromLong( result );
+}
+
+static bool ParseAcquireArguments( PyObject* args, PyObject* kwds, bool& blocking, long long& timeout )
+{
+	const char* kwlist[] = { "blocking", "timeout", NULL };
+
+	int blockingArgument = 1;
+
+	PyObject* timeoutArgument = Py_None;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "|pO:acquire", (char**)kwlist, &blockingArgument, &timeoutArgument ) )
+	{
+		return false;
+	}
+
+	blocking = blockingArgument != 0;
+
+	return TimeoutFromPyObject( timeoutArgument, timeout );
+}
+
+static bool ParseWaitArguments( PyObject* args, PyObject* kwds, long long& timeout )
+{
+	const char* kwlist[] = { "timeout", NULL };
+
+	PyObject* timeoutArgument = Py_None;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "|O:wait", (char**)kwlist, &timeoutArgument ) )
+	{
+		return false;
+	}
+
+	return TimeoutFromPyObject( timeoutArgument, timeout );
+}
+
+
+// Lock
+
+static int
+	LockInit( PyLockObject* self, PyObject* args, PyObject* kwds )
+{
+	if( !PyArg_ParseTuple( args, ":Lock" ) )
+	{
+		return -1;
+	}
+
+	return SynchronisationPrimitiveInit<Lock>( self );
+}
+
+static PyObject*
+	LockAcquire( PyLockObject* self, PyObject* args, PyObject* kwds )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	bool blocking;
+
+	long long timeout;
+
+	if( !ParseAcquireArguments( args, kwds, blocking, timeout ) )
+	{
+		return nullptr;
+	}
+
+	return WaitResultToPyObject( self->m_implementation->Acquire( blocking, timeout ) );
+}
+
+static PyObject*
+	LockRelease( PyLockObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	if( !self->m_implementation->Release() )
+	{
+		return nullptr;
+	}
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyObject*
+	LockLocked( PyLockObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	return PyBool_FromLong( self->m_implementation->IsLocked() );
+}
+
+static PyObject*
+	LockEnter( PyLockObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	return WaitResultToPyObject( self->m_implementation->Acquire( true, -1 ) );
+}
+
+static PyObject*
+	LockExit( PyLockObject* self, PyObject* Py_UNUSED( args ) )
+{
+	return LockRelease( self, nullptr );
+}
+
+static PyMethodDef Lock_methods[] = {
+	{ "acquire",
+		(PyCFunction)LockAcquire,
+		METH_VARARGS | METH_KEYWORDS,
+		"Acquire the lock, blocking the current tasklet while it is held elsewhere. \n\n\
+			:param blocking: If False return immediately when the lock is held \n\
+			:type blocking: Boolean \n\
+			:param timeout: Maximum time to wait in seconds, None waits indefinitely \n\
+			:type timeout: Float or None \n\
+			:return: True if the lock was acquired \n\
+			:rtype: Boolean" },
+
+	{ "release",
+		(PyCFunction)LockRelease,
+		METH_NOARGS,
+		"Release the lock. If tasklets are waiting ownership passes directly to the longest waiting one without switching." },
+
+	{ "locked",
+		(PyCFunction)LockLocked,
+		METH_NOARGS,
+		"Query if the lock is held. \n\n\
+			:return: True if the lock is held \n\
+			:rtype: Boolean" },
+
+	{ "__enter__",
+		(PyCFunction)LockEnter,
+		METH_NOARGS,
+		"Acquire the lock." },
+
+	{ "__exit__",
+		(PyCFunction)LockExit,
+		METH_VARARGS,
+		"Release the lock." },
+
+	{ NULL } /* Sentinel */
+};
+
+static PyTypeObject LockType = {
+	PyVarObject_HEAD_INIT( NULL, 0 ) "scheduler.Lock", /*tp_name*/
+	sizeof( PyLockObject ), /*tp_basicsize*/
+	0, /*tp_itemsize*/
+	/* methods */
+	(destructor)SynchronisationPrimitiveDealloc<Lock, PyLockObject>, /*tp_dealloc*/
+	0, /*tp_vectorcall_offset*/
+	0, /*tp_getattr*/
+	0, /*tp_setattr*/
+	0, /*tp_as_async*/
+	0, /*tp_repr*/
+	0, /*tp_as_number*/
+	0, /*tp_as_sequence*/
+	0, /*tp_as_mapping*/
+	0, /*tp_hash*/
+	0, /*tp_call*/
+	0, /*tp_str*/
+	0, /*tp_getattro*/
+	0, /*tp_setattro*/
+	0, /*tp_as_buffer*/
+	Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+	PyDoc_STR( "Lock objects" ), /*tp_doc*/
+	0, /*tp_traverse*/
+	0, /*tp_clear*/
+	0, /*tp_richcompare*/
+	offsetof( PyLockObject, m_weakrefList ), /*tp_weaklistoffset*/
+	0, /*tp_iter*/
+	0, /*tp_iternext*/
+	Lock_methods, /*tp_methods*/
+	0, /*tp_members*/
+	0, /*tp_getset*/
+	0, /*tp_base*/
+	0, /*tp_dict*/
+	0, /*tp_descr_get*/
+	0, /*tp_descr_set*/
+	0, /*tp_dictoffset*/
+	(initproc)LockInit, /*tp_init*/
+	0, /*tp_alloc*/
+	SynchronisationPrimitiveNew<PyLockObject>, /*tp_new*/
+	0, /*tp_free*/
+	0, /*tp_is_gc*/
+};
+
+
+// Semaphore
+
+static int
+	SemaphoreInit( PySemaphoreObject* self, PyObject* args, PyObject* kwds )
+{
+	const char* kwlist[] = { "value", NULL };
+
+	long value = 1;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "|l:Semaphore", (char**)kwlist, &value ) )
+	{
+		return -1;
+	}
+
+	if( value < 0 )
+	{
+		PyErr_SetString( PyExc_ValueError, "semaphore initial value must be >= 0" );
+
+		return -1;
+	}
+
+	return SynchronisationPrimitiveInit<Semaphore>( self, value );
+}
+
+static PyObject*
+	SemaphoreAcquire( PySemaphoreObject* self, PyObject* args, PyObject* kwds )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	bool blocking;
+
+	long long timeout;
+
+	if( !ParseAcquireArguments( args, kwds, blocking, timeout ) )
+	{
+		return nullptr;
+	}
+
+	return WaitResultToPyObject( self->m_implementation->Acquire( blocking, timeout ) );
+}
+
+static PyObject*
+	SemaphoreRelease( PySemaphoreObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	self->m_implementation->Release();
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyObject*
+	SemaphoreEnter( PySemaphoreObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	return WaitResultToPyObject( self->m_implementation->Acquire( true, -1 ) );
+}
+
+static PyObject*
+	SemaphoreExit( PySemaphoreObject* self, PyObject* Py_UNUSED( args ) )
+{
+	return SemaphoreRelease( self, nullptr );
+}
+
+static PyObject*
+	SemaphoreValueGet( PySemaphoreObject* self, void* closure )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	return PyLong_FromLong( self->m_implementation->Value() );
+}
+
+static PyGetSetDef Semaphore_getsetters[] = {
+	{ "value", (getter)SemaphoreValueGet, NULL, "Number of units available without blocking", NULL },
+	{ NULL } /* Sentinel */
+};
+
+static PyMethodDef Semaphore_methods[] = {
+	{ "acquire",
+		(PyCFunction)SemaphoreAcquire,
+		METH_VARARGS | METH_KEYWORDS,
+		"Acquire a unit, blocking the current tasklet while none are available. \n\n\
+			:param blocking: If False return immediately when no unit is available \n\
+			:type blocking: Boolean \n\
+			:param timeout: Maximum time to wait in seconds, None waits indefinitely \n\
+			:type timeout: Float or None \n\
+			:return: True if a unit was acquired \n\
+			:rtype: Boolean" },
+
+	{ "release",
+		(PyCFunction)SemaphoreRelease,
+		METH_NOARGS,
+		"Release a unit. If tasklets are waiting the unit passes directly to the longest waiting one without switching." },
+
+	{ "__enter__",
+		(PyCFunction)SemaphoreEnter,
+		METH_NOARGS,
+		"Acquire a unit." },
+
+	{ "__exit__",
+		(PyCFunction)SemaphoreExit,
+		METH_VARARGS,
+		"Release a unit." },
+
+	{ NULL } /* Sentinel */
+};
+
+static PyTypeObject SemaphoreType = {
+	PyVarObject_HEAD_INIT( NULL, 0 ) "scheduler.Semaphore", /*tp_name*/
+	sizeof( PySemaphoreObject ), /*tp_basicsize*/
+	0, /*tp_itemsize*/
+	/* methods */
+	(destructor)SynchronisationPrimitiveDealloc<Semaphore, PySemaphoreObject>, /*tp_dealloc*/
+	0, /*tp_vectorcall_offset*/
+	0, /*tp_getattr*/
+	0, /*tp_setattr*/
+	0, /*tp_as_async*/
+	0, /*tp_repr*/
+	0, /*tp_as_number*/
+	0, /*tp_as_sequence*/
+	0, /*tp_as_mapping*/
+	0, /*tp_hash*/
+	0, /*tp_call*/
+	0, /*tp_str*/
+	0, /*tp_getattro*/
+	0, /*tp_setattro*/
+	0, /*tp_as_buffer*/
+	Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+	PyDoc_STR( "Semaphore objects" ), /*tp_doc*/
+	0, /*tp_traverse*/
+	0, /*tp_clear*/
+	0, /*tp_richcompare*/
+	offsetof( PySemaphoreObject, m_weakrefList ), /*tp_weaklistoffset*/
+	0, /*tp_iter*/
+	0, /*tp_iternext*/
+	Semaphore_methods, /*tp_methods*/
+	0, /*tp_members*/
+	Semaphore_getsetters, /*tp_getset*/
+	0, /*tp_base*/
+	0, /*tp_dict*/
+	0, /*tp_descr_get*/
+	0, /*tp_descr_set*/
+	0, /*tp_dictoffset*/
+	(initproc)SemaphoreInit, /*tp_init*/
+	0, /*tp_alloc*/
+	SynchronisationPrimitiveNew<PySemaphoreObject>, /*tp_new*/
+	0, /*tp_free*/
+	0, /*tp_is_gc*/
+};
+
+
+// Event
+
+static int
+	EventInit( PyEventObject* self, PyObject* args, PyObject* kwds )
+{
+	if( !PyArg_ParseTuple( args, ":Event" ) )
+	{
+		return -1;
+	}
+
+	return SynchronisationPrimitiveInit<Event>( self );
+}
+
+static PyObject*
+	EventWait( PyEventObject* self, PyObject* args, PyObject* kwds )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	long long timeout;
+
+	if( !ParseWaitArguments( args, kwds, timeout ) )
+	{
+		return nullptr;
+	}
+
+	return WaitResultToPyObject( self->m_implementation->Wait( timeout ) );
+}
+
+static PyObject*
+	EventSet( PyEventObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	self->m_implementation->Set();
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyObject*
+	EventClear( PyEventObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	self->m_implementation->Clear();
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyObject*
+	EventIsSet( PyEventObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	return PyBool_FromLong( self->m_implementation->IsSet() );
+}
+
+static PyMethodDef Event_methods[] = {
+	{ "wait",
+		(PyCFunction)EventWait,
+		METH_VARARGS | METH_KEYWORDS,
+		"Block the current tasklet until the event is set. \n\n\
+			:param timeout: Maximum time to wait in seconds, None waits indefinitely \n\
+			:type timeout: Float or None \n\
+			:return: True if the event is set, False if the timeout expired \n\
+			:rtype: Boolean" },
+
+	{ "set",
+		(PyCFunction)EventSet,
+		METH_NOARGS,
+		"Set the event, all waiting tasklets are made runnable in a single operation without switching." },
+
+	{ "clear",
+		(PyCFunction)EventClear,
+		METH_NOARGS,
+		"Reset the event so following waits block." },
+
+	{ "is_set",
+		(PyCFunction)EventIsSet,
+		METH_NOARGS,
+		"Query if the event is set. \n\n\
+			:return: True if the event is set \n\
+			:rtype: Boolean" },
+
+	{ NULL } /* Sentinel */
+};
+
+static PyTypeObject EventType = {
+	PyVarObject_HEAD_INIT( NULL, 0 ) "scheduler.Event", /*tp_name*/
+	sizeof( PyEventObject ), /*tp_basicsize*/
+	0, /*tp_itemsize*/
+	/* methods */
+	(destructor)SynchronisationPrimitiveDealloc<Event, PyEventObject>, /*tp_dealloc*/
+	0, /*tp_vectorcall_offset*/
+	0, /*tp_getattr*/
+	0, /*tp_setattr*/
+	0, /*tp_as_async*/
+	0, /*tp_repr*/
+	0, /*tp_as_number*/
+	0, /*tp_as_sequence*/
+	0, /*tp_as_mapping*/
+	0, /*tp_hash*/
+	0, /*tp_call*/
+	0, /*tp_str*/
+	0, /*tp_getattro*/
+	0, /*tp_setattro*/
+	0, /*tp_as_buffer*/
+	Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+	PyDoc_STR( "Event objects" ), /*tp_doc*/
+	0, /*tp_traverse*/
+	0, /*tp_clear*/
+	0, /*tp_richcompare*/
+	offsetof( PyEventObject, m_weakrefList ), /*tp_weaklistoffset*/
+	0, /*tp_iter*/
+	0, /*tp_iternext*/
+	Event_methods, /*tp_methods*/
+	0, /*tp_members*/
+	0, /*tp_getset*/
+	0, /*tp_base*/
+	0, /*tp_dict*/
+	0, /*tp_descr_get*/
+	0, /*tp_descr_set*/
+	0, /*tp_dictoffset*/
+	(initproc)EventInit, /*tp_init*/
+	0, /*tp_alloc*/
+	SynchronisationPrimitiveNew<PyEventObject>, /*tp_new*/
+	0, /*tp_free*/
+	0, /*tp_is_gc*/
+};
+
+
+// Condition
+
+static int
+	ConditionInit( PyConditionObject* self, PyObject* args, PyObject* kwds )
+{
+	const char* kwlist[] = { "lock", NULL };
+
+	PyObject* lockArgument = Py_None;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "|O:Condition", (char**)kwlist, &lockArgument ) )
+	{
+		return -1;
+	}
+
+	PyObject* lock = nullptr;
+
+	if( lockArgument == Py_None )
+	{
+		lock = PyObject_CallNoArgs( reinterpret_cast<PyObject*>( &LockType ) );
+
+		if( !lock )
+		{
+			return -1;
+		}
+	}
+	else if( PyObject_TypeCheck( lockArgument, &LockType ) && SynchronisationPrimitiveIsValid( reinterpret_cast<PyLockObject*>( lockArgument ) ) )
+	{
+		Py_IncRef( lockArgument );
+
+		lock = lockArgument;
+	}
+	else
+	{
+		if( !PyErr_Occurred() )
+		{
+			PyErr_SetString( PyExc_TypeError, "lock must be a scheduler.Lock" );
+		}
+
+		return -1;
+	}
+
+	// Condition takes ownership of the lock reference
+	if( SynchronisationPrimitiveInit<Condition>( self, reinterpret_cast<PyLockObject*>( lock )->m_implementation ) < 0 )
+	{
+		Py_DecRef( lock );
+
+		return -1;
+	}
+
+	return 0;
+}
+
+static PyObject*
+	ConditionAcquire( PyConditionObject* self, PyObject* args, PyObject* kwds )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	bool blocking;
+
+	long long timeout;
+
+	if( !ParseAcquireArguments( args, kwds, blocking, timeout ) )
+	{
+		return nullptr;
+	}
+
+	return WaitResultToPyObject( self->m_implementation->GetLock()->Acquire( blocking, timeout ) );
+}
+
+static PyObject*
+	ConditionRelease( PyConditionObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	if( !self->m_implementation->GetLock()->Release() )
+	{
+		return nullptr;
+	}
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyObject*
+	ConditionEnter( PyConditionObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	return WaitResultToPyObject( self->m_implementation->GetLock()->Acquire( true, -1 ) );
+}
+
+static PyObject*
+	ConditionExit( PyConditionObject* self, PyObject* Py_UNUSED( args ) )
+{
+	return ConditionRelease( self, nullptr );
+}
+
+static PyObject*
+	ConditionWait( PyConditionObject* self, PyObject* args, PyObject* kwds )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	long long timeout;
+
+	if( !ParseWaitArguments( args, kwds, timeout ) )
+	{
+		return nullptr;
+	}
+
+	return WaitResultToPyObject( self->m_implementation->Wait( timeout ) );
+}
+
+static PyObject*
+	ConditionNotify( PyConditionObject* self, PyObject* args, PyObject* kwds )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	const char* kwlist[] = { "n", NULL };
+
+	long numberToNotify = 1;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "|l:notify", (char**)kwlist, &numberToNotify ) )
+	{
+		return nullptr;
+	}
+
+	if( !self->m_implementation->Notify( numberToNotify ) )
+	{
+		return nullptr;
+	}
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyObject*
+	ConditionNotifyAll( PyConditionObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	if( !self->m_implementation->NotifyAll() )
+	{
+		return nullptr;
+	}
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyMethodDef Condition_methods[] = {
+	{ "acquire",
+		(PyCFunction)ConditionAcquire,
+		METH_VARARGS | METH_KEYWORDS,
+		"Acquire the underlying lock. \n\n\
+			:param blocking: If False return immediately when the lock is held \n\
+			:type blocking: Boolean \n\
+			:param timeout: Maximum time to wait in seconds, None waits indefinitely \n\
+			:type timeout: Float or None \n\
+			:return: True if the lock was acquired \n\
+			:rtype: Boolean" },
+
+	{ "release",
+		(PyCFunction)ConditionRelease,
+		METH_NOARGS,
+		"Release the underlying lock." },
+
+	{ "__enter__",
+		(PyCFunction)ConditionEnter,
+		METH_NOARGS,
+		"Acquire the underlying lock." },
+
+	{ "__exit__",
+		(PyCFunction)ConditionExit,
+		METH_VARARGS,
+		"Release the underlying lock." },
+
+	{ "wait",
+		(PyCFunction)ConditionWait,
+		METH_VARARGS | METH_KEYWORDS,
+		"Release the underlying lock and block the current tasklet until notified, the lock is reacquired before returning. \n\n\
+			:param timeout: Maximum time to wait in seconds, None waits indefinitely \n\
+			:type timeout: Float or None \n\
+			:return: True if notified, False if the timeout expired \n\
+			:rtype: Boolean" },
+
+	{ "notify",
+		(PyCFunction)ConditionNotify,
+		METH_VARARGS | METH_KEYWORDS,
+		"Wake up to n waiting tasklets without switching. The underlying lock must be held. \n\n\
+			:param n: Number of tasklets to wake \n\
+			:type n: Integer" },
+
+	{ "notify_all",
+		(PyCFunction)ConditionNotifyAll,
+		METH_NOARGS,
+		"Wake all waiting tasklets in a single operation without switching. The underlying lock must be held." },
+
+	{ NULL } /* Sentinel */
+};
+
+static PyTypeObject ConditionType = {
+	PyVarObject_HEAD_INIT( NULL, 0 ) "scheduler.Condition", /*tp_name*/
+	sizeof( PyConditionObject ), /*tp_basicsize*/
+	0, /*tp_itemsize*/
+	/* methods */
+	(destructor)SynchronisationPrimitiveDealloc<Condition, PyConditionObject>, /*tp_dealloc*/
+	0, /*tp_vectorcall_offset*/
+	0, /*tp_getattr*/
+	0, /*tp_setattr*/
+	0, /*tp_as_async*/
+	0, /*tp_repr*/
+	0, /*tp_as_number*/
+	0, /*tp_as_sequence*/
+	0, /*tp_as_mapping*/
+	0, /*tp_hash*/
+	0, /*tp_call*/
+	0, /*tp_str*/
+	0, /*tp_getattro*/
+	0, /*tp_setattro*/
+	0, /*tp_as_buffer*/
+	Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+	PyDoc_STR( "Condition objects" ), /*tp_doc*/
+	0, /*tp_traverse*/
+	0, /*tp_clear*/
+	0, /*tp_richcompare*/
+	offsetof( PyConditionObject, m_weakrefList ), /*tp_weaklistoffset*/
+	0, /*tp_iter*/
+	0, /*tp_iternext*/
+	Condition_methods, /*tp_methods*/
+	0, /*tp_members*/
+	0, /*tp_getset*/
+	0, /*tp_base*/
+	0, /*tp_dict*/
+	0, /*tp_descr_get*/
+	0, /*tp_descr_set*/
+	0, /*tp_dictoffset*/
+	(initproc)ConditionInit, /*tp_init*/
+	0, /*tp_alloc*/
+	SynchronisationPrimitiveNew<PyConditionObject>, /*tp_new*/
+	0, /*tp_free*/
+	0, /*tp_is_gc*/
+};
+
+
+// TaskGroup
+
+static int
+	TaskGroupInit( PyTaskGroupObject* self, PyObject* args, PyObject* kwds )
+{
+	if( !PyArg_ParseTuple( args, ":TaskGroup" ) )
+	{
+		return -1;
+	}
+
+	return SynchronisationPrimitiveInit<TaskGroup>( self );
+}
+
+static PyObject*
+	TaskGroupSpawn( PyTaskGroupObject* self, PyObject* args, PyObject* kwds )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	if( PyTuple_GET_SIZE( args ) < 1 )
+	{
+		PyErr_SetString( PyExc_TypeError, "spawn expects a callable" );
+
+		return nullptr;
+	}
+
+	PyObject* tasklet = PyObject_CallOneArg( reinterpret_cast<PyObject*>( &TaskletType ), PyTuple_GET_ITEM( args, 0 ) );
+
+	if( !tasklet )
+	{
+		return nullptr;
+	}
+
+	PyObject* callableArguments = PyTuple_GetSlice( args, 1, PyTuple_GET_SIZE( args ) );
+
+	if( !callableArguments )
+	{
+		Py_DecRef( tasklet );
+
+		return nullptr;
+	}
+
+	Tasklet* implementation = reinterpret_cast<PyTaskletObject*>( tasklet )->m_implementation;
+
+	bool success = implementation->Setup( callableArguments, kwds ) && self->m_implementation->AddChild( implementation );
+
+	Py_DecRef( callableArguments );
+
+	if( !success )
+	{
+		Py_DecRef( tasklet );
+
+		return nullptr;
+	}
+
+	return tasklet;
+}
+
+static PyObject*
+	TaskGroupJoin( PyTaskGroupObject* self, PyObject* args, PyObject* kwds )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	const char* kwlist[] = { "timeout", NULL };
+
+	PyObject* timeoutArgument = Py_None;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "|O:join", (char**)kwlist, &timeoutArgument ) )
+	{
+		return nullptr;
+	}
+
+	long long timeout;
+
+	if( !TimeoutFromPyObject( timeoutArgument, timeout ) )
+	{
+		return nullptr;
+	}
+
+	return WaitResultToPyObject( self->m_implementation->Join( timeout ) );
+}
+
+static PyObject*
+	TaskGroupCancel( PyTaskGroupObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	self->m_implementation->KillChildren();
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyObject*
+	TaskGroupEnter( PyTaskGroupObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	Py_IncRef( reinterpret_cast<PyObject*>( self ) );
+
+	return reinterpret_cast<PyObject*>( self );
+}
+
+static PyObject*
+	TaskGroupExit( PyTaskGroupObject* self, PyObject* args )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	PyObject* exceptionType = Py_None;
+
+	PyObject* exceptionValue = Py_None;
+
+	PyObject* traceback = Py_None;
+
+	if( !PyArg_ParseTuple( args, "|OOO:__exit__", &exceptionType, &exceptionValue, &traceback ) )
+	{
+		return nullptr;
+	}
+
+	if( exceptionType != Py_None )
+	{
+		// The block failed so its children are abandoned, the block's exception takes precedence
+		self->m_implementation->KillChildren();
+
+		int result = self->m_implementation->Join( -1 );
+
+		self->m_implementation->ClearException();
+
+		if( result < 0 )
+		{
+			return nullptr;
+		}
+
+		Py_IncRef( Py_False );
+
+		return Py_False;
+	}
+
+	if( self->m_implementation->Join( -1 ) < 0 )
+	{
+		return nullptr;
+	}
+
+	Py_IncRef( Py_False );
+
+	return Py_False;
+}
+
+static PyObject*
+	TaskGroupPendingGet( PyTaskGroupObject* self, void* closure )
+{
+	if( !SynchronisationPrimitiveIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	return PyLong_FromLong( self->m_implementation->NumberOfChildren() );
+}
+
+static PyMethodDef TaskGroup_methods[] = {
+	{ "spawn",
+		(PyCFunction)TaskGroupSpawn,
+		METH_VARARGS | METH_KEYWORDS,
+		"Create a tasklet running callable with the remaining arguments and add it to the group. \n\n\
+			:param callable: Callable to run \n\
+			:type callable: Callable \n\
+			:return: The new tasklet \n\
+			:rtype: scheduler.tasklet" },
+
+	{ "join",
+		(PyCFunction)TaskGroupJoin,
+		METH_VARARGS | METH_KEYWORDS,
+		"Block the current tasklet until every tasklet in the group has exited. \n\n\
+			If a tasklet in the group raised, the first exception is raised once all have exited. \n\n\
+			:param timeout: Maximum time to wait in seconds, None waits indefinitely \n\
+			:type timeout: Float or None \n\
+			:return: True if all tasklets have exited, False if the timeout expired \n\
+			:rtype: Boolean" },
+
+	{ "cancel",
+		(PyCFunction)TaskGroupCancel,
+		METH_NOARGS,
+		"Kill every tasklet in the group. Each is killed the next time it is scheduled." },
+
+	{ "__enter__",
+		(PyCFunction)TaskGroupEnter,
+		METH_NOARGS,
+		"Return the group." },
+
+	{ "__exit__",
+		(PyCFunction)TaskGroupExit,
+		METH_VARARGS,
+		"Join the group, killing its tasklets first if the block raised." },
+
+	{ NULL } /* Sentinel */
+};
+
+static PyGetSetDef TaskGroup_getsetters[] = {
+	{ "pending",
+		(getter)TaskGroupPendingGet,
+		NULL,
+		"Number of tasklets in the group that have not exited.",
+		NULL },
+
+	{ NULL } /* Sentinel */
+};
+
+static PyTypeObject TaskGroupType = {
+	PyVarObject_HEAD_INIT( NULL, 0 ) "scheduler.TaskGroup", /*tp_name*/
+	sizeof( PyTaskGroupObject ), /*tp_basicsize*/
+	0, /*tp_itemsize*/
+	/* methods */
+	(destructor)SynchronisationPrimitiveDealloc<TaskGroup, PyTaskGroupObject>, /*tp_dealloc*/
+	0, /*tp_vectorcall_offset*/
+	0, /*tp_getattr*/
+	0, /*tp_setattr*/
+	0, /*tp_as_async*/
+	0, /*tp_repr*/
+	0, /*tp_as_number*/
+	0, /*tp_as_sequence*/
+	0, /*tp_as_mapping*/
+	0, /*tp_hash*/
+	0, /*tp_call*/
+	0, /*tp_str*/
+	0, /*tp_getattro*/
+	0, /*tp_setattro*/
+	0, /*tp_as_buffer*/
+	Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+	PyDoc_STR( "TaskGroup objects" ), /*tp_doc*/
+	0, /*tp_traverse*/
+	0, /*tp_clear*/
+	0, /*tp_richcompare*/
+	offsetof( PyTaskGroupObject, m_weakrefList ), /*tp_weaklistoffset*/
+	0, /*tp_iter*/
+	0, /*tp_iternext*/
+	TaskGroup_methods, /*tp_methods*/
+	0, /*tp_members*/
+	TaskGroup_getsetters, /*tp_getset*/
+	0, /*tp_base*/
+	0, /*tp_dict*/
+	0, /*tp_descr_get*/
+	0, /*tp_descr_set*/
+	0, /*tp_dictoffset*/
+	(initproc)TaskGroupInit, /*tp_init*/
+	0, /*tp_alloc*/
+	SynchronisationPrimitiveNew<PyTaskGroupObject>, /*tp_new*/
+	0, /*tp_free*/
+	0, /*tp_is_gc*/
+};
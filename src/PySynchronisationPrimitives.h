@@ -0,0 +1,78 @@
+/*
+	*************************************************************************
+
+	PySynchronisationPrimitives.h
+
+	Created:   Oct. 2026
+	Project:   Scheduler
+
+	Description:
+
+	  PyLockObject, PyEventObject, PySemaphoreObject and PyConditionObject
+	  python type definitions
+
+	(c) CCP 2024
+
+	*************************************************************************
+*/
+#pragma once
+#ifndef PySynchronisationPrimitives_H
+#define PySynchronisationPrimitives_H
+
+class Lock;
+class Event;
+class Semaphore;
+class Condition;
+class TaskGroup;
+
+typedef struct PyLockObject
+{
+	PyObject_HEAD
+
+	Lock* m_implementation;
+
+	PyObject* m_weakrefList;
+
+} _PyLockObject;
+
+typedef struct PyEventObject
+{
+	PyObject_HEAD
+
+	Event* m_implementation;
+
+	PyObject* m_weakrefList;
+
+} _PyEventObject;
+
+typedef struct PySemaphoreObject
+{
+	PyObject_HEAD
+
+	Semaphore* m_implementation;
+
+	PyObject* m_weakrefList;
+
+} _PySemaphoreObject;
+
+typedef struct PyConditionObject
+{
+	PyObject_HEAD
+
+	Condition* m_implementation;
+
+	PyObject* m_weakrefList;
+
+} _PyConditionObject;
+
+typedef struct PyTaskGroupObject
+{
+	PyObject_HEAD
+
+	TaskGroup* m_implementation;
+
+	PyObject* m_weakrefList;
+
+} _PyTaskGroupObject;
+
+#endif // PySynchronisationPrimitives_H
@@ -193,6 +193,57 @@ static int
 	return 0;
 }
 
+static PyObject*
+	TaskletDeadlineGet( PyTaskletObject* self, void* closure )
+{
+	// Ensure PyTaskletObject is in a valid state
+	if( !PyTaskletObjectIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	if( !self->m_implementation->HasCancelDeadline() )
+	{
+		Py_IncRef( Py_None );
+
+		return Py_None;
+	}
+
+	std::chrono::duration<double> seconds = self->m_implementation->GetCancelDeadline().time_since_epoch();
+
+	return PyFloat_FromDouble( seconds.count() );
+}
+
+static int
+	TaskletDeadlineSet( PyTaskletObject* self, PyObject* value, void* closure )
+{
+	// Ensure PyTaskletObject is in a valid state
+	if( !PyTaskletObjectIsValid( self ) )
+	{
+		return -1;
+	}
+
+	if( value == nullptr || value == Py_None )
+	{
+		self->m_implementation->ClearCancelDeadline();
+
+		return 0;
+	}
+
+	double seconds = PyFloat_AsDouble( value );
+
+	if( seconds == -1.0 && PyErr_Occurred() )
+	{
+		return -1;
+	}
+
+	std::chrono::steady_clock::duration sinceEpoch = std::chrono::duration_cast<std::chrono::steady_clock::duration>( std::chrono::duration<double>( seconds ) );
+
+	self->m_implementation->SetCancelDeadline( std::chrono::steady_clock::time_point( sinceEpoch ) );
+
+	return 0;
+}
+
 static PyObject*
 	TaskletIsCurrentGet( PyTaskletObject* self, void* closure )
 {
@@ -244,7 +295,8 @@ static PyObject*
 
 	Tasklet* next = self->m_implementation->Next();
 
-    if( !next )
+	// The back of the circular runnables queue links round to the main tasklet heading it
+    if( !next || next->IsMain() )
 	{
 		Py_IncRef( Py_None );
 
@@ -272,7 +324,7 @@ static PyObject*
 
 	Tasklet* previous = self->m_implementation->Previous();
 
-	if( !previous )
+	if( !previous || self->m_implementation->IsMain() )
 	{
 		Py_IncRef( Py_None );
 
@@ -370,6 +422,41 @@ static int
 	return 0;
 }
 
+static PyObject*
+	TaskletGroupGet( PyTaskletObject* self, void* closure )
+{
+	// Ensure PyTaskletObject is in a valid state
+	if( !PyTaskletObjectIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	std::string str = self->m_implementation->GetGroup();
+
+	return PyUnicode_FromStringAndSize( str.c_str(), str.size() );
+}
+
+static int
+	TaskletGroupSet( PyTaskletObject* self, PyObject* value, void* closure )
+{
+	// Ensure PyTaskletObject is in a valid state
+	if( !PyTaskletObjectIsValid( self ) )
+	{
+		return -1;
+	}
+
+	std::string cstr;
+
+	if( !StdStringFromPyObject( value, cstr ) )
+	{
+		return -1;
+	}
+
+	self->m_implementation->SetGroup( cstr );
+
+	return 0;
+}
+
 static PyObject*
 	TaskletFileNameGet( PyTaskletObject* self, void* closure )
 {
@@ -690,6 +777,12 @@ static PyGetSetDef Tasklet_getsetters[] = {
         "True while this tasklet is within a n atomic block.",
         NULL },
 
+	{ "deadline",
+        (getter)TaskletDeadlineGet,
+        (setter)TaskletDeadlineSet,
+        "Time in time.monotonic() seconds at which blocking operations of this tasklet raise TimeoutError, None for no deadline.",
+        NULL },
+
 	{ "is_current",
         (getter)TaskletIsCurrentGet,
         NULL,
@@ -746,6 +839,11 @@ static PyGetSetDef Tasklet_getsetters[] = {
 	  (setter)TaskletContextSet,
 	    "context of the tasklet.",
 	    NULL },
+	{ "group",
+	  (getter)TaskletGroupGet,
+	  (setter)TaskletGroupSet,
+	    "group the tasklet shares run time with when fair share scheduling is enabled, falls back to context when empty.",
+	    NULL },
 	{ "file_name",
 	  (getter)TaskletFileNameGet,
 	  NULL,
@@ -1089,10 +1187,75 @@ static PyObject*
 }
 
 static PyObject*
-	TaskletSetContext( PyTaskletObject* self, void* closure )
+	TaskletJoin( PyTaskletObject* self, PyObject* args, PyObject* kwds )
 {
-	PyErr_SetString( PyExc_RuntimeError, "Tasklet_setcontext Not yet implemented" ); //TODO
-	return nullptr;
+	// Ensure PyTaskletObject is in a valid state
+	if( !PyTaskletObjectIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	const char* kwlist[] = { "timeout", NULL };
+
+	PyObject* timeoutArgument = Py_None;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "|O:join", (char**)kwlist, &timeoutArgument ) )
+	{
+		return nullptr;
+	}
+
+	long long timeout;
+
+	if( !TimeoutFromPyObject( timeoutArgument, timeout ) )
+	{
+		return nullptr;
+	}
+
+	bool exited = false;
+
+	if( !self->m_implementation->Join( timeout, exited ) )
+	{
+		return nullptr;
+	}
+
+	return PyBool_FromLong( exited );
+}
+
+static PyObject*
+	TaskletResult( PyTaskletObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	// Ensure PyTaskletObject is in a valid state
+	if( !PyTaskletObjectIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	return self->m_implementation->Result();
+}
+
+static PyObject*
+	TaskletSetContext( PyTaskletObject* self, PyObject* context )
+{
+	if( !PyTaskletObjectIsValid( self ) )
+	{
+		return nullptr;
+	}
+
+	if( !PyContext_CheckExact( context ) )
+	{
+		PyErr_SetString( PyExc_TypeError, "set_context expects a contextvars.Context" );
+
+		return nullptr;
+	}
+
+	if( !self->m_implementation->SetContextVarsContext( context ) )
+	{
+		return nullptr;
+	}
+
+	Py_IncRef( reinterpret_cast<PyObject*>( self ) );
+
+	return reinterpret_cast<PyObject*>( self );
 }
 
 
@@ -1113,6 +1276,20 @@ static int
 		Py_VISIT( callable );
 	}
 
+	PyObject* pendingCallable = tasklet->GetPendingCallable();
+
+	if( pendingCallable )
+	{
+		Py_VISIT( pendingCallable );
+	}
+
+	PyObject* bindContext = tasklet->GetBindContext();
+
+	if( bindContext )
+	{
+		Py_VISIT( bindContext );
+	}
+
 	PyObject* bind_args = tasklet->Arguments();
 
 	if( bind_args )
@@ -1126,7 +1303,25 @@ static int
 		Py_VISIT( contextMgrCallable );
     }
 
-	return 0;
+	PyObject* contextVarsContext = tasklet->GetContextVarsContext();
+	if( contextVarsContext )
+    {
+		Py_VISIT( contextVarsContext );
+    }
+
+	PyObject* resultValue = tasklet->GetResultValue();
+	if( resultValue )
+    {
+		Py_VISIT( resultValue );
+    }
+
+	PyObject* resultException = tasklet->GetResultException();
+	if( resultException )
+    {
+		Py_VISIT( resultException );
+    }
+
+	return tasklet->VisitLocals( visit, arg );
 }
 
 static int
@@ -1219,10 +1414,30 @@ static PyMethodDef Tasklet_methods[] = {
             :type pending: Bool \n\
             :throws: TaskletExit on the calling Tasklet" },
 
+	{ "join",
+        (PyCFunction)TaskletJoin,
+        METH_VARARGS | METH_KEYWORDS,
+        "Block the current tasklet until this tasklet exits. \n\n\
+            :param timeout: Maximum time to wait in seconds, None waits indefinitely \n\
+            :type timeout: Float or None \n\
+            :return: True if the tasklet has exited, False if the timeout expired \n\
+            :rtype: Bool" },
+
+	{ "result",
+        (PyCFunction)TaskletResult,
+        METH_NOARGS,
+        "Get the value returned by the tasklet's callable. \n\n\
+            :return: Value returned by the callable \n\
+            :throws: The exception the tasklet exited with, RuntimeError if the tasklet has not exited" },
+
 	{ "set_context",
         (PyCFunction)TaskletSetContext,
-        METH_NOARGS,
-        "Set the Context object to be used while this tasklet runs." },
+        METH_O,
+        "Set the contextvars.Context object to be used while this tasklet runs. \n\n\
+            Without it a tasklet runs in a copy of the context it was set up in. \n\n\
+            :param context: Context to run in \n\
+            :type context: contextvars.Context \n\
+            :return: This tasklet" },
 
 	{ "bind",
         (PyCFunction)TaskletBind,
@@ -1570,3 +1785,213 @@ static PyTypeObject CallableWrapperType = {
 	0, /*tp_free*/
 	0, /*tp_is_gc*/
 };
+
+static PyObject*
+	TaskletLocalSlotNew( PyTypeObject* type, PyObject* args, PyObject* kwds )
+{
+	if( !_PyArg_NoPositional( "TaskletLocalSlot", args ) || !_PyArg_NoKeywords( "TaskletLocalSlot", kwds ) )
+	{
+		return nullptr;
+	}
+
+	PyTaskletLocalSlotObject* self = (PyTaskletLocalSlotObject*)type->tp_alloc( type, 0 );
+
+	if( self != nullptr )
+	{
+		self->m_slot = Tasklet::AllocateLocalSlot();
+	}
+
+	return (PyObject*)self;
+}
+
+static void
+	TaskletLocalSlotDealloc( PyTaskletLocalSlotObject* self )
+{
+	Py_TYPE( self )->tp_free( (PyObject*)self );
+}
+
+static Tasklet*
+	TaskletLocalSlotCurrentTasklet()
+{
+	Tasklet* current = ScheduleManager::GetThreadScheduleManager()->GetCurrentTasklet();
+
+	if( current == nullptr )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "No current tasklet set" );
+	}
+
+	return current;
+}
+
+static PyObject*
+	TaskletLocalSlotGet( PyTaskletLocalSlotObject* self, PyObject* args, PyObject* kwds )
+{
+	const char* kwlist[] = { "default", NULL };
+
+	PyObject* defaultValue = Py_None;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "|O:get", (char**)kwlist, &defaultValue ) )
+	{
+		return nullptr;
+	}
+
+	Tasklet* current = TaskletLocalSlotCurrentTasklet();
+
+	if( !current )
+	{
+		return nullptr;
+	}
+
+	PyObject* value = current->GetLocal( self->m_slot );
+
+	if( value == nullptr )
+	{
+		value = defaultValue;
+	}
+
+	Py_IncRef( value );
+
+	return value;
+}
+
+static PyObject*
+	TaskletLocalSlotSet( PyTaskletLocalSlotObject* self, PyObject* value )
+{
+	Tasklet* current = TaskletLocalSlotCurrentTasklet();
+
+	if( !current || !current->SetLocal( self->m_slot, value ) )
+	{
+		return nullptr;
+	}
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyObject*
+	TaskletLocalSlotClear( PyTaskletLocalSlotObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	Tasklet* current = TaskletLocalSlotCurrentTasklet();
+
+	if( !current || !current->SetLocal( self->m_slot, nullptr ) )
+	{
+		return nullptr;
+	}
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyObject*
+	TaskletLocalSlotDescriptorGet( PyTaskletLocalSlotObject* self, PyObject* instance, PyObject* owner )
+{
+	// Accessed through the class, return the slot itself
+	if( instance == nullptr )
+	{
+		Py_IncRef( reinterpret_cast<PyObject*>( self ) );
+
+		return reinterpret_cast<PyObject*>( self );
+	}
+
+	Tasklet* current = TaskletLocalSlotCurrentTasklet();
+
+	if( !current )
+	{
+		return nullptr;
+	}
+
+	PyObject* value = current->GetLocal( self->m_slot );
+
+	if( value == nullptr )
+	{
+		PyErr_SetString( PyExc_AttributeError, "tasklet-local value is not set for the current tasklet" );
+
+		return nullptr;
+	}
+
+	Py_IncRef( value );
+
+	return value;
+}
+
+static int
+	TaskletLocalSlotDescriptorSet( PyTaskletLocalSlotObject* self, PyObject* instance, PyObject* value )
+{
+	Tasklet* current = TaskletLocalSlotCurrentTasklet();
+
+	if( !current || !current->SetLocal( self->m_slot, value ) )
+	{
+		return -1;
+	}
+
+	return 0;
+}
+
+static PyObject*
+	TaskletLocalSlotIndexGet( PyTaskletLocalSlotObject* self, void* closure )
+{
+	return PyLong_FromLong( self->m_slot );
+}
+
+static PyMethodDef TaskletLocalSlot_methods[] = {
+	{ "get", (PyCFunction)TaskletLocalSlotGet, METH_VARARGS | METH_KEYWORDS, "Get the value stored in this slot for the current tasklet. \n\n\
+            :param default: Value returned if the slot is unset, defaults to None \n\
+            :return: The stored value or default" },
+	{ "set", (PyCFunction)TaskletLocalSlotSet, METH_O, "Store a value in this slot for the current tasklet." },
+	{ "clear", (PyCFunction)TaskletLocalSlotClear, METH_NOARGS, "Clear this slot for the current tasklet." },
+	{ NULL } /* Sentinel */
+};
+
+static PyGetSetDef TaskletLocalSlot_getsetters[] = {
+	{ "index",
+        (getter)TaskletLocalSlotIndexGet,
+        NULL,
+        "Index of the slot in tasklet-local storage.",
+        NULL },
+	{ NULL } /* Sentinel */
+};
+
+static PyTypeObject TaskletLocalSlotType = {
+	PyVarObject_HEAD_INIT( NULL, 0 ) "scheduler.TaskletLocalSlot", /*tp_name*/
+	sizeof( PyTaskletLocalSlotObject ), /*tp_basicsize*/
+	0, /*tp_itemsize*/
+	/* methods */
+	(destructor)TaskletLocalSlotDealloc, /*tp_dealloc*/
+	0, /*tp_vectorcall_offset*/
+	0, /*tp_getattr*/
+	0, /*tp_setattr*/
+	0, /*tp_as_async*/
+	0, /*tp_repr*/
+	0, /*tp_as_number*/
+	0, /*tp_as_sequence*/
+	0, /*tp_as_mapping*/
+	0, /*tp_hash*/
+	0, /*tp_call*/
+	0, /*tp_str*/
+	0, /*tp_getattro*/
+	0, /*tp_setattro*/
+	0, /*tp_as_buffer*/
+	Py_TPFLAGS_DEFAULT, /*tp_flags*/
+	PyDoc_STR( "Slot in tasklet-local storage. As a class attribute it reads and writes the value for the current tasklet." ), /*tp_doc*/
+	0, /*tp_traverse*/
+	0, /*tp_clear*/
+	0, /*tp_richcompare*/
+	0, /*tp_weaklistoffset*/
+	0, /*tp_iter*/
+	0, /*tp_iternext*/
+	TaskletLocalSlot_methods, /*tp_methods*/
+	0, /*tp_members*/
+	TaskletLocalSlot_getsetters, /*tp_getset*/
+	0, /*tp_base*/
+	0, /*tp_dict*/
+	(descrgetfunc)TaskletLocalSlotDescriptorGet, /*tp_descr_get*/
+	(descrsetfunc)TaskletLocalSlotDescriptorSet, /*tp_descr_set*/
+	0, /*tp_dictoffset*/
+	0, /*tp_init*/
+	0, /*tp_alloc*/
+	TaskletLocalSlotNew, /*tp_new*/
+	0, /*tp_free*/
+	0, /*tp_is_gc*/
+};
@@ -9,7 +9,7 @@
 
 	Description:   
 
-	  PyTaskletObject python type definition
+	  PyTaskletObject and PyTaskletLocalSlotObject python type definitions
 
 	(c) CCP 2024
 
@@ -31,4 +31,12 @@ typedef struct PyTaskletObject
 
 } _PyTaskletObject;
 
+typedef struct PyTaskletLocalSlotObject
+{
+	PyObject_HEAD
+
+	int m_slot;
+
+} _PyTaskletLocalSlotObject;
+
 #endif // PyTasklet_H
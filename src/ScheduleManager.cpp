@@ -5,12 +5,22 @@
 #include "PyScheduleManager.h"
 #include "GILRAII.h"
 
+#include <thread>
+#include <climits>
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
 ScheduleManager::ScheduleManager( PyObject* pythonObject ) :
 	PythonCppType( pythonObject ),
 	m_threadId( PyThread_get_thread_ident() ),
 	m_schedulerTasklet( nullptr ), // Created in constructor
 	m_currentTasklet( nullptr ),   // Set in constructor
-	m_previousTasklet( nullptr ),  // Set in constructor
 	m_switchTrapLevel(0),
     m_taskletLimit(-1),
 	m_totalTaskletRunTimeLimit(-1),
@@ -18,28 +28,82 @@ ScheduleManager::ScheduleManager( PyObject* pythonObject ) :
 	m_numberOfTaskletsInQueue(0),
 	m_firstTimeLimitTestSkipped(false),
 	m_runType(RunType::STANDARD),
-	m_startTime( std::chrono::steady_clock::now() )
+	m_startTime( std::chrono::steady_clock::now() ),
+	m_statistics( GetThreadStatistics() ),
+	m_epollFd( -1 ),
+	m_wakeupFd( -1 ),
+	m_wakeupPending( false ),
+	m_hasPostedTasklets( false ),
+	m_runForeverStopRequested( false ),
+	m_flatRunTasklet( nullptr ),
+	m_flatHandoffTasklet( nullptr ),
+	m_fairShare( false ),
+	m_fairShareTurnStarted( false ),
+	m_fairShareTurnsWeight( 0.0 ),
+	m_frameBudget( false ),
+	m_frameDebt( 0 ),
+	m_frameNumber( 0 ),
+	m_firstQueuedAtBackThisFrame( nullptr ),
+	m_adaptiveBatching( false ),
+	m_maximumBatchSize( 64 ),
+	m_taskletsStartedThisRun( 0 ),
+	m_timeLimitChecksToSkip( 0 )
 {
     // Create scheduler tasklet
 	CreateSchedulerTasklet();
 
     m_currentTasklet = m_schedulerTasklet;
 
-	m_previousTasklet = m_schedulerTasklet;
+	// Start with an empty runnables queue
+	m_schedulerTasklet->SetNext( m_schedulerTasklet );
 
+	m_schedulerTasklet->SetPrevious( m_schedulerTasklet );
+
+	// Created up front so other threads can signal Wakeup before the first idle wait
+	// On failure idle waits fall back to the condition variable and I/O waits are unavailable
+	CreateEventPoll();
 }
 
 ScheduleManager::~ScheduleManager()
 {
-	s_closingScheduleManagers[m_threadId] = this;
+	// Lookups only match the closing manager on its own thread
+	bool closingOnOwnThread = PyThread_get_thread_ident() == m_threadId;
+
+	if( closingOnOwnThread )
+	{
+		t_closingScheduleManager = this;
+	}
 	
     //Clear any Tasklets that may be remaining and associated with this Thread
 	ClearThreadTasklets();
     
-	s_closingScheduleManagers.erase( m_threadId );
+	if( closingOnOwnThread )
+	{
+		t_closingScheduleManager = nullptr;
+	}
+
+	// Posted Tasklets were killed above, only the references held for posting remain
+	for( Tasklet* tasklet : m_postedTasklets )
+	{
+		tasklet->Decref();
+	}
+
+	m_postedTasklets.clear();
 
 	m_schedulerTasklet->Decref();
 
+#ifdef __linux__
+	if( m_epollFd >= 0 )
+	{
+		close( m_epollFd );
+	}
+
+	if( m_wakeupFd >= 0 )
+	{
+		close( m_wakeupFd );
+	}
+#endif
+
     s_numberOfActiveScheduleManagers--;
 }
 
@@ -85,11 +149,10 @@ ScheduleManager* ScheduleManager::GetThreadScheduleManager()
 	// as a key. We are not in danger of the threadId being reused at this point as technically
 	// the thread will not have fully finished until the scheduleManager destructor is completed
 	// at the end of which the scheduleManager will be removed from the closingScheduleManagers list.
-	long threadId = PyThread_get_thread_ident();
-	auto res = s_closingScheduleManagers.find( threadId );
-	if( res != s_closingScheduleManagers.end() )
+	// The closing scheduleManager is kept per thread, it can only be found from the thread it belongs to.
+	if( t_closingScheduleManager )
 	{
-		return res->second;
+		return t_closingScheduleManager;
 	}
 
     PyObject* threadDict = PyThreadState_GetDict();
@@ -146,96 +209,187 @@ Tasklet* ScheduleManager::GetCurrentTasklet()
 
 void ScheduleManager::InsertTaskletToRunNext( Tasklet* tasklet )
 {
-	tasklet->Incref();
+	if( PyThread_get_thread_ident() != m_threadId )
+	{
+		// There is no next to run on another thread, queue behind its other work
+		PostTasklet( tasklet );
+
+		return;
+	}
 
 	if( tasklet->IsScheduled() )
 	{
+		tasklet->Incref();
+
 		tasklet->SetReschedule( RescheduleType::BACK );
 		return;
 	}
 
-	Tasklet* currentTasklet = ScheduleManager::GetCurrentTasklet();
-
-	tasklet->SetNext( currentTasklet->Next() );
-	tasklet->SetPrevious( currentTasklet );
+	InsertTaskletAfter( RunNextPosition(), tasklet );
+}
 
-	currentTasklet->SetNext( tasklet );
+void ScheduleManager::InsertTasklet( Tasklet* tasklet )
+{
+	ScheduleManager* taskletScheduleManager = tasklet->GetScheduleManager();
 
-	if( tasklet->Next() )
+	if( PyThread_get_thread_ident() != taskletScheduleManager->m_threadId )
 	{
-		tasklet->Next()->SetPrevious( tasklet );
+		// Another thread's runnables queue is only ever changed by that thread
+		taskletScheduleManager->PostTasklet( tasklet );
+
+		return;
 	}
 
-	if( tasklet->Previous() == m_previousTasklet )
+    if( !tasklet->IsScheduled() )
+	{
+		taskletScheduleManager->InsertTaskletAfter( taskletScheduleManager->m_schedulerTasklet->Previous(), tasklet );
+    }
+	else
 	{
-		m_previousTasklet = tasklet;
+		tasklet->SetReschedule( RescheduleType::BACK );
 	}
-	tasklet->Unblock();
-	tasklet->SetScheduled( true );
+}
 
-	m_numberOfTaskletsInQueue++;
+// Queue an unscheduled Tasklet straight after position, taking a reference to it
+void ScheduleManager::InsertTaskletAfter( Tasklet* position, Tasklet* tasklet )
+{
+	tasklet->Incref();
+
+	LinkTaskletAfter( position, tasklet );
+
+	tasklet->Unblock();	// TODO should probably not be here and replaced with error path
+
+	tasklet->SetScheduled( true );
 }
 
-void ScheduleManager::InsertTasklet( Tasklet* tasklet )
+// Link tasklet into the runnables queue straight after position, which is either queued or the scheduler Tasklet
+// The scheduler Tasklet heads the circular queue so neither neighbour can be missing
+void ScheduleManager::LinkTaskletAfter( Tasklet* position, Tasklet* tasklet )
 {
-	ScheduleManager* taskletScheduleManager = tasklet->GetScheduleManager();
+	Tasklet* next = position->Next();
 
-    if( !tasklet->IsScheduled() )
+	tasklet->SetPrevious( position );
+
+	tasklet->SetNext( next );
+
+	next->SetPrevious( tasklet );
+
+	position->SetNext( tasklet );
+
+	tasklet->SetQueuedFrame( m_frameNumber );
+
+	if( m_frameBudget && next == m_schedulerTasklet && m_firstQueuedAtBackThisFrame == nullptr )
 	{
-		tasklet->Incref();
+		m_firstQueuedAtBackThisFrame = tasklet;
+	}
 
-		taskletScheduleManager->m_previousTasklet->SetNext( tasklet );
+	if( m_fairShare )
+	{
+		LinkFairShareTasklet( tasklet, next == m_schedulerTasklet );
 
-		tasklet->SetPrevious( taskletScheduleManager->m_previousTasklet );
+		if( m_frameBudget && next == m_schedulerTasklet )
+		{
+			MarkFairShareQueuedAtBack( tasklet );
+		}
+	}
 
-		// Clear out possible old next
-		tasklet->SetNext( nullptr );
+	m_numberOfTaskletsInQueue++;
+}
 
-		taskletScheduleManager->m_previousTasklet = tasklet;
+// Unlink a queued Tasklet from the runnables queue, leaving its scheduled state and references alone
+void ScheduleManager::UnlinkTasklet( Tasklet* tasklet )
+{
+	Tasklet* previous = tasklet->Previous();
 
-		tasklet->Unblock();	// TODO should probably not be here and replaced with error path
+	Tasklet* next = tasklet->Next();
 
-		tasklet->SetScheduled( true );
+	previous->SetNext( next );
 
-        m_numberOfTaskletsInQueue++;
-    }
-	else
+	next->SetPrevious( previous );
+
+	tasklet->SetNext( nullptr );
+
+	tasklet->SetPrevious( nullptr );
+
+	if( tasklet == m_firstQueuedAtBackThisFrame )
 	{
-		tasklet->SetReschedule( RescheduleType::BACK );
+		m_firstQueuedAtBackThisFrame = IsQueueEnd( next ) ? nullptr : next;
+	}
+
+	if( tasklet->GetFairShareQueue() )
+	{
+		UnlinkFairShareTasklet( tasklet );
 	}
+
+	m_numberOfTaskletsInQueue--;
 }
 
-// Relinquishes reference ownership of Tasklet
-bool ScheduleManager::RemoveTasklet( Tasklet* tasklet )
+// The queue position a Tasklet inserted to run next follows
+// A current Tasklet outside the queue has no position in it, so run next means the front
+Tasklet* ScheduleManager::RunNextPosition()
 {
-	Tasklet* previous = tasklet->Previous();
+	Tasklet* currentTasklet = GetCurrentTasklet();
 
-    Tasklet* next = tasklet->Next();
+	return currentTasklet->Next() ? currentTasklet : m_schedulerTasklet;
+}
 
-    if (previous == next)
-    {
-		return false;
-    }
+// True once a walk along the queue has wrapped back round to the scheduler Tasklet,
+// or if it started from a Tasklet outside the queue
+bool ScheduleManager::IsQueueEnd( Tasklet* tasklet ) const
+{
+	return tasklet == nullptr || tasklet == m_schedulerTasklet;
+}
 
-    if(previous != nullptr)
+// Appends a chain of unscheduled Tasklets already linked through SetNext/SetPrevious
+// to the back of the runnables queue in a single splice
+// Takes ownership of a reference to each Tasklet in the chain
+void ScheduleManager::InsertTaskletChain( Tasklet* first, Tasklet* last, int numberOfTasklets )
+{
+	if( m_frameBudget && m_firstQueuedAtBackThisFrame == nullptr )
 	{
-		previous->SetNext( next );
+		m_firstQueuedAtBackThisFrame = first;
 	}
-    
-    if(next != nullptr)
+
+	for( Tasklet* tasklet = first; tasklet != nullptr; tasklet = tasklet->Next() )
 	{
-		next->SetPrevious( previous );
-    }
-    else
-    {
-		m_previousTasklet = previous;
-    }
+		tasklet->SetScheduled( true );
 
-    m_numberOfTaskletsInQueue--;
+		tasklet->SetQueuedFrame( m_frameNumber );
 
-	tasklet->SetNext( nullptr );
+		if( m_fairShare )
+		{
+			LinkFairShareTasklet( tasklet, true );
 
-	tasklet->SetPrevious( nullptr );
+			if( m_frameBudget )
+			{
+				MarkFairShareQueuedAtBack( tasklet );
+			}
+		}
+	}
+
+	Tasklet* back = m_schedulerTasklet->Previous();
+
+	back->SetNext( first );
+
+	first->SetPrevious( back );
+
+	last->SetNext( m_schedulerTasklet );
+
+	m_schedulerTasklet->SetPrevious( last );
+
+	m_numberOfTaskletsInQueue += numberOfTasklets;
+}
+
+// Relinquishes reference ownership of Tasklet
+bool ScheduleManager::RemoveTasklet( Tasklet* tasklet )
+{
+	// Not in the queue, or the scheduler Tasklet heading it
+    if( tasklet->Next() == nullptr || tasklet == m_schedulerTasklet )
+    {
+		return false;
+    }
+
+	UnlinkTasklet( tasklet );
 
     tasklet->SetScheduled( false );
 
@@ -269,21 +423,6 @@ int ScheduleManager::GetCachedTaskletCount()
 	return m_numberOfTaskletsInQueue + 1;   // +1 is the main tasklet
 }
 
-int ScheduleManager::GetCalculatedTaskletCount()
-{
-	int count = 0;
-
-	Tasklet* currentTasklet = ScheduleManager::GetMainTasklet();
-
-	while( currentTasklet->Next() != nullptr )
-	{
-		count++;
-		currentTasklet = currentTasklet->Next();
-	}
-
-	return count + 1; // +1 is the main tasklet
-}
-
 // Returns true if tasklet is in a clean state when resumed
 // Returns false if exception has been raised on tasklet
 bool ScheduleManager::Yield()
@@ -293,31 +432,43 @@ bool ScheduleManager::Yield()
 	if( ScheduleManager::GetMainTasklet() == yieldingTasklet )
 	{
 
-		if( yieldingTasklet->IsBlocked() && yieldingTasklet->Next() == nullptr )
-		{
-			PyErr_SetString(PyExc_RuntimeError, "Deadlock: the last runnable tasklet cannot be blocked.");
-
-			return false;
-		}
-		else if( yieldingTasklet->IsBlocked() )
+		if( yieldingTasklet->IsBlocked() )
         {
-			bool success = ScheduleManager::Run();
+			while( yieldingTasklet->IsBlocked() )
+			{
+				// With nothing left to run only a pending timeout or I/O wait can unblock the main tasklet
+				ProcessPostedTasklets();
 
-            // if the run set an exception in python, we should fail due to that error now
-            if( !success )
-            {
-				return false;
-            }
+				if( IsQueueEnd( yieldingTasklet->Next() ) )
+				{
+					if( !WaitForEvents() )
+					{
+						PyErr_SetString( PyExc_RuntimeError, "Deadlock: the last runnable tasklet cannot be blocked." );
 
-            // if the main tasklet is still blocked, then this is a deadlock
-			if( yieldingTasklet->IsBlocked() )
-            {
-				PyErr_SetString( PyExc_RuntimeError, "Deadlock: the last runnable tasklet cannot be blocked." );
+						return false;
+					}
 
-				return false;
-            }
+					continue;
+				}
+
+				bool success = ScheduleManager::Run();
+
+				// if the run set an exception in python, we should fail due to that error now
+				if( !success )
+				{
+					return false;
+				}
 
-            return success;
+				// if the main tasklet is still blocked and no timeout or I/O wait is pending, then this is a deadlock
+				if( yieldingTasklet->IsBlocked() && !WaitForEvents() )
+				{
+					PyErr_SetString( PyExc_RuntimeError, "Deadlock: the last runnable tasklet cannot be blocked." );
+
+					return false;
+				}
+			}
+
+            return true;
         }
         
 		return ScheduleManager::Run();
@@ -365,20 +516,66 @@ bool ScheduleManager::Yield()
 
 bool ScheduleManager::RunTaskletsForTime( long long timeout )
 {
-	s_numberOfTaskletsCompletedLastRunWithTimeout = 0;
+	m_statistics->m_taskletsCompletedLastRunWithTimeout.store( 0, std::memory_order_relaxed );
 
-    s_numberOfTaskletsSwitchedLastRunWithTimeout = 0;
+    m_statistics->m_taskletsSwitchedLastRunWithTimeout.store( 0, std::memory_order_relaxed );
 
 	m_totalTaskletRunTimeLimit = timeout;
 
     m_firstTimeLimitTestSkipped = false;
 
+	m_taskletsStartedThisRun = 0;
+
+	m_timeLimitChecksToSkip = 0;
+
+	for( auto& entry : m_fairShareQueues )
+	{
+		entry.second.m_runTimeLastRunWithTimeout = 0;
+
+		entry.second.m_ranLastRunWithTimeout = false;
+	}
+
+	// Frame budgets only apply to the main tasklet running the whole queue
+	bool frameBudget = m_frameBudget && GetCurrentTasklet() == GetMainTasklet();
+
+	long long frameTimeout = timeout;
+
+	if( frameBudget )
+	{
+		PreferSkippedTasklets();
+
+		// Tasklets queued from here on are new to this frame
+		m_frameNumber++;
+
+		ClearQueuedAtBackThisFrame();
+
+		// The whole frame goes to paying off earlier overruns, not even the first Tasklet is run
+		if( m_frameDebt > 0 && m_frameDebt >= timeout )
+		{
+			m_frameDebt -= timeout;
+
+			m_totalTaskletRunTimeLimit = -1;
+
+			return true;
+		}
+
+		m_totalTaskletRunTimeLimit = timeout - m_frameDebt;
+	}
+
     m_runType = RunType::TIME_LIMITED;
 
     m_startTime = std::chrono::steady_clock::now();
 
 	bool ret = Run();
 
+	if( frameBudget )
+	{
+		long long elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - m_startTime ).count();
+
+		// Capped at one frame so a Tasklet overrunning every frame still runs every other frame
+		m_frameDebt = std::min( frameTimeout, std::max( 0LL, elapsed - m_totalTaskletRunTimeLimit ) );
+	}
+
     m_runType = RunType::STANDARD;
 
 	m_stopScheduler = false;
@@ -409,6 +606,11 @@ bool ScheduleManager::RunNTasklets( int n )
 
 bool ScheduleManager::Run( Tasklet* startTasklet /* = nullptr */ )
 {
+	if( !s_useNestedTasklets && startTasklet == nullptr && GetCurrentTasklet() == GetMainTasklet() )
+	{
+		return RunFlat();
+	}
+
     Tasklet* baseTasklet = nullptr;
 
     Tasklet* endTasklet = nullptr;
@@ -417,23 +619,28 @@ bool ScheduleManager::Run( Tasklet* startTasklet /* = nullptr */ )
 	{
 		baseTasklet = startTasklet->Previous();
 
-        endTasklet = m_previousTasklet;
+        endTasklet = m_schedulerTasklet->Previous();
     }
 	else
 	{
 		baseTasklet = GetCurrentTasklet();
     }
 
+	// Only a run with a timeout from the main tasklet has a budget to share
+	bool fairShare = m_fairShare && m_runType == RunType::TIME_LIMITED && startTasklet == nullptr && baseTasklet == GetMainTasklet();
+
     bool runComplete = false;
 
     bool runUntilUnblocked = false;
 
+    ProcessExternalEvents();
+
     if (GetCurrentTasklet() == GetMainTasklet() && GetCurrentTasklet()->IsBlocked())
     {
 		runUntilUnblocked = true;
     }
 
-    while( ( baseTasklet->Next() != nullptr ) && ( !runComplete ) )
+    while( !IsQueueEnd( baseTasklet->Next() ) && ( !runComplete ) )
 	{
 
         if( m_stopScheduler )
@@ -447,7 +654,12 @@ bool ScheduleManager::Run( Tasklet* startTasklet /* = nullptr */ )
 			}
 		}
 
-		Tasklet* currentTasklet = baseTasklet->Next();
+		if( GetCurrentTasklet()->IsMain() )
+		{
+			ProcessExternalEvents();
+		}
+
+		Tasklet* currentTasklet = fairShare ? NextFairShareTasklet() : baseTasklet->Next();
 
         if (ScheduleManager::GetCurrentTasklet() == currentTasklet)
         {
@@ -474,43 +686,13 @@ bool ScheduleManager::Run( Tasklet* startTasklet /* = nullptr */ )
         // and the lack of urgency from the game, it is best to keep code simple. 
 		if( GetCurrentTasklet()->IsMain() )
 		{
-            if (m_runType == RunType::TASKLET_LIMITED)
-            {
-				if( m_taskletLimit > 0 )
-				{
-					m_taskletLimit--;
-				}
-				if( m_taskletLimit <= 0 )
-				{
-					m_stopScheduler = true;
-				}
-            }
-            else if (m_runType == RunType::TIME_LIMITED)
-            {
-				// Test Total tasklet Run Limit
-				std::chrono::steady_clock::time_point current_time = std::chrono::steady_clock::now();
-
-				if( std::chrono::duration_cast<std::chrono::nanoseconds>( current_time - m_startTime ).count() >= m_totalTaskletRunTimeLimit )
-				{
-					if( m_firstTimeLimitTestSkipped == false )
-					{
-						// The first time limit test is forced to succeed.
-						// This is to ensure that at least one Tasklet is processed
-						// Even if time limit is set to 0
-						// This makes sense so we always progress and also matches
-						// Stackless behaviour for run for time
-						m_firstTimeLimitTestSkipped = true;
-					}
-					else
-					{
-						m_stopScheduler = true;
-					}
-				}
-            }
+			UpdateRunLimits();
 		}
 
+		bool switched = fairShare ? SwitchToChargingGroup( currentTasklet ) : currentTasklet->SwitchTo();
+
         // If switch returns no error or if the error raised is a tasklet exception raised error
-		if( currentTasklet->SwitchTo() || currentTasklet->TaskletExceptionRaised() )
+		if( switched || currentTasklet->TaskletExceptionRaised() )
 		{
 			//Clear possible tasklet exception to capture
 			currentTasklet->ClearTaskletException();
@@ -522,13 +704,6 @@ bool ScheduleManager::Run( Tasklet* startTasklet /* = nullptr */ )
 
 			// Update current tasklet
 			ScheduleManager::SetCurrentTasklet( currentTasklet->GetParent() );
-            
-
-			//If this is the last tasklet then update previous_tasklet to keep it at the end of the chain
-			if( currentTasklet->Next() == nullptr )
-			{
-				m_previousTasklet = currentTasklet->Previous();
-			}
 
 			// Remove tasklet from queue
             if (RemoveTasklet(currentTasklet))
@@ -538,28 +713,7 @@ bool ScheduleManager::Run( Tasklet* startTasklet /* = nullptr */ )
 
             currentTasklet->SetScheduled( false );
 
-			//Will this get skipped if it happens to be when it will schedule
-			if( currentTasklet->RequiresReschedule() == RescheduleType::BACK )
-			{
-				InsertTasklet( currentTasklet );
-				currentTasklet->SetReschedule( RescheduleType::NONE );
-			}
-            else if (currentTasklet->RequiresReschedule() == RescheduleType::FRONT_PLUS_ONE)
-            {
-				// Add after current next on queue
-				Tasklet* front = GetCurrentTasklet()->Next();
-				// Remove the current front as this will need to be retained
-                // Reference will be relinquished to here
-				RemoveTasklet( front );
-				// current becomes second on queue
-				InsertTaskletToRunNext( currentTasklet );
-				// Reinstate the front again
-				InsertTaskletToRunNext( front );
-                // Decref the reference that was relinquished from RemoveTasklet above.
-                front->Decref();
-                // Reset reschedule flag
-                currentTasklet->SetReschedule( RescheduleType::NONE );
-            }
+			ReinsertRescheduledTasklet( currentTasklet );
         }
 		// Switch was unsuccessful
 		else
@@ -604,7 +758,7 @@ bool ScheduleManager::Run( Tasklet* startTasklet /* = nullptr */ )
             if (m_runType == RunType::TIME_LIMITED)
             {
                 // Increament tasklet completed value
-				s_numberOfTaskletsCompletedLastRunWithTimeout++;
+				ThreadStatistics::Increment( m_statistics->m_taskletsCompletedLastRunWithTimeout );
             }
         }
 		
@@ -613,145 +767,1907 @@ bool ScheduleManager::Run( Tasklet* startTasklet /* = nullptr */ )
 	return true;
 }
 
-void ScheduleManager::OnSwitch()
+// Flat scheduling loop, used when nested tasklets are disabled and the main tasklet runs the queue
+// Every Tasklet switches back to the main tasklet, so its parent only needs setting on the first run
+// rather than on every iteration
+bool ScheduleManager::RunFlat()
 {
-	if( m_runType == RunType::TIME_LIMITED )
-	{
-		// Increament tasklet switched value
-		// Note this will also increment if a switch was blocked by switchtrap
-		// It is more of an attempted switch value
-		s_numberOfTaskletsSwitchedLastRunWithTimeout++;
-	}
-}
+	Tasklet* mainTasklet = GetMainTasklet();
 
-Tasklet* ScheduleManager::GetMainTasklet()
-{
-	return m_schedulerTasklet;
-}
+	bool runUntilUnblocked = mainTasklet->IsBlocked();
 
-void ScheduleManager::SetSchedulerFastCallback( schedule_hook_func* func )
-{
-	s_schedulerFastCallback = func;
-}
+	bool fairShare = m_fairShare && m_runType == RunType::TIME_LIMITED;
 
-void ScheduleManager::SetSchedulerCallback( PyObject* callback )
-{
-	// Callback is common accross threads
-	Py_XDECREF( s_schedulerCallback );
+	bool runComplete = false;
 
-	s_schedulerCallback = callback;
-}
+	ProcessExternalEvents();
 
-void ScheduleManager::RunSchedulerCallback( Tasklet* previous, Tasklet* next )
-{
-    // Run Callback through python
-	if(s_schedulerCallback)
+	while( !runComplete && !IsQueueEnd( mainTasklet->Next() ) )
 	{
-		PyObject* args = PyTuple_New( 2 );
+		if( m_stopScheduler )
+		{
+			break;
+		}
 
-        PyObject* pyPrevious = Py_None;
+		ProcessExternalEvents();
 
-        if (previous)
-        {
-			pyPrevious = previous->PythonObject();
-        }
+		Tasklet* currentTasklet = fairShare ? NextFairShareTasklet() : mainTasklet->Next();
 
-        PyObject* pyNext = Py_None;
+		if( currentTasklet->GetParent() != mainTasklet && !currentTasklet->SetParent( mainTasklet ) )
+		{
+			return false;
+		}
 
-        if (next)
-        {
-			pyNext = next->PythonObject();
-        }
+		bool cleanupCurrentTasklet = false;
 
-        Py_IncRef( pyPrevious );
+		UpdateRunLimits();
 
-		Py_IncRef( pyNext );
+		m_flatRunTasklet = currentTasklet;
 
-        PyTuple_SetItem( args, 0, pyPrevious );
+		bool switched = fairShare ? SwitchToChargingGroup( currentTasklet ) : currentTasklet->SwitchTo();
 
-        PyTuple_SetItem( args, 1, pyNext );
+		// Control may have been handed off directly between Tasklets before returning here
+		if( m_flatHandoffTasklet )
+		{
+			currentTasklet = m_flatHandoffTasklet;
+		}
 
-		PyObject_Call( s_schedulerCallback, args, nullptr );
+		m_flatRunTasklet = nullptr;
 
-        Py_DecRef( args );
-    }
+		m_flatHandoffTasklet = nullptr;
 
-    // Run fast callback bypassing python
-    if (s_schedulerFastCallback)
-    {
-		s_schedulerFastCallback( reinterpret_cast<PyTaskletObject*>(previous->PythonObject()), reinterpret_cast<PyTaskletObject*>(next->PythonObject()) );
+		if( switched || currentTasklet->TaskletExceptionRaised() )
+		{
+			currentTasklet->ClearTaskletException();
+
+			if( runUntilUnblocked && !mainTasklet->IsBlocked() )
+			{
+				runComplete = true;
+			}
+
+			SetCurrentTasklet( mainTasklet );
+
+			if( RemoveTasklet( currentTasklet ) )
+			{
+				cleanupCurrentTasklet = true;
+			}
+
+			currentTasklet->SetScheduled( false );
+
+			ReinsertRescheduledTasklet( currentTasklet );
+		}
+		else
+		{
+			SetCurrentTasklet( mainTasklet );
+
+			if( currentTasklet->RequiresRemoval() )
+			{
+				if( RemoveTasklet( currentTasklet ) )
+				{
+					currentTasklet->SetParent( nullptr );   // TODO handle failure
+
+					currentTasklet->Decref();
+				}
+			}
+			else
+			{
+				currentTasklet->SetParent( nullptr ); // TODO handle failure
+			}
+
+			return false;
+		}
+
+		// Release the parent reference once the Tasklet can no longer be switched to
+		if( !currentTasklet->IsAlive() )
+		{
+			currentTasklet->SetParent( nullptr );   // TODO handle failure
+		}
+
+		if( cleanupCurrentTasklet )
+		{
+			currentTasklet->Decref();
+
+			if( m_runType == RunType::TIME_LIMITED )
+			{
+				ThreadStatistics::Increment( m_statistics->m_taskletsCompletedLastRunWithTimeout );
+			}
+		}
+	}
+
+	return true;
+}
+
+// Returns true if the current Tasklet can switch straight to tasklet rather than via the main tasklet
+// Only possible inside RunFlat, where the run loop can account for the Tasklet it gets control back from
+bool ScheduleManager::CanHandoffTo( Tasklet* tasklet )
+{
+	if( m_flatRunTasklet == nullptr || m_runType != RunType::STANDARD || m_stopScheduler || IsSwitchTrapped() )
+	{
+		return false;
+	}
+
+	// Schedule callbacks expect to see every switch through the main tasklet
+	if( s_schedulerCallback || s_schedulerFastCallback )
+	{
+		return false;
+	}
+
+	Tasklet* current = GetCurrentTasklet();
+
+	if( current != ( m_flatHandoffTasklet ? m_flatHandoffTasklet : m_flatRunTasklet ) )
+	{
+		return false;
+	}
+
+	return tasklet->GetScheduleManager() == this && !tasklet->IsMain() && !tasklet->IsScheduled() && current->GetParent() == GetMainTasklet();
+}
+
+// Hand control from the current Tasklet straight to tasklet, which must already be queued to run next
+// The queue is left as the run loop leaves it after Schedule( BACK ), with tasklet at the front
+// and the current Tasklet at the back
+// Returns false if an exception has been raised on the current Tasklet once it is resumed
+bool ScheduleManager::HandoffTo( Tasklet* tasklet )
+{
+	Tasklet* current = GetCurrentTasklet();
+
+	Tasklet* mainTasklet = GetMainTasklet();
+
+	if( tasklet->GetParent() != mainTasklet && !tasklet->SetParent( mainTasklet ) )
+	{
+		return false;
+	}
+
+	// Rotate to the back, the queue keeps its reference
+	UnlinkTasklet( current );
+
+	LinkTaskletAfter( mainTasklet->Previous(), current );
+
+	m_flatHandoffTasklet = tasklet;
+
+	SetCurrentTasklet( tasklet );
+
+	return tasklet->SwitchDirectlyTo();
+}
+
+// The Tasklet that switched back to the run loop after it switched to tasklet
+Tasklet* ScheduleManager::SwitchedBackTasklet( Tasklet* tasklet ) const
+{
+	if( tasklet == m_flatRunTasklet && m_flatHandoffTasklet )
+	{
+		return m_flatHandoffTasklet;
+	}
+
+	return tasklet;
+}
+
+// Test the tasklet and time limits of RunNTasklets and RunTaskletsForTime before the next switch
+void ScheduleManager::UpdateRunLimits()
+{
+	if( m_runType == RunType::TASKLET_LIMITED )
+	{
+		if( m_taskletLimit > 0 )
+		{
+			m_taskletLimit--;
+		}
+		if( m_taskletLimit <= 0 )
+		{
+			m_stopScheduler = true;
+		}
+	}
+	else if( m_runType == RunType::TIME_LIMITED )
+	{
+		long long taskletsStarted = m_taskletsStartedThisRun++;
+
+		// Part of a batch, the clock was last read before its first Tasklet
+		if( m_timeLimitChecksToSkip > 0 )
+		{
+			m_timeLimitChecksToSkip--;
+
+			return;
+		}
+
+		// Test Total tasklet Run Limit
+		std::chrono::steady_clock::time_point current_time = std::chrono::steady_clock::now();
+
+		long long elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>( current_time - m_startTime ).count();
+
+		if( m_adaptiveBatching && taskletsStarted > 0 && elapsed < m_totalTaskletRunTimeLimit )
+		{
+			// Size the next batch from the average Tasklet cost so far, spending at most half the remaining budget unchecked
+			long long averageCost = std::max( 1LL, elapsed / taskletsStarted );
+
+			long long batchSize = ( m_totalTaskletRunTimeLimit - elapsed ) / averageCost / 2;
+
+			m_timeLimitChecksToSkip = static_cast<int>( std::min<long long>( std::max( 0LL, batchSize - 1 ), m_maximumBatchSize - 1 ) );
+		}
+
+		if( elapsed >= m_totalTaskletRunTimeLimit )
+		{
+			if( m_firstTimeLimitTestSkipped == false )
+			{
+				// The first time limit test is forced to succeed.
+				// This is to ensure that at least one Tasklet is processed
+				// Even if time limit is set to 0
+				// This makes sense so we always progress and also matches
+				// Stackless behaviour for run for time
+				m_firstTimeLimitTestSkipped = true;
+			}
+			else
+			{
+				m_stopScheduler = true;
+			}
+		}
+	}
+}
+
+// Deficit round robin over the groups with queued Tasklets
+// Each group takes a turn in order, running its Tasklets in queue order until its share of the run budget is used
+Tasklet* ScheduleManager::NextFairShareTasklet()
+{
+	size_t turnsWithoutRunTime = 0;
+
+	while( !m_fairShareTurns.empty() )
+	{
+		FairShareQueue* queue = m_fairShareTurns.front();
+
+		if( queue->m_first == nullptr )
+		{
+			// Emptied since its last turn, unused run time is lost but run time owed is kept
+			m_fairShareTurns.pop_front();
+
+			m_fairShareTurnStarted = false;
+
+			queue->m_active = false;
+
+			m_fairShareTurnsWeight -= queue->m_weight;
+
+			if( queue->m_deficit > 0 )
+			{
+				queue->m_deficit = 0;
+			}
+
+			continue;
+		}
+
+		if( !m_fairShareTurnStarted )
+		{
+			queue->m_deficit += FairShareQuantum( queue );
+
+			m_fairShareTurnStarted = true;
+		}
+
+		if( queue->m_deficit > 0 )
+		{
+			return queue->m_first;
+		}
+
+		m_fairShareTurns.pop_front();
+
+		m_fairShareTurns.push_back( queue );
+
+		m_fairShareTurnStarted = false;
+
+		if( ++turnsWithoutRunTime >= m_fairShareTurns.size() )
+		{
+			CreditFairShareRounds();
+
+			turnsWithoutRunTime = 0;
+		}
+	}
+
+	// Fair share was turned off during the run
+	return m_schedulerTasklet->Next();
+}
+
+// Weighted share of the run budget a group is credited with each turn
+long long ScheduleManager::FairShareQuantum( const FairShareQueue* queue ) const
+{
+	double share = m_fairShareTurnsWeight > 0.0 ? queue->m_weight / m_fairShareTurnsWeight : 1.0;
+
+	return std::max( 1LL, static_cast<long long>( m_totalTaskletRunTimeLimit * share ) );
+}
+
+// Every group has had a turn without run time left after overrunning
+// Credit enough turns at once for at least one group to run rather than cycling through them
+void ScheduleManager::CreditFairShareRounds()
+{
+	long long rounds = LLONG_MAX;
+
+	for( FairShareQueue* queue : m_fairShareTurns )
+	{
+		rounds = std::min( rounds, std::max( 0LL, -queue->m_deficit ) / FairShareQuantum( queue ) + 1 );
+	}
+
+	for( FairShareQueue* queue : m_fairShareTurns )
+	{
+		queue->m_deficit += rounds * FairShareQuantum( queue );
+	}
+}
+
+// Add a newly queued Tasklet to the queue of its group
+// Tasklets queued anywhere but the back are queued to run soon, so go to the front of their group
+void ScheduleManager::LinkFairShareTasklet( Tasklet* tasklet, bool atBack )
+{
+	const std::string& group = tasklet->FairShareGroup();
+
+	auto iter = m_fairShareQueues.find( group );
+
+	if( iter == m_fairShareQueues.end() )
+	{
+		iter = m_fairShareQueues.emplace( group, FairShareQueue() ).first;
+
+		iter->second.m_group = group;
+
+		auto weight = m_groupWeights.find( group );
+
+		if( weight != m_groupWeights.end() )
+		{
+			iter->second.m_weight = weight->second;
+		}
+	}
+
+	FairShareQueue* queue = &iter->second;
+
+	if( !queue->m_active )
+	{
+		queue->m_active = true;
+
+		m_fairShareTurns.push_back( queue );
+
+		m_fairShareTurnsWeight += queue->m_weight;
+	}
+
+	tasklet->SetFairShareQueue( queue );
+
+	if( queue->m_first == nullptr )
+	{
+		tasklet->SetNextInFairShareQueue( nullptr );
+
+		tasklet->SetPreviousInFairShareQueue( nullptr );
+
+		queue->m_first = tasklet;
+
+		queue->m_last = tasklet;
+	}
+	else if( atBack )
+	{
+		tasklet->SetNextInFairShareQueue( nullptr );
+
+		tasklet->SetPreviousInFairShareQueue( queue->m_last );
+
+		queue->m_last->SetNextInFairShareQueue( tasklet );
+
+		queue->m_last = tasklet;
+	}
+	else
+	{
+		tasklet->SetNextInFairShareQueue( queue->m_first );
+
+		tasklet->SetPreviousInFairShareQueue( nullptr );
+
+		queue->m_first->SetPreviousInFairShareQueue( tasklet );
+
+		queue->m_first = tasklet;
+	}
+}
+
+// Link a Tasklet into a group queue it was just unlinked from, ahead of before or at the back if before is nullptr
+void ScheduleManager::LinkFairShareTaskletBefore( Tasklet* tasklet, FairShareQueue* queue, Tasklet* before )
+{
+	Tasklet* previous = before ? before->PreviousInFairShareQueue() : queue->m_last;
+
+	tasklet->SetFairShareQueue( queue );
+
+	tasklet->SetPreviousInFairShareQueue( previous );
+
+	tasklet->SetNextInFairShareQueue( before );
+
+	if( previous )
+	{
+		previous->SetNextInFairShareQueue( tasklet );
+	}
+	else
+	{
+		queue->m_first = tasklet;
+	}
+
+	if( before )
+	{
+		before->SetPreviousInFairShareQueue( tasklet );
+	}
+	else
+	{
+		queue->m_last = tasklet;
+	}
+}
+
+// The first Tasklet of a group queued at the back during a frame marks where the group's new Tasklets start
+void ScheduleManager::MarkFairShareQueuedAtBack( Tasklet* tasklet )
+{
+	FairShareQueue* queue = tasklet->GetFairShareQueue();
+
+	if( queue->m_firstQueuedAtBackThisFrame == nullptr )
+	{
+		queue->m_firstQueuedAtBackThisFrame = tasklet;
+	}
+}
+
+// The group keeps its turn order place even once empty, as a Tasklet that has just run is removed
+// before being queued again
+void ScheduleManager::UnlinkFairShareTasklet( Tasklet* tasklet )
+{
+	FairShareQueue* queue = tasklet->GetFairShareQueue();
+
+	Tasklet* previous = tasklet->PreviousInFairShareQueue();
+
+	Tasklet* next = tasklet->NextInFairShareQueue();
+
+	if( tasklet == queue->m_firstQueuedAtBackThisFrame )
+	{
+		queue->m_firstQueuedAtBackThisFrame = next;
+	}
+
+	if( previous )
+	{
+		previous->SetNextInFairShareQueue( next );
+	}
+	else
+	{
+		queue->m_first = next;
+	}
+
+	if( next )
+	{
+		next->SetPreviousInFairShareQueue( previous );
+	}
+	else
+	{
+		queue->m_last = previous;
+	}
+
+	tasklet->SetFairShareQueue( nullptr );
+
+	tasklet->SetNextInFairShareQueue( nullptr );
+
+	tasklet->SetPreviousInFairShareQueue( nullptr );
+}
+
+// Switch to a Tasklet picked in fair share mode, charging its group with the time until control returns
+// The queue is taken before switching as the Tasklet leaves it once it has run
+bool ScheduleManager::SwitchToChargingGroup( Tasklet* tasklet )
+{
+	FairShareQueue* queue = tasklet->GetFairShareQueue();
+
+	std::chrono::steady_clock::time_point switchTime = std::chrono::steady_clock::now();
+
+	bool switched = tasklet->SwitchTo();
+
+	if( queue )
+	{
+		long long runTime = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - switchTime ).count();
+
+		queue->m_deficit -= runTime;
+
+		queue->m_runTimeLastRunWithTimeout += runTime;
+
+		queue->m_ranLastRunWithTimeout = true;
+	}
+
+	return switched;
+}
+
+// Move the Tasklets the last frame skipped ahead of those queued since it started, keeping the order of each
+// Tasklets queued at the back are already behind the skipped Tasklets, those queued to run next that are
+// still waiting sit together at the front, so a single splice moves them in front of the Tasklets queued at the back
+void ScheduleManager::PreferSkippedTasklets()
+{
+	Tasklet* first = m_schedulerTasklet->Next();
+
+	Tasklet* last = nullptr;
+
+	for( Tasklet* tasklet = first; !IsQueueEnd( tasklet ) && tasklet != m_firstQueuedAtBackThisFrame && tasklet->QueuedFrame() >= m_frameNumber; tasklet = tasklet->Next() )
+	{
+		last = tasklet;
+	}
+
+	// Nothing new at the front, or nothing skipped behind it
+	if( last == nullptr || IsQueueEnd( last->Next() ) || last->Next() == m_firstQueuedAtBackThisFrame )
+	{
+		return;
+	}
+
+	Tasklet* position = m_firstQueuedAtBackThisFrame ? m_firstQueuedAtBackThisFrame->Previous() : m_schedulerTasklet->Previous();
+
+	Tasklet* skipped = last->Next();
+
+	m_schedulerTasklet->SetNext( skipped );
+
+	skipped->SetPrevious( m_schedulerTasklet );
+
+	Tasklet* next = position->Next();
+
+	position->SetNext( first );
+
+	first->SetPrevious( position );
+
+	last->SetNext( next );
+
+	next->SetPrevious( last );
+
+	if( m_fairShare )
+	{
+		// Tasklets queued to run next went to the front of their group, move each behind the skipped Tasklets of its group
+		for( Tasklet* tasklet = first; tasklet != next; tasklet = tasklet->Next() )
+		{
+			FairShareQueue* queue = tasklet->GetFairShareQueue();
+
+			Tasklet* before = queue->m_firstQueuedAtBackThisFrame;
+
+			UnlinkFairShareTasklet( tasklet );
+
+			LinkFairShareTaskletBefore( tasklet, queue, before );
+		}
+	}
+}
+
+// Clear the marks of where the Tasklets queued at the back during this frame start
+void ScheduleManager::ClearQueuedAtBackThisFrame()
+{
+	m_firstQueuedAtBackThisFrame = nullptr;
+
+	for( FairShareQueue* queue : m_fairShareTurns )
+	{
+		queue->m_firstQueuedAtBackThisFrame = nullptr;
+	}
+}
+
+// Check the time limit of RunTaskletsForTime once per batch of Tasklets rather than before every Tasklet
+// Batch sizes adapt to the cost of the Tasklets run so far, up to maximumBatchSize
+void ScheduleManager::SetAdaptiveBatching( bool enabled, int maximumBatchSize )
+{
+	m_adaptiveBatching = enabled;
+
+	m_maximumBatchSize = maximumBatchSize;
+}
+
+bool ScheduleManager::AdaptiveBatching() const
+{
+	return m_adaptiveBatching;
+}
+
+int ScheduleManager::MaximumBatchSize() const
+{
+	return m_maximumBatchSize;
+}
+
+void ScheduleManager::SetFrameBudget( bool enabled )
+{
+	m_frameBudget = enabled;
+
+	ClearQueuedAtBackThisFrame();
+
+	m_frameDebt = 0;
+}
+
+bool ScheduleManager::FrameBudget() const
+{
+	return m_frameBudget;
+}
+
+// Nanoseconds of overrun to be taken from the budget of the next frame
+long long ScheduleManager::FrameDebt() const
+{
+	return m_frameDebt;
+}
+
+// The group queues are rebuilt from the runnables queue, so groups start with no run time owed
+void ScheduleManager::SetFairShare( bool enabled )
+{
+	for( Tasklet* tasklet = m_schedulerTasklet->Next(); !IsQueueEnd( tasklet ); tasklet = tasklet->Next() )
+	{
+		tasklet->SetFairShareQueue( nullptr );
+	}
+
+	for( auto& entry : m_fairShareQueues )
+	{
+		entry.second.m_first = nullptr;
+
+		entry.second.m_last = nullptr;
+
+		entry.second.m_firstQueuedAtBackThisFrame = nullptr;
+
+		entry.second.m_deficit = 0;
+
+		entry.second.m_active = false;
+	}
+
+	m_fairShareTurns.clear();
+
+	m_fairShareTurnStarted = false;
+
+	m_fairShareTurnsWeight = 0.0;
+
+	m_fairShare = enabled;
+
+	if( enabled )
+	{
+		bool queuedAtBack = false;
+
+		for( Tasklet* tasklet = m_schedulerTasklet->Next(); !IsQueueEnd( tasklet ); tasklet = tasklet->Next() )
+		{
+			LinkFairShareTasklet( tasklet, true );
+
+			queuedAtBack = queuedAtBack || tasklet == m_firstQueuedAtBackThisFrame;
+
+			if( queuedAtBack )
+			{
+				MarkFairShareQueuedAtBack( tasklet );
+			}
+		}
+	}
+}
+
+bool ScheduleManager::FairShare() const
+{
+	return m_fairShare;
+}
+
+// Relative share of the budget of a run with a timeout, groups without a weight have a weight of 1
+void ScheduleManager::SetGroupWeight( const std::string& group, double weight )
+{
+	m_groupWeights[group] = weight;
+
+	auto queue = m_fairShareQueues.find( group );
+
+	if( queue != m_fairShareQueues.end() )
+	{
+		if( queue->second.m_active )
+		{
+			m_fairShareTurnsWeight += weight - queue->second.m_weight;
+		}
+
+		queue->second.m_weight = weight;
+	}
+}
+
+// Move a queued Tasklet whose group or context changed to the back of its new group
+void ScheduleManager::RegroupFairShareTasklet( Tasklet* tasklet )
+{
+	UnlinkFairShareTasklet( tasklet );
+
+	LinkFairShareTasklet( tasklet, true );
+}
+
+const std::unordered_map<std::string, FairShareQueue>& ScheduleManager::FairShareQueues() const
+{
+	return m_fairShareQueues;
+}
+
+// Put a Tasklet that has just switched back into the queue position it requested
+void ScheduleManager::ReinsertRescheduledTasklet( Tasklet* currentTasklet )
+{
+	//Will this get skipped if it happens to be when it will schedule
+	if( currentTasklet->RequiresReschedule() == RescheduleType::BACK )
+	{
+		InsertTasklet( currentTasklet );
+		currentTasklet->SetReschedule( RescheduleType::NONE );
+	}
+	else if( currentTasklet->RequiresReschedule() == RescheduleType::FRONT_PLUS_ONE )
+	{
+		// Add after current next on queue, so current becomes second on queue
+		Tasklet* front = RunNextPosition()->Next();
+
+		InsertTaskletAfter( front, currentTasklet );
+		// Reset reschedule flag
+		currentTasklet->SetReschedule( RescheduleType::NONE );
+	}
+}
+
+void ScheduleManager::OnSwitch()
+{
+	if( m_runType == RunType::TIME_LIMITED )
+	{
+		// Increament tasklet switched value
+		// Note this will also increment if a switch was blocked by switchtrap
+		// It is more of an attempted switch value
+		ThreadStatistics::Increment( m_statistics->m_taskletsSwitchedLastRunWithTimeout );
+	}
+}
+
+Tasklet* ScheduleManager::GetMainTasklet()
+{
+	return m_schedulerTasklet;
+}
+
+void ScheduleManager::SetSchedulerFastCallback( schedule_hook_func* func )
+{
+	s_schedulerFastCallback = func;
+}
+
+void ScheduleManager::SetSchedulerCallback( PyObject* callback )
+{
+	// Callback is common accross threads
+	PyObject* previousCallback = nullptr;
+
+	{
+		ThreadLockRAII lock( s_schedulerCallbackLock );
+
+		previousCallback = s_schedulerCallback;
+
+		s_schedulerCallback = callback;
+	}
+
+	// Released outside the lock as it may run arbitrary code
+	Py_XDECREF( previousCallback );
+}
+
+void ScheduleManager::RunSchedulerCallback( Tasklet* previous, Tasklet* next )
+{
+    // Run Callback through python
+	if(s_schedulerCallback)
+	{
+		// Held while calling as another thread may replace the callback
+		PyObject* callback = nullptr;
+
+		{
+			ThreadLockRAII lock( s_schedulerCallbackLock );
+
+			callback = s_schedulerCallback;
+
+			Py_XINCREF( callback );
+		}
+
+		if( !callback )
+		{
+			return;
+		}
+
+		PyObject* args = PyTuple_New( 2 );
+
+        PyObject* pyPrevious = Py_None;
+
+        if (previous)
+        {
+			pyPrevious = previous->PythonObject();
+        }
+
+        PyObject* pyNext = Py_None;
+
+        if (next)
+        {
+			pyNext = next->PythonObject();
+        }
+
+        Py_IncRef( pyPrevious );
+
+		Py_IncRef( pyNext );
+
+        PyTuple_SetItem( args, 0, pyPrevious );
+
+        PyTuple_SetItem( args, 1, pyNext );
+
+		PyObject_Call( callback, args, nullptr );
+
+        Py_DecRef( args );
+
+		Py_DecRef( callback );
+    }
+
+    // Run fast callback bypassing python
+	schedule_hook_func* fastCallback = s_schedulerFastCallback;
+
+    if (fastCallback)
+    {
+		fastCallback( reinterpret_cast<PyTaskletObject*>(previous->PythonObject()), reinterpret_cast<PyTaskletObject*>(next->PythonObject()) );
     }
 }
 
-bool ScheduleManager::IsSwitchTrapped()
+bool ScheduleManager::IsSwitchTrapped()
+{
+    return m_switchTrapLevel != 0;
+}
+
+PyObject* ScheduleManager::SchedulerCallback()
+{
+	return s_schedulerCallback;
+}
+
+int ScheduleManager::SwitchTrapLevel()
+{
+	return m_switchTrapLevel;
+}
+
+void ScheduleManager::SetSwitchTrapLevel( int level )
+{
+	m_switchTrapLevel = level;
+}
+
+int ScheduleManager::GetNumberOfTaskletsCompletedLastRunWithTimeout() const
+{
+	return m_statistics->m_taskletsCompletedLastRunWithTimeout.load( std::memory_order_relaxed );
+}
+
+int ScheduleManager::GetNumberOfTaskletsSwitchedLastRunWithTimeout() const
+{
+	return m_statistics->m_taskletsSwitchedLastRunWithTimeout.load( std::memory_order_relaxed );
+}
+
+ThreadStatistics* ScheduleManager::Statistics() const
+{
+	return m_statistics;
+}
+
+// Counters for the calling thread, created on first use or taken from a thread that has exited
+ThreadStatistics* ScheduleManager::GetThreadStatistics()
+{
+	if( !t_threadStatistics.m_statistics )
+	{
+		std::lock_guard<std::mutex> lock( s_threadStatisticsMutex );
+
+		if( s_freeThreadStatistics.empty() )
+		{
+			s_threadStatistics.push_back( std::make_unique<ThreadStatistics>() );
+
+			t_threadStatistics.m_statistics = s_threadStatistics.back().get();
+		}
+		else
+		{
+			t_threadStatistics.m_statistics = s_freeThreadStatistics.back();
+
+			s_freeThreadStatistics.pop_back();
+		}
+	}
+
+	return t_threadStatistics.m_statistics;
+}
+
+ThreadStatisticsOwner::~ThreadStatisticsOwner()
+{
+	if( m_statistics )
+	{
+		m_statistics->m_threadExited.store( true );
+
+		ScheduleManager::RecycleThreadStatistics( m_statistics );
+	}
+}
+
+// Return the counters of an exited thread to the free list once no Tasklet counts against them
+// Called by the exiting thread and by whichever thread releases the last Tasklet, only one of them recycles the block
+// The all time count is kept in the process wide total
+void ScheduleManager::RecycleThreadStatistics( ThreadStatistics* statistics )
+{
+	std::lock_guard<std::mutex> lock( s_threadStatisticsMutex );
+
+	if( !statistics->m_threadExited.load() || statistics->m_activeTaskletCount.load() != 0 )
+	{
+		return;
+	}
+
+	s_recycledAllTimeTaskletCount += statistics->m_allTimeTaskletCount.load( std::memory_order_relaxed );
+
+	statistics->m_allTimeTaskletCount.store( 0, std::memory_order_relaxed );
+
+	statistics->m_taskletsCompletedLastRunWithTimeout.store( 0, std::memory_order_relaxed );
+
+	statistics->m_taskletsSwitchedLastRunWithTimeout.store( 0, std::memory_order_relaxed );
+
+	statistics->m_threadExited.store( false );
+
+	s_freeThreadStatistics.push_back( statistics );
+}
+
+// Process wide total of a counter across every thread
+long ScheduleManager::AggregateStatistic( std::atomic<long> ThreadStatistics::*statistic )
+{
+	std::lock_guard<std::mutex> lock( s_threadStatisticsMutex );
+
+	long total = statistic == &ThreadStatistics::m_allTimeTaskletCount ? s_recycledAllTimeTaskletCount : 0;
+
+	for( const std::unique_ptr<ThreadStatistics>& threadStatistics : s_threadStatistics )
+	{
+		total += ( threadStatistics.get()->*statistic ).load( std::memory_order_relaxed );
+	}
+
+	return total;
+}
+
+void ScheduleManager::RegisterTaskletToThread( Tasklet* tasklet )
+{
+	ThreadLockRAII lock( m_taskletsOnSchedulerThreadLock );
+
+	m_taskletsOnSchedulerThread.insert( tasklet );
+}
+
+void ScheduleManager::UnregisterTaskletFromThread( Tasklet* tasklet )
+{
+	ThreadLockRAII lock( m_taskletsOnSchedulerThreadLock );
+
+	if( m_taskletsOnSchedulerThread.find( tasklet ) != m_taskletsOnSchedulerThread.end() )
+	{
+		m_taskletsOnSchedulerThread.erase( tasklet );
+	}
+}
+
+void ScheduleManager::ClearThreadTasklets()
+{
+    // Tasklets will be removed from being scheduled if their ScheduleManger is set to null
+    // Tasklets without a schedule manager is an invalid state so Tasklets are killed if this is about to happen
+	// It is possible that this becomes and infinate loop
+	// For example if the python code catches the TaskletExit/generic exceptionscheduleManager->Decref(
+	// as part of an inifinate loop
+	// If this is the case carbon-scheduler will start to leak scheduleManagers and threads
+	// This could be noticable through metrics
+	// We could put a limit on the pumping of below and just instead opt to leak Tasklets/arguments
+
+	// Kill everything in a single pass first, any Tasklet that survives is then killed one at a time
+	if( !KillAllTasklets( false ) )
+	{
+		PyErr_Clear();
+	}
+
+	while( true )
+	{
+		Tasklet* t = nullptr;
+
+		{
+			ThreadLockRAII lock( m_taskletsOnSchedulerThreadLock );
+
+			if( m_taskletsOnSchedulerThread.empty() )
+			{
+				break;
+			}
+
+			t = *m_taskletsOnSchedulerThread.begin();
+		}
+
+		// Disassociate tasklet from thread
+		t->SetScheduleManager( nullptr );
+	}
+}
+
+// Kill many Tasklets at once
+// Victims are marked and appended to the runnables queue as one chain, then unless pending the chain is
+// run in a single pass rather than the run loop being entered once per victim
+// Unless pending, Tasklets that have never run are killed directly and never queued
+// The current Tasklet is killed last, which raises TaskletExit once the other victims have been dealt with
+bool ScheduleManager::KillTasklets( const std::vector<Tasklet*>& tasklets, bool pending )
+{
+	if( PyThread_get_thread_ident() != m_threadId )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "Failed to kill tasklets: Cannot kill tasklets from another thread" );
+
+		return false;
+	}
+
+	Tasklet* current = GetCurrentTasklet();
+
+	bool killCurrent = false;
+
+	Tasklet* first = nullptr;
+
+	Tasklet* last = nullptr;
+
+	int numberChained = 0;
+
+	for( Tasklet* tasklet : tasklets )
+	{
+		if( !tasklet->IsAlive() )
+		{
+			continue;
+		}
+
+		if( tasklet == current )
+		{
+			killCurrent = true;
+
+			continue;
+		}
+
+		if( tasklet->IsMain() || tasklet->GetScheduleManager() != this )
+		{
+			if( !tasklet->Kill( pending ) )
+			{
+				return false;
+			}
+
+			continue;
+		}
+
+		if( !pending && tasklet->IsUnstarted() )
+		{
+			tasklet->KillUnstarted();
+
+			continue;
+		}
+
+		if( tasklet->IsKillPending() )
+		{
+			// Already chained by this call
+			if( !tasklet->IsScheduled() )
+			{
+				continue;
+			}
+		}
+		else
+		{
+			tasklet->MarkKillPending();
+		}
+
+		if( tasklet->IsScheduled() )
+		{
+			// The reference relinquished by the runnables queue is held by the chain instead
+			RemoveTasklet( tasklet );
+
+			tasklet->SetScheduled( false );
+		}
+		else
+		{
+			tasklet->Incref();
+		}
+
+		tasklet->SetNext( nullptr );
+
+		tasklet->SetPrevious( last );
+
+		if( last == nullptr )
+		{
+			first = tasklet;
+		}
+		else
+		{
+			last->SetNext( tasklet );
+		}
+
+		last = tasklet;
+
+		numberChained++;
+	}
+
+	if( first != nullptr )
+	{
+		InsertTaskletChain( first, last, numberChained );
+
+		if( !pending )
+		{
+			if( s_useNestedTasklets || current->IsMain() )
+			{
+				// The chain is at the back of the queue so the run ends with its last victim
+				if( !Run( first ) )
+				{
+					return false;
+				}
+			}
+			else
+			{
+				// A flat queue is only run from the main tasklet, so each victim is switched to in turn
+				std::vector<Tasklet*> victims;
+
+				victims.reserve( numberChained );
+
+				// The chain was spliced onto the back of the queue so ends at the scheduler Tasklet
+				for( Tasklet* tasklet = first; !IsQueueEnd( tasklet ); tasklet = tasklet->Next() )
+				{
+					tasklet->Incref();
+
+					victims.push_back( tasklet );
+				}
+
+				bool result = true;
+
+				for( Tasklet* tasklet : victims )
+				{
+					if( result && tasklet->IsAlive() && tasklet->IsKillPending() )
+					{
+						result = tasklet->Run();
+					}
+
+					tasklet->Decref();
+				}
+
+				if( !result )
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	if( killCurrent )
+	{
+		return current->Kill( pending );
+	}
+
+	return true;
+}
+
+// Kill every Tasklet on this thread other than the main and current Tasklets
+bool ScheduleManager::KillAllTasklets( bool pending )
+{
+	Tasklet* current = GetCurrentTasklet();
+
+	std::vector<Tasklet*> tasklets;
+
+	{
+		ThreadLockRAII lock( m_taskletsOnSchedulerThreadLock );
+
+		tasklets.reserve( m_taskletsOnSchedulerThread.size() );
+
+		for( Tasklet* tasklet : m_taskletsOnSchedulerThread )
+		{
+			if( tasklet != current && !tasklet->IsMain() )
+			{
+				// Victims may be released as they die
+				tasklet->Incref();
+
+				tasklets.push_back( tasklet );
+			}
+		}
+	}
+
+	bool result = KillTasklets( tasklets, pending );
+
+	for( Tasklet* tasklet : tasklets )
+	{
+		tasklet->Decref();
+	}
+
+	return result;
+}
+
+unsigned long ScheduleManager::ThreadId() const
+{
+	return m_threadId;
+}
+
+// Register a deadline for a blocked Tasklet, timeout is in nanoseconds
+void ScheduleManager::AddTimeout( Tasklet* tasklet, long long timeout )
+{
+	RemoveTimeout( tasklet );
+
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds( timeout );
+
+	m_timeouts.emplace( deadline, tasklet );
+
+	tasklet->SetTimeoutDeadline( deadline );
+}
+
+void ScheduleManager::RemoveTimeout( Tasklet* tasklet )
+{
+	if( !tasklet->HasTimeout() )
+	{
+		return;
+	}
+
+	auto range = m_timeouts.equal_range( tasklet->GetTimeoutDeadline() );
+
+	for( auto iter = range.first; iter != range.second; iter++ )
+	{
+		if( iter->second == tasklet )
+		{
+			m_timeouts.erase( iter );
+
+			break;
+		}
+	}
+
+	tasklet->ClearTimeoutDeadline();
+}
+
+void ScheduleManager::ProcessExpiredTimeouts()
+{
+	if( m_timeouts.empty() )
+	{
+		return;
+	}
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	while( !m_timeouts.empty() && m_timeouts.begin()->first <= now )
+	{
+		Tasklet* tasklet = m_timeouts.begin()->second;
+
+		m_timeouts.erase( m_timeouts.begin() );
+
+		tasklet->ClearTimeoutDeadline();
+
+		tasklet->OnTimeoutExpired();
+	}
+}
+
+// Limit the timeout of a blocking operation to the cancel scope deadline of the blocking Tasklet
+// timeout is in nanoseconds, a negative value waits indefinitely and 0 polls without blocking
+// Returns true if the deadline now bounds the wait, timing out must then raise TimeoutError
+bool ScheduleManager::ApplyCancelDeadline( Tasklet* tasklet, long long& timeout ) const
+{
+	if( !tasklet->HasCancelDeadline() )
+	{
+		return false;
+	}
+
+	long long remaining = std::chrono::duration_cast<std::chrono::nanoseconds>( tasklet->GetCancelDeadline() - std::chrono::steady_clock::now() ).count();
+
+	if( remaining < 0 )
+	{
+		remaining = 0;
+	}
+
+	if( timeout >= 0 && timeout <= remaining )
+	{
+		return false;
+	}
+
+	timeout = remaining;
+
+	return true;
+}
+
+// Block the thread until the earliest pending timeout expires or a parked I/O wait becomes ready
+// timeout limits the wait in nanoseconds, -1 waits for the next event
+// Returns false if there are no pending timeouts or I/O waits to wait for
+bool ScheduleManager::WaitForEvents( long long timeout )
+{
+	if( m_timeouts.empty() && m_ioWaits.empty() )
+	{
+		return false;
+	}
+
+	WaitForWakeup( timeout );
+
+	return true;
+}
+
+// Nanoseconds until the earliest pending timeout, 0 if already expired and -1 if none are pending
+long long ScheduleManager::TimeUntilNextTimeout() const
+{
+	if( m_timeouts.empty() )
+	{
+		return -1;
+	}
+
+	long long remaining = std::chrono::duration_cast<std::chrono::nanoseconds>( m_timeouts.begin()->first - std::chrono::steady_clock::now() ).count();
+
+	return remaining > 0 ? remaining : 0;
+}
+
+// Called from the run loop whenever control is back on the main tasklet
+void ScheduleManager::ProcessExternalEvents()
+{
+	ProcessPostedTasklets();
+
+	ProcessExpiredTimeouts();
+
+	if( !m_ioWaits.empty() )
+	{
+		ProcessIoEvents( 0 );
+	}
+}
+
+// Park the current Tasklet until fd becomes readable or writable, timeout is in nanoseconds
+// ready is set false if the timeout expired first
+// Returns false if an exception has been raised
+bool ScheduleManager::WaitForIo( int fd, bool writable, long long timeout, bool& ready )
+{
+	ready = false;
+
+#ifdef __linux__
+	Tasklet* current = GetCurrentTasklet();
+
+	if( current == nullptr )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "No current tasklet set" );
+
+		return false;
+	}
+
+	bool cancelScoped = ApplyCancelDeadline( current, timeout );
+
+	if( timeout == 0 )
+	{
+		pollfd pollFd = { fd, static_cast<short>( writable ? POLLOUT : POLLIN ), 0 };
+
+		if( poll( &pollFd, 1, 0 ) < 0 )
+		{
+			PyErr_SetFromErrno( PyExc_OSError );
+
+			return false;
+		}
+
+		ready = pollFd.revents != 0;
+
+		if( !ready && cancelScoped )
+		{
+			PyErr_SetString( PyExc_TimeoutError, "I/O wait timed out" );
+
+			return false;
+		}
+
+		return true;
+	}
+
+	if( current->IsBlocktrapped() )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "Tasklet cannot block on I/O with block_trap set true" );
+
+		return false;
+	}
+
+	if( m_epollFd < 0 )
+	{
+		PyErr_SetString( PyExc_OSError, "I/O waits are unavailable, the event poll could not be created" );
+
+		return false;
+	}
+
+	auto iter = m_ioWaits.find( fd );
+
+	bool registered = iter != m_ioWaits.end();
+
+	IoWait& ioWait = registered ? iter->second : m_ioWaits[fd];
+
+	Tasklet*& waiter = writable ? ioWait.m_writer : ioWait.m_reader;
+
+	if( waiter != nullptr )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "Another tasklet is already waiting on this file descriptor" );
+
+		return false;
+	}
+
+	waiter = current;
+
+	if( !UpdateIoRegistration( fd, registered ) )
+	{
+		PyErr_SetFromErrno( PyExc_OSError );
+
+		waiter = nullptr;
+
+		if( !registered )
+		{
+			m_ioWaits.erase( fd );
+		}
+
+		return false;
+	}
+
+	// The reference is held on behalf of the I/O wait and released once resumed
+	current->Incref();
+
+	current->SetIoWaitFd( fd );
+
+	current->Block( nullptr );
+
+	if( timeout > 0 )
+	{
+		AddTimeout( current, timeout );
+	}
+
+	bool success = Yield();
+
+	RemoveTimeout( current );
+
+	RemoveIoWait( current );
+
+	ready = current->IoReady();
+
+	current->SetIoReady( false );
+
+	current->SetTimedOut( false );
+
+	if( !success )
+	{
+		current->Unblock();
+
+		ready = false;
+	}
+	else if( !ready && cancelScoped )
+	{
+		PyErr_SetString( PyExc_TimeoutError, "I/O wait timed out" );
+
+		success = false;
+	}
+
+	current->Decref();
+
+	return success;
+#else
+	PyErr_SetString( PyExc_NotImplementedError, "Waiting on file descriptors is only supported on Linux" );
+
+	return false;
+#endif
+}
+
+// Remove the Tasklet from the I/O wait it is parked on
+// Does not release the reference held by the waiting call
+void ScheduleManager::RemoveIoWait( Tasklet* tasklet )
+{
+	int fd = tasklet->IoWaitFd();
+
+	if( fd < 0 )
+	{
+		return;
+	}
+
+	tasklet->SetIoWaitFd( -1 );
+
+	auto iter = m_ioWaits.find( fd );
+
+	if( iter == m_ioWaits.end() )
+	{
+		return;
+	}
+
+	if( iter->second.m_reader == tasklet )
+	{
+		iter->second.m_reader = nullptr;
+	}
+
+	if( iter->second.m_writer == tasklet )
+	{
+		iter->second.m_writer = nullptr;
+	}
+
+	// Failure is ignored, the descriptor may already have been closed
+	UpdateIoRegistration( fd, true );
+
+	if( iter->second.m_reader == nullptr && iter->second.m_writer == nullptr )
+	{
+		m_ioWaits.erase( iter );
+	}
+}
+
+// Wait up to timeout nanoseconds for parked file descriptors to become ready
+// Ready Tasklets are made runnable, 0 polls without blocking and -1 blocks until one is ready
+void ScheduleManager::ProcessIoEvents( long long timeout )
 {
-    return m_switchTrapLevel != 0;
+#ifdef __linux__
+	if( m_epollFd < 0 )
+	{
+		return;
+	}
+
+	int timeoutMs = -1;
+
+	if( timeout >= 0 )
+	{
+		// Round up so a wait never returns before the next timeout is due
+		long long milliseconds = ( timeout + 999999 ) / 1000000;
+
+		timeoutMs = milliseconds > INT_MAX ? INT_MAX : static_cast<int>( milliseconds );
+	}
+
+	const int maxEvents = 64;
+
+	epoll_event events[maxEvents];
+
+	int numberOfEvents = 0;
+
+	if( timeoutMs == 0 )
+	{
+		numberOfEvents = epoll_wait( m_epollFd, events, maxEvents, 0 );
+	}
+	else
+	{
+		Py_BEGIN_ALLOW_THREADS
+
+		numberOfEvents = epoll_wait( m_epollFd, events, maxEvents, timeoutMs );
+
+		Py_END_ALLOW_THREADS
+	}
+
+	for( int i = 0; i < numberOfEvents; i++ )
+	{
+		if( events[i].data.fd == m_wakeupFd )
+		{
+			// Reset the counter, whatever signalled the wakeup is already in place
+			eventfd_t value;
+
+			eventfd_read( m_wakeupFd, &value );
+
+			continue;
+		}
+
+		auto iter = m_ioWaits.find( events[i].data.fd );
+
+		if( iter == m_ioWaits.end() )
+		{
+			continue;
+		}
+
+		// Errors and hangups wake both directions so the waiter sees the failure on its next call
+		Tasklet* reader = ( events[i].events & ( EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR ) ) ? iter->second.m_reader : nullptr;
+
+		Tasklet* writer = ( events[i].events & ( EPOLLOUT | EPOLLHUP | EPOLLERR ) ) ? iter->second.m_writer : nullptr;
+
+		if( reader )
+		{
+			reader->OnIoReady();
+		}
+
+		if( writer )
+		{
+			writer->OnIoReady();
+		}
+	}
+#endif
 }
 
-PyObject* ScheduleManager::SchedulerCallback()
+// Sync the epoll interest set for fd with its parked readers and writers
+bool ScheduleManager::UpdateIoRegistration( int fd, bool registered )
 {
-	return s_schedulerCallback;
+#ifdef __linux__
+	auto iter = m_ioWaits.find( fd );
+
+	epoll_event event = {};
+
+	event.data.fd = fd;
+
+	if( iter != m_ioWaits.end() )
+	{
+		if( iter->second.m_reader )
+		{
+			event.events |= EPOLLIN | EPOLLRDHUP;
+		}
+
+		if( iter->second.m_writer )
+		{
+			event.events |= EPOLLOUT;
+		}
+	}
+
+	if( event.events == 0 )
+	{
+		return !registered || epoll_ctl( m_epollFd, EPOLL_CTL_DEL, fd, &event ) == 0;
+	}
+
+	return epoll_ctl( m_epollFd, registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event ) == 0;
+#else
+	return false;
+#endif
 }
 
-int ScheduleManager::SwitchTrapLevel()
+// Create the epoll instance with the wakeup eventfd registered on it
+// Returns false with errno set on failure
+bool ScheduleManager::CreateEventPoll()
 {
-	return m_switchTrapLevel;
+#ifdef __linux__
+	if( m_epollFd >= 0 )
+	{
+		return true;
+	}
+
+	int epollFd = epoll_create1( EPOLL_CLOEXEC );
+
+	if( epollFd < 0 )
+	{
+		return false;
+	}
+
+	int wakeupFd = eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+
+	if( wakeupFd < 0 )
+	{
+		close( epollFd );
+
+		return false;
+	}
+
+	epoll_event event = {};
+
+	event.events = EPOLLIN;
+
+	event.data.fd = wakeupFd;
+
+	if( epoll_ctl( epollFd, EPOLL_CTL_ADD, wakeupFd, &event ) != 0 )
+	{
+		close( wakeupFd );
+
+		close( epollFd );
+
+		return false;
+	}
+
+	m_epollFd = epollFd;
+
+	m_wakeupFd = wakeupFd;
+
+	return true;
+#else
+	return false;
+#endif
 }
 
-void ScheduleManager::SetSwitchTrapLevel( int level )
+// Block the thread until Wakeup is called, a parked I/O wait becomes ready or a pending timeout expires
+// timeout limits the wait in nanoseconds, -1 waits indefinitely
+void ScheduleManager::WaitForWakeup( long long timeout )
 {
-	m_switchTrapLevel = level;
+	long long wait = TimeUntilNextTimeout();
+
+	if( timeout >= 0 && ( wait < 0 || timeout < wait ) )
+	{
+		wait = timeout;
+	}
+
+#ifdef __linux__
+	if( m_epollFd >= 0 )
+	{
+		// Skip the wait when work arrived before this thread went idle
+		ProcessIoEvents( m_hasPostedTasklets || m_runForeverStopRequested ? 0 : wait );
+
+		ProcessExpiredTimeouts();
+
+		return;
+	}
+#endif
+
+	Py_BEGIN_ALLOW_THREADS
+
+	std::unique_lock<std::mutex> lock( m_wakeupMutex );
+
+	if( wait < 0 )
+	{
+		m_wakeupCondition.wait( lock, [this] { return m_wakeupPending; } );
+	}
+	else
+	{
+		m_wakeupCondition.wait_for( lock, std::chrono::nanoseconds( wait ), [this] { return m_wakeupPending; } );
+	}
+
+	m_wakeupPending = false;
+
+	lock.unlock();
+
+	Py_END_ALLOW_THREADS
+
+	ProcessExpiredTimeouts();
 }
 
-int ScheduleManager::GetNumberOfTaskletsCompletedLastRunWithTimeout()
+// Wake the thread if it is idle in WaitForWakeup, safe to call from any thread
+// A wakeup signalled while the thread is busy makes its next wait return immediately
+void ScheduleManager::Wakeup()
 {
-	return s_numberOfTaskletsCompletedLastRunWithTimeout;
+#ifdef __linux__
+	if( m_wakeupFd >= 0 )
+	{
+		eventfd_write( m_wakeupFd, 1 );
+
+		return;
+	}
+#endif
+
+	{
+		std::lock_guard<std::mutex> lock( m_wakeupMutex );
+
+		m_wakeupPending = true;
+	}
+
+	m_wakeupCondition.notify_one();
 }
 
-int ScheduleManager::GetNumberOfTaskletsSwitchedLastRunWithTimeout()
+// Make a Tasklet runnable from another thread
+// The Tasklet joins the runnables queue the next time this thread runs the scheduler
+void ScheduleManager::PostTasklet( Tasklet* tasklet )
 {
-	return s_numberOfTaskletsSwitchedLastRunWithTimeout;
+	tasklet->Incref();
+
+	{
+		ThreadLockRAII lock( m_postedTaskletsLock );
+
+		m_postedTasklets.push_back( tasklet );
+
+		m_hasPostedTasklets = true;
+	}
+
+	Wakeup();
 }
 
+// Move Tasklets posted by other threads to the back of the runnables queue
+// Must be called on the thread owning this schedule manager
+void ScheduleManager::ProcessPostedTasklets()
+{
+	if( !m_hasPostedTasklets )
+	{
+		return;
+	}
+
+	std::vector<Tasklet*> posted;
 
-void ScheduleManager::RegisterTaskletToThread( Tasklet* tasklet )
+	{
+		ThreadLockRAII lock( m_postedTaskletsLock );
+
+		posted.swap( m_postedTasklets );
+
+		m_hasPostedTasklets = false;
+	}
+
+	for( Tasklet* tasklet : posted )
+	{
+		// Killed since it was posted
+		if( tasklet->IsAlive() )
+		{
+			InsertTasklet( tasklet );
+		}
+
+		tasklet->Decref();
+	}
+}
+
+// Take every Tasklet out of the runnables queue, in queue order, to be attached again later
+// The references held by the queue are handed to tasklets
+// Blocked Tasklets are not in the queue and keep their place on whatever they are blocked on
+bool ScheduleManager::DetachQueue( std::vector<Tasklet*>& tasklets )
 {
-	m_taskletsOnSchedulerThread.insert( tasklet );
+	if( PyThread_get_thread_ident() != m_threadId || GetCurrentTasklet() != GetMainTasklet() )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "detach_queue can only be called from the main tasklet of the thread owning the schedule manager" );
+
+		return false;
+	}
+
+	ProcessPostedTasklets();
+
+	tasklets.reserve( tasklets.size() + m_numberOfTaskletsInQueue );
+
+	Tasklet* mainTasklet = GetMainTasklet();
+
+	Tasklet* tasklet = mainTasklet->Next();
+
+	while( !IsQueueEnd( tasklet ) )
+	{
+		Tasklet* next = tasklet->Next();
+
+		tasklet->SetNext( nullptr );
+
+		tasklet->SetPrevious( nullptr );
+
+		if( tasklet->GetFairShareQueue() )
+		{
+			UnlinkFairShareTasklet( tasklet );
+		}
+
+		tasklet->SetScheduled( false );
+
+		tasklets.push_back( tasklet );
+
+		tasklet = next;
+	}
+
+	mainTasklet->SetNext( mainTasklet );
+
+	mainTasklet->SetPrevious( mainTasklet );
+
+	m_firstQueuedAtBackThisFrame = nullptr;
+
+	m_numberOfTaskletsInQueue = 0;
+
+	return true;
 }
 
-void ScheduleManager::UnregisterTaskletFromThread( Tasklet* tasklet )
+// Append Tasklets taken by DetachQueue to the back of the runnables queue, keeping their order
+// Tasklets from another thread's schedule manager are rebound to this one, which is only possible before they first run
+// Tasklets killed, queued or run since they were detached are dropped
+// On failure nothing is attached and tasklets is left unchanged, on success the references are taken and tasklets is emptied
+bool ScheduleManager::AttachQueue( std::vector<Tasklet*>& tasklets )
 {
-	if( m_taskletsOnSchedulerThread.find( tasklet ) != m_taskletsOnSchedulerThread.end() )
+	if( PyThread_get_thread_ident() != m_threadId )
 	{
-		m_taskletsOnSchedulerThread.erase( tasklet );
+		PyErr_SetString( PyExc_RuntimeError, "attach_queue can only be called from the thread owning the schedule manager" );
+
+		return false;
+	}
+
+	Tasklet* current = GetCurrentTasklet();
+
+	auto attachable = [current]( Tasklet* tasklet ) {
+		return tasklet->IsAlive() && !tasklet->IsScheduled() && !tasklet->IsBlocked() && tasklet != current;
+	};
+
+	for( Tasklet* tasklet : tasklets )
+	{
+		if( attachable( tasklet ) && tasklet->GetScheduleManager() != this && !tasklet->IsUnstarted() )
+		{
+			PyErr_SetString( PyExc_RuntimeError, "Only tasklets that have not started can be attached to another thread" );
+
+			return false;
+		}
+	}
+
+	Tasklet* first = nullptr;
+
+	Tasklet* last = nullptr;
+
+	int numberOfTasklets = 0;
+
+	for( Tasklet* tasklet : tasklets )
+	{
+		if( !attachable( tasklet ) )
+		{
+			tasklet->Decref();
+
+			continue;
+		}
+
+		ScheduleManager* previousScheduleManager = tasklet->GetScheduleManager();
+
+		if( previousScheduleManager != this )
+		{
+			previousScheduleManager->UnregisterTaskletFromThread( tasklet );
+
+			tasklet->SetScheduleManager( this );
+
+			RegisterTaskletToThread( tasklet );
+		}
+
+		tasklet->SetNext( nullptr );
+
+		tasklet->SetPrevious( last );
+
+		if( last == nullptr )
+		{
+			first = tasklet;
+		}
+		else
+		{
+			last->SetNext( tasklet );
+		}
+
+		last = tasklet;
+
+		numberOfTasklets++;
+	}
+
+	tasklets.clear();
+
+	if( first != nullptr )
+	{
+		InsertTaskletChain( first, last, numberOfTasklets );
 	}
+
+	return true;
 }
 
-void ScheduleManager::ClearThreadTasklets()
+// Run the scheduler until StopRunForever is called, sleeping while nothing is runnable
+// idleWait limits each idle period in nanoseconds, -1 sleeps until woken
+bool ScheduleManager::RunForever( long long idleWait )
 {
-    // Tasklets will be removed from being scheduled if their ScheduleManger is set to null
-    // Tasklets without a schedule manager is an invalid state so Tasklets are killed if this is about to happen
-	// It is possible that this becomes and infinate loop
-	// For example if the python code catches the TaskletExit/generic exceptionscheduleManager->Decref(
-	// as part of an inifinate loop
-	// If this is the case carbon-scheduler will start to leak scheduleManagers and threads
-	// This could be noticable through metrics
-	// We could put a limit on the pumping of below and just instead opt to leak Tasklets/arguments
+	if( GetCurrentTasklet() != GetMainTasklet() )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "run_forever can only be called from the main tasklet" );
 
-	auto taskletIter = m_taskletsOnSchedulerThread.begin();
+		return false;
+	}
 
-	while( taskletIter != m_taskletsOnSchedulerThread.end() )
+	while( !m_runForeverStopRequested )
 	{
-		Tasklet* t = *taskletIter;
+		if( !Run() )
+		{
+			m_runForeverStopRequested = false;
 
-		// Disassociate tasklet from thread
-		t->SetScheduleManager( nullptr );
+			return false;
+		}
+
+		if( !m_runForeverStopRequested && GetCachedTaskletCount() <= 1 )
+		{
+			WaitForWakeup( idleWait );
+		}
+
+		if( PyErr_CheckSignals() < 0 )
+		{
+			m_runForeverStopRequested = false;
 
-        taskletIter = m_taskletsOnSchedulerThread.begin();
+			return false;
+		}
 	}
+
+	m_runForeverStopRequested = false;
+
+	return true;
 }
 
-unsigned long ScheduleManager::ThreadId() const
+// Request RunForever returns once the current pass over the runnables queue completes
+// May be called from any thread
+void ScheduleManager::StopRunForever()
 {
-	return m_threadId;
-}
\ No newline at end of file
+	m_runForeverStopRequested = true;
+
+	Wakeup();
+}
@@ -22,10 +22,19 @@
 #include "stdafx.h"
 
 #include "PythonCppType.h"
+#include "ThreadLock.h"
 
 #include <map>
+#include <string>
+#include <vector>
+#include <memory>
 #include <chrono>
 #include <unordered_set>
+#include <unordered_map>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 
 typedef int( schedule_hook_func )( struct PyTaskletObject* from, struct PyTaskletObject* to );  // TODO remove redef
 
@@ -40,6 +49,62 @@ enum class RunType
 
 class Tasklet;
 
+// The queued Tasklets of one group in fair share mode, linked in queue order through the Tasklets
+struct FairShareQueue
+{
+    std::string m_group;
+
+    double m_weight = 1.0;
+
+    // Run time in nanoseconds the group may still use, kept while the group is queued or owes run time
+    long long m_deficit = 0;
+
+    Tasklet* m_first = nullptr; // Weak ref
+
+    Tasklet* m_last = nullptr; // Weak ref
+
+    // Weak ref, as ScheduleManager::m_firstQueuedAtBackThisFrame but within the group
+    Tasklet* m_firstQueuedAtBackThisFrame = nullptr;
+
+    bool m_active = false; // Has a place in the turn order
+
+    long long m_runTimeLastRunWithTimeout = 0; // Nanoseconds the group ran for during the last run with a timeout
+
+    bool m_ranLastRunWithTimeout = false;
+};
+
+// Scheduler counters for a single thread
+// Aligned to a cache line so threads updating their own counters never contend
+// Only the owning thread writes a counter, other than the active Tasklet count which is
+// decremented by whichever thread releases the Tasklet
+struct alignas( 64 ) ThreadStatistics
+{
+    std::atomic<long> m_allTimeTaskletCount{ 0 };
+
+    std::atomic<long> m_activeTaskletCount{ 0 };
+
+    std::atomic<long> m_taskletsCompletedLastRunWithTimeout{ 0 };
+
+    std::atomic<long> m_taskletsSwitchedLastRunWithTimeout{ 0 };
+
+    // Set once the owning thread has exited, the block is recycled when its active Tasklet count is also zero
+    std::atomic<bool> m_threadExited{ false };
+
+    // Increment a counter only written by the owning thread without a locked instruction
+    static void Increment( std::atomic<long>& counter )
+    {
+        counter.store( counter.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+    }
+};
+
+// Marks the counters of the calling thread as exited when the thread ends
+struct ThreadStatisticsOwner
+{
+    ThreadStatistics* m_statistics = nullptr;
+
+    ~ThreadStatisticsOwner();
+};
+
 class ScheduleManager : public PythonCppType
 {
 public:
@@ -61,9 +126,9 @@ public:
 
     void InsertTasklet( Tasklet* tasklet );
 
-    int GetCachedTaskletCount();
+    void InsertTaskletChain( Tasklet* first, Tasklet* last, int numberOfTasklets );
 
-    int GetCalculatedTaskletCount();
+    int GetCachedTaskletCount();
 
     bool Schedule( RescheduleType position, bool remove = false );
 
@@ -89,9 +154,17 @@ public:
 
     void SetSwitchTrapLevel( int level );
 
-    static int GetNumberOfTaskletsCompletedLastRunWithTimeout();
+    int GetNumberOfTaskletsCompletedLastRunWithTimeout() const;
+
+    int GetNumberOfTaskletsSwitchedLastRunWithTimeout() const;
+
+    ThreadStatistics* Statistics() const;
 
-    static int GetNumberOfTaskletsSwitchedLastRunWithTimeout();
+    static ThreadStatistics* GetThreadStatistics();
+
+    static void RecycleThreadStatistics( ThreadStatistics* statistics );
+
+    static long AggregateStatistic( std::atomic<long> ThreadStatistics::*statistic );
 
     void RegisterTaskletToThread( Tasklet* tasklet );
 
@@ -99,8 +172,74 @@ public:
 
 	void ClearThreadTasklets();
 
+    bool KillTasklets( const std::vector<Tasklet*>& tasklets, bool pending );
+
+    bool KillAllTasklets( bool pending );
+
 	unsigned long ThreadId() const;
 
+    void AddTimeout( Tasklet* tasklet, long long timeout );
+
+    void RemoveTimeout( Tasklet* tasklet );
+
+    void ProcessExpiredTimeouts();
+
+    bool ApplyCancelDeadline( Tasklet* tasklet, long long& timeout ) const;
+
+    bool WaitForEvents( long long timeout = -1 );
+
+    long long TimeUntilNextTimeout() const;
+
+    bool WaitForIo( int fd, bool writable, long long timeout, bool& ready );
+
+    void RemoveIoWait( Tasklet* tasklet );
+
+    void ProcessIoEvents( long long timeout );
+
+    void ProcessExternalEvents();
+
+    bool CanHandoffTo( Tasklet* tasklet );
+
+    bool HandoffTo( Tasklet* tasklet );
+
+    Tasklet* SwitchedBackTasklet( Tasklet* tasklet ) const;
+
+    bool RunForever( long long idleWait );
+
+    void StopRunForever();
+
+    void Wakeup();
+
+    void PostTasklet( Tasklet* tasklet );
+
+    void ProcessPostedTasklets();
+
+    bool DetachQueue( std::vector<Tasklet*>& tasklets );
+
+    bool AttachQueue( std::vector<Tasklet*>& tasklets );
+
+    void SetFairShare( bool enabled );
+
+    bool FairShare() const;
+
+    void SetGroupWeight( const std::string& group, double weight );
+
+    void RegroupFairShareTasklet( Tasklet* tasklet );
+
+    const std::unordered_map<std::string, FairShareQueue>& FairShareQueues() const;
+
+    void SetFrameBudget( bool enabled );
+
+    bool FrameBudget() const;
+
+    long long FrameDebt() const;
+
+    void SetAdaptiveBatching( bool enabled, int maximumBatchSize );
+
+    bool AdaptiveBatching() const;
+
+    int MaximumBatchSize() const;
+
 
 private:
 
@@ -110,6 +249,48 @@ private:
 
     void OnSwitch();
 
+    bool RunFlat();
+
+    void UpdateRunLimits();
+
+    void ReinsertRescheduledTasklet( Tasklet* currentTasklet );
+
+    bool UpdateIoRegistration( int fd, bool registered );
+
+    bool CreateEventPoll();
+
+    void WaitForWakeup( long long timeout );
+
+    void InsertTaskletAfter( Tasklet* position, Tasklet* tasklet );
+
+    void LinkTaskletAfter( Tasklet* position, Tasklet* tasklet );
+
+    void UnlinkTasklet( Tasklet* tasklet );
+
+    Tasklet* RunNextPosition();
+
+    bool IsQueueEnd( Tasklet* tasklet ) const;
+
+    Tasklet* NextFairShareTasklet();
+
+    long long FairShareQuantum( const FairShareQueue* queue ) const;
+
+    void CreditFairShareRounds();
+
+    void LinkFairShareTasklet( Tasklet* tasklet, bool atBack );
+
+    void UnlinkFairShareTasklet( Tasklet* tasklet );
+
+    void LinkFairShareTaskletBefore( Tasklet* tasklet, FairShareQueue* queue, Tasklet* before );
+
+    void MarkFairShareQueuedAtBack( Tasklet* tasklet );
+
+    bool SwitchToChargingGroup( Tasklet* tasklet );
+
+    void PreferSkippedTasklets();
+
+    void ClearQueuedAtBackThisFrame();
+
 public:
 
     inline static PyTypeObject* s_callableWrapperType;
@@ -118,7 +299,7 @@ public:
 
     inline static PyTypeObject* s_scheduleManagerType;
 
-    inline static bool s_useNestedTasklets = true;
+    inline static std::atomic<bool> s_useNestedTasklets{ true };
     
     inline static PyObject* m_scheduleManagerThreadKey = nullptr;
 
@@ -126,19 +307,21 @@ private:
 
     unsigned long m_threadId;
 
+    // Heads the runnables queue, a circular list linked through Tasklet Next/Previous
+    // An empty queue is the scheduler Tasklet linked to itself and its Previous is the back
     Tasklet* m_schedulerTasklet;
 
     Tasklet* m_currentTasklet; //Weak ref
 
-    Tasklet* m_previousTasklet; //Weak ref
-
     long m_switchTrapLevel;
 
     // This is global, not per schedule manager
 	inline static PyObject* s_schedulerCallback = nullptr;
 
+    inline static ThreadLock s_schedulerCallbackLock;
+
     // This is global, not per schedule manager 
-    inline static schedule_hook_func* s_schedulerFastCallback = nullptr; 
+    inline static std::atomic<schedule_hook_func*> s_schedulerFastCallback{ nullptr }; 
 
     RunType m_runType;
 
@@ -154,15 +337,107 @@ private:
 
     int m_numberOfTaskletsInQueue;
 
-    static inline long s_numberOfTaskletsCompletedLastRunWithTimeout = 0;
+    ThreadStatistics* m_statistics; // Owned by s_threadStatistics
+
+    static inline std::mutex s_threadStatisticsMutex;
+
+    // Never released so the counts of Tasklets that outlive their thread stay valid
+    // A block is reused by a new thread once its thread has exited and its last Tasklet has been released
+    static inline std::vector<std::unique_ptr<ThreadStatistics>> s_threadStatistics;
 
-    static inline long s_numberOfTaskletsSwitchedLastRunWithTimeout = 0;
+    static inline std::vector<ThreadStatistics*> s_freeThreadStatistics;
 
-    static inline long s_numberOfActiveScheduleManagers = 0;
+    static inline long s_recycledAllTimeTaskletCount = 0; // All time Tasklet counts of recycled blocks
+
+    static inline thread_local ThreadStatisticsOwner t_threadStatistics;
+
+    static inline std::atomic<long> s_numberOfActiveScheduleManagers{ 0 };
 
     std::unordered_set<Tasklet*> m_taskletsOnSchedulerThread;
 
-	static inline std::map<long, ScheduleManager*> s_closingScheduleManagers;
+    // Tasklets attached from another thread unregister from their previous schedule manager
+    ThreadLock m_taskletsOnSchedulerThreadLock;
+
+	// Only ever consulted by the thread being closed so needs no locking
+	static inline thread_local ScheduleManager* t_closingScheduleManager = nullptr;
+
+    // Blocked Tasklets waiting with a timeout, ordered by deadline
+    std::multimap<std::chrono::steady_clock::time_point, Tasklet*> m_timeouts;
+
+    // Tasklets parked waiting for a file descriptor to become readable or writable
+    struct IoWait
+    {
+        Tasklet* m_reader = nullptr; // Weak ref, held by the waiting call
+
+        Tasklet* m_writer = nullptr; // Weak ref, held by the waiting call
+    };
+
+    std::unordered_map<int, IoWait> m_ioWaits;
+
+    int m_epollFd; // Created in the constructor, -1 if unavailable
+
+    // Signals an idle thread that it has work, written from other threads
+    std::atomic<int> m_wakeupFd;
+
+    // Used in place of the wakeup file descriptor where eventfd is unavailable or failed
+    std::mutex m_wakeupMutex;
+
+    std::condition_variable m_wakeupCondition;
+
+    bool m_wakeupPending;
+
+    // Tasklets made runnable by other threads, each holding a reference
+    // Moved to the runnables queue by the owning thread
+    std::vector<Tasklet*> m_postedTasklets;
+
+    ThreadLock m_postedTaskletsLock;
+
+    std::atomic<bool> m_hasPostedTasklets;
+
+    std::atomic<bool> m_runForeverStopRequested;
+
+    Tasklet* m_flatRunTasklet; // Weak ref, the Tasklet RunFlat last switched to
+
+    Tasklet* m_flatHandoffTasklet; // Weak ref, the Tasklet control was last handed off to directly
+
+    // Fair share mode splits the budget of a run with a timeout between Tasklet groups by deficit round robin
+    bool m_fairShare;
+
+    // Keyed by group, node based so Tasklets can point at their queue
+    // Entries are kept for the life of the manager so a queue outlives a switch to one of its Tasklets
+    std::unordered_map<std::string, FairShareQueue> m_fairShareQueues;
+
+    // Turn order of the groups, the front group has the current turn
+    // A group that empties keeps its place until its turn comes round
+    std::deque<FairShareQueue*> m_fairShareTurns;
+
+    bool m_fairShareTurnStarted;
+
+    double m_fairShareTurnsWeight; // Total weight of the groups in the turn order
+
+    std::unordered_map<std::string, double> m_groupWeights;
+
+    // Frame budget mode treats runs with a timeout as consecutive frames
+    // Overrun in one frame is taken from the budget of the next
+    bool m_frameBudget;
+
+    long long m_frameDebt;
+
+    // Stamped on Tasklets as they are queued, Tasklets with an older stamp were skipped by the last frame
+    unsigned long long m_frameNumber;
+
+    // Weak ref, the front most of the Tasklets queued at the back during this frame
+    // Everything behind it in the queue is new to the frame
+    Tasklet* m_firstQueuedAtBackThisFrame;
+
+    // Adaptive batching reads the clock once per batch of Tasklets in runs with a timeout
+    bool m_adaptiveBatching;
+
+    int m_maximumBatchSize;
+
+    long long m_taskletsStartedThisRun; // Tasklets started from the main tasklet in the current run with a timeout
+
+    int m_timeLimitChecksToSkip;
     
 };
 
@@ -5,16 +5,19 @@
 #include "Scheduler.h"
 
 #include <string>
+#include <cstring>
 
 #include <greenlet.h>
 
 #include "ScheduleManager.h"
 #include "GILRAII.h"
+#include "Utils.h"
 
 //Types
 #include "PyTasklet.cpp"
 #include "PyChannel.cpp"
 #include "PyScheduleManager.cpp"
+#include "PySynchronisationPrimitives.cpp"
 
 const char* g_moduleName = "carbon-scheduler";
 
@@ -147,7 +150,8 @@ static PyObject*
 {
 	ScheduleManager* currentScheduler = ScheduleManager::GetThreadScheduleManager();
 
-	PyObject* ret = PyLong_FromLong( currentScheduler->GetCalculatedTaskletCount() );
+	// The runnables queue keeps its own length, so there is nothing left to walk
+	PyObject* ret = PyLong_FromLong( currentScheduler->GetCachedTaskletCount() );
 
 	return ret;
 }
@@ -191,11 +195,27 @@ static PyObject*
 }
 
 static PyObject*
-	SchedulerRun( PyObject* self, PyObject* Py_UNUSED( ignored ) )
+	SchedulerRun( PyObject* self, PyObject* args, PyObject* kwds )
 {
+	const char* kwlist[] = { "timeout", NULL };
+
+	PyObject* timeoutArgument = Py_None;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "|O:run", (char**)kwlist, &timeoutArgument ) )
+	{
+		return nullptr;
+	}
+
+	long long timeout;
+
+	if( !TimeoutFromPyObject( timeoutArgument, timeout ) )
+	{
+		return nullptr;
+	}
+
 	ScheduleManager* currentScheduler = ScheduleManager::GetThreadScheduleManager();
 
-    bool ret = currentScheduler->Run();
+    bool ret = timeout < 0 ? currentScheduler->Run() : currentScheduler->RunTaskletsForTime( timeout );
 
     if (ret)
     {
@@ -209,6 +229,154 @@ static PyObject*
     }
 }
 
+static PyObject*
+	SchedulerRunForever( PyObject* self, PyObject* args, PyObject* kwds )
+{
+	const char* kwlist[] = { "idle_wait", NULL };
+
+	PyObject* idleWaitArgument = Py_None;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "|O:run_forever", (char**)kwlist, &idleWaitArgument ) )
+	{
+		return nullptr;
+	}
+
+	long long idleWait;
+
+	if( !TimeoutFromPyObject( idleWaitArgument, idleWait ) )
+	{
+		return nullptr;
+	}
+
+	ScheduleManager* currentScheduler = ScheduleManager::GetThreadScheduleManager();
+
+	if( !currentScheduler->RunForever( idleWait ) )
+	{
+		return nullptr;
+	}
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyObject*
+	SchedulerStopRunForever( PyObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	ScheduleManager* currentScheduler = ScheduleManager::GetThreadScheduleManager();
+
+	currentScheduler->StopRunForever();
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
+static PyObject*
+	SchedulerTimeUntilNextTimeout( PyObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	ScheduleManager* currentScheduler = ScheduleManager::GetThreadScheduleManager();
+
+	long long timeUntilNextTimeout = currentScheduler->TimeUntilNextTimeout();
+
+	if( timeUntilNextTimeout < 0 )
+	{
+		Py_IncRef( Py_None );
+
+		return Py_None;
+	}
+
+	return PyFloat_FromDouble( static_cast<double>( timeUntilNextTimeout ) / 1e9 );
+}
+
+static PyObject*
+	SchedulerWaitForEvents( PyObject* self, PyObject* args, PyObject* kwds )
+{
+	const char* kwlist[] = { "timeout", NULL };
+
+	PyObject* timeoutArgument = Py_None;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "|O:wait_for_events", (char**)kwlist, &timeoutArgument ) )
+	{
+		return nullptr;
+	}
+
+	long long timeout;
+
+	if( !TimeoutFromPyObject( timeoutArgument, timeout ) )
+	{
+		return nullptr;
+	}
+
+	ScheduleManager* currentScheduler = ScheduleManager::GetThreadScheduleManager();
+
+	// Only idle when there is nothing to run, +1 is the main tasklet
+	if( currentScheduler->GetCachedTaskletCount() <= 1 )
+	{
+		currentScheduler->WaitForEvents( timeout );
+	}
+
+	return PyBool_FromLong( currentScheduler->GetCachedTaskletCount() > 1 );
+}
+
+static PyObject*
+	SchedulerWaitForFileDescriptor( PyObject* args, PyObject* kwds, bool writable )
+{
+	const char* kwlist[] = { "fd", "timeout", NULL };
+
+	PyObject* fdArgument;
+
+	PyObject* timeoutArgument = Py_None;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, writable ? "O|O:wait_writable" : "O|O:wait_readable", (char**)kwlist, &fdArgument, &timeoutArgument ) )
+	{
+		return nullptr;
+	}
+
+	int fd = PyObject_AsFileDescriptor( fdArgument );
+
+	if( fd < 0 )
+	{
+		return nullptr;
+	}
+
+	long long timeout;
+
+	if( !TimeoutFromPyObject( timeoutArgument, timeout ) )
+	{
+		return nullptr;
+	}
+
+	ScheduleManager* currentScheduler = ScheduleManager::GetThreadScheduleManager();
+
+	bool ready = false;
+
+	if( !currentScheduler->WaitForIo( fd, writable, timeout, ready ) )
+	{
+		return nullptr;
+	}
+
+	return PyBool_FromLong( ready );
+}
+
+static PyObject*
+	SchedulerWaitReadable( PyObject* self, PyObject* args, PyObject* kwds )
+{
+	return SchedulerWaitForFileDescriptor( args, kwds, false );
+}
+
+static PyObject*
+	SchedulerWaitWritable( PyObject* self, PyObject* args, PyObject* kwds )
+{
+	return SchedulerWaitForFileDescriptor( args, kwds, true );
+}
+
+static PyObject*
+	SchedulerTlsSlot( PyObject* self, PyObject* Py_UNUSED( ignored ) )
+{
+	return PyObject_CallNoArgs( reinterpret_cast<PyObject*>( &TaskletLocalSlotType ) );
+}
+
 static PyObject*
 	SchedulerRunNTasklets( PyObject* self, PyObject* args )
 {
@@ -438,6 +606,201 @@ static PyObject*
 	return PyLong_FromLong( numberOfActiveTasklets );
 }
 
+static PyObject*
+	SchedulerSelect( PyObject* self, PyObject* args, PyObject* kwds )
+{
+	const char* kwlist[] = { "cases", "timeout", NULL };
+
+	PyObject* casesArgument;
+
+	PyObject* timeoutArgument = Py_None;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "O|O:select", (char**)kwlist, &casesArgument, &timeoutArgument ) )
+	{
+		return nullptr;
+	}
+
+	long long timeout;
+
+	if( !TimeoutFromPyObject( timeoutArgument, timeout ) )
+	{
+		return nullptr;
+	}
+
+	// Holds the channels and values alive for the duration of the select
+	PyObject* caseSequence = PySequence_Fast( casesArgument, "cases must be a sequence of (channel, 'recv') or (channel, 'send', value) tuples" );
+
+	if( !caseSequence )
+	{
+		return nullptr;
+	}
+
+	Py_ssize_t numberOfCases = PySequence_Fast_GET_SIZE( caseSequence );
+
+	std::vector<SelectCase> cases( numberOfCases );
+
+	for( Py_ssize_t i = 0; i < numberOfCases; i++ )
+	{
+		PyObject* caseObject = PySequence_Fast_GET_ITEM( caseSequence, i );
+
+		PyObject* channelObject = nullptr;
+
+		const char* operation = nullptr;
+
+		PyObject* value = nullptr;
+
+		if( !PyTuple_Check( caseObject ) || !PyArg_ParseTuple( caseObject, "Os|O:select", &channelObject, &operation, &value ) )
+		{
+			if( !PyErr_Occurred() )
+			{
+				PyErr_SetString( PyExc_TypeError, "select cases must be (channel, 'recv') or (channel, 'send', value) tuples" );
+			}
+
+			Py_DecRef( caseSequence );
+
+			return nullptr;
+		}
+
+		if( !PyObject_TypeCheck( channelObject, &ChannelType ) || !PyChannelObjectIsValid( reinterpret_cast<PyChannelObject*>( channelObject ) ) )
+		{
+			if( !PyErr_Occurred() )
+			{
+				PyErr_SetString( PyExc_TypeError, "select case must refer to a channel" );
+			}
+
+			Py_DecRef( caseSequence );
+
+			return nullptr;
+		}
+
+		cases[i].m_channel = reinterpret_cast<PyChannelObject*>( channelObject )->m_implementation;
+
+		if( strcmp( operation, "recv" ) == 0 && value == nullptr )
+		{
+			cases[i].m_direction = ChannelDirection::RECEIVER;
+		}
+		else if( strcmp( operation, "send" ) == 0 && value != nullptr )
+		{
+			cases[i].m_direction = ChannelDirection::SENDER;
+
+			cases[i].m_value = value;
+		}
+		else
+		{
+			PyErr_SetString( PyExc_ValueError, "select case operation must be (channel, 'recv') or (channel, 'send', value)" );
+
+			Py_DecRef( caseSequence );
+
+			return nullptr;
+		}
+	}
+
+	int selectedIndex = -1;
+
+	PyObject* received = nullptr;
+
+	bool result = Channel::Select( cases, timeout, selectedIndex, received );
+
+	Py_DecRef( caseSequence );
+
+	if( !result )
+	{
+		return nullptr;
+	}
+
+	if( selectedIndex < 0 )
+	{
+		Py_IncRef( Py_None );
+
+		return Py_None;
+	}
+
+	if( received == nullptr )
+	{
+		Py_IncRef( Py_None );
+
+		received = Py_None;
+	}
+
+	return Py_BuildValue( "(iN)", selectedIndex, received );
+}
+
+static PyObject*
+	SchedulerKillAll( PyObject* self, PyObject* args, PyObject* kwds )
+{
+	const char* kwlist[] = { "tasklets", "pending", NULL };
+
+	PyObject* taskletsArgument = Py_None;
+
+	int pending = 1;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "|Op:kill_all", (char**)kwlist, &taskletsArgument, &pending ) )
+	{
+		return nullptr;
+	}
+
+	ScheduleManager* currentScheduler = ScheduleManager::GetThreadScheduleManager();
+
+	bool result = false;
+
+	if( taskletsArgument == Py_None )
+	{
+		result = currentScheduler->KillAllTasklets( pending );
+	}
+	else
+	{
+		// Holds the tasklets alive for the duration of the kill
+		PyObject* taskletSequence = PySequence_Fast( taskletsArgument, "tasklets must be an iterable of tasklets" );
+
+		if( !taskletSequence )
+		{
+			return nullptr;
+		}
+
+		Py_ssize_t numberOfTasklets = PySequence_Fast_GET_SIZE( taskletSequence );
+
+		std::vector<Tasklet*> tasklets;
+
+		tasklets.reserve( numberOfTasklets );
+
+		for( Py_ssize_t i = 0; i < numberOfTasklets; i++ )
+		{
+			PyObject* taskletObject = PySequence_Fast_GET_ITEM( taskletSequence, i );
+
+			if( !PyObject_TypeCheck( taskletObject, &TaskletType ) )
+			{
+				PyErr_SetString( PyExc_TypeError, "kill_all expects tasklets" );
+
+				Py_DecRef( taskletSequence );
+
+				return nullptr;
+			}
+
+			if( !PyTaskletObjectIsValid( reinterpret_cast<PyTaskletObject*>( taskletObject ) ) )
+			{
+				Py_DecRef( taskletSequence );
+
+				return nullptr;
+			}
+
+			tasklets.push_back( reinterpret_cast<PyTaskletObject*>( taskletObject )->m_implementation );
+		}
+
+		result = currentScheduler->KillTasklets( tasklets, pending );
+
+		Py_DecRef( taskletSequence );
+	}
+
+	if( !result )
+	{
+		return nullptr;
+	}
+
+	Py_IncRef( Py_None );
+
+	return Py_None;
+}
+
 void ModuleDestructor( void* )
 {
     // Clear callbacks
@@ -585,6 +948,37 @@ extern "C"
 		return tasklet->m_implementation->GetContext().data();
     }
 
+    /// @brief Reserve a tasklet-local storage slot shared by all tasklets
+	/// @return index of the new slot
+    static int PyTasklet_AllocateLocalSlot()
+    {
+		GILRAII gil;
+		return Tasklet::AllocateLocalSlot();
+    }
+
+    /// @brief Get the value a tasklet has stored in a tasklet-local storage slot
+	/// @param tasklet to read from, python object type derived from PyTaskletType
+	/// @param slot index returned by PyTasklet_AllocateLocalSlot
+	/// @return the stored value or NULL if the slot is unset, no exception is set
+	/// @note Returns a borrowed reference
+    static PyObject* PyTasklet_GetLocal( PyTaskletObject* tasklet, int slot )
+    {
+		GILRAII gil;
+		return tasklet->m_implementation->GetLocal( slot );
+    }
+
+    /// @brief Store a value in a tasklet-local storage slot
+	/// @param tasklet to store on, python object type derived from PyTaskletType
+	/// @param slot index returned by PyTasklet_AllocateLocalSlot
+	/// @param value to store, NULL clears the slot
+	/// @exception Raises ValueError if slot has not been allocated
+	/// @return 0 on success, -1 on failure
+    static int PyTasklet_SetLocal( PyTaskletObject* tasklet, int slot, PyObject* value )
+    {
+		GILRAII gil;
+		return tasklet->m_implementation->SetLocal( slot, value ) ? 0 : -1;
+    }
+
 	// Channel functions
 
     /// @brief Creates new channel.
@@ -981,7 +1375,7 @@ extern "C"
 	{
 		GILRAII gil;
 
-		return ScheduleManager::GetNumberOfTaskletsCompletedLastRunWithTimeout();
+		return ScheduleManager::GetThreadScheduleManager()->GetNumberOfTaskletsCompletedLastRunWithTimeout();
 	}
 
     /// @brief Get active number of Tasklets switched last run with timeout.
@@ -990,7 +1384,31 @@ extern "C"
 	{
 		GILRAII gil;
 
-		return ScheduleManager::GetNumberOfTaskletsSwitchedLastRunWithTimeout();
+		return ScheduleManager::GetThreadScheduleManager()->GetNumberOfTaskletsSwitchedLastRunWithTimeout();
+	}
+
+    /// @brief Get the counters of the calling thread's ScheduleManager.
+	/// @param statistics filled in with Tasklets created on this thread and the last run with timeout on this thread
+	static void PyScheduler_GetThreadStatistics( SchedulerStatistics* statistics )
+	{
+		GILRAII gil;
+
+		ThreadStatistics* threadStatistics = ScheduleManager::GetThreadScheduleManager()->Statistics();
+
+		statistics->allTimeTaskletCount = threadStatistics->m_allTimeTaskletCount.load( std::memory_order_relaxed );
+		statistics->activeTaskletCount = threadStatistics->m_activeTaskletCount.load( std::memory_order_relaxed );
+		statistics->taskletsCompletedLastRunWithTimeout = threadStatistics->m_taskletsCompletedLastRunWithTimeout.load( std::memory_order_relaxed );
+		statistics->taskletsSwitchedLastRunWithTimeout = threadStatistics->m_taskletsSwitchedLastRunWithTimeout.load( std::memory_order_relaxed );
+	}
+
+    /// @brief Get the counters of every thread added together.
+	/// @param statistics filled in with process totals, the last run with timeout values are summed over each thread's last run
+	static void PyScheduler_GetProcessStatistics( SchedulerStatistics* statistics )
+	{
+		statistics->allTimeTaskletCount = ScheduleManager::AggregateStatistic( &ThreadStatistics::m_allTimeTaskletCount );
+		statistics->activeTaskletCount = ScheduleManager::AggregateStatistic( &ThreadStatistics::m_activeTaskletCount );
+		statistics->taskletsCompletedLastRunWithTimeout = ScheduleManager::AggregateStatistic( &ThreadStatistics::m_taskletsCompletedLastRunWithTimeout );
+		statistics->taskletsSwitchedLastRunWithTimeout = ScheduleManager::AggregateStatistic( &ThreadStatistics::m_taskletsSwitchedLastRunWithTimeout );
 	}
     
 
@@ -1043,7 +1461,7 @@ static PyMethodDef SchedulerMethods[] = {
 
 	{ "calculateruncount",
         (PyCFunction)SchedulerCalculateRunCount,
-        METH_NOARGS, "Calculate number of currently runnable tasklets. \n\n\
+        METH_NOARGS, "Calculate number of currently runnable tasklets, the same count as getruncount. \n\n\
             :return: Calculated number of runnable tasklets \n\
             :rtype: Int." },
 
@@ -1059,8 +1477,68 @@ static PyMethodDef SchedulerMethods[] = {
 
 	{ "run",
         (PyCFunction)SchedulerRun,
+        METH_VARARGS | METH_KEYWORDS,
+        "Run scheduler to end of run queue. \n\n\
+            :param timeout: Optional time budget in seconds, at least one Tasklet is always run \n\
+            :type timeout: Float or None" },
+
+	{ "run_forever",
+        (PyCFunction)SchedulerRunForever,
+        METH_VARARGS | METH_KEYWORDS,
+        "Run the scheduler until stop_run_forever is called, sleeping while no tasklets are runnable. \n\n\
+            The thread is woken by tasklets inserted from other threads, expiring timeouts and ready file descriptors. \n\n\
+            :param idle_wait: Optional maximum time in seconds to sleep before checking again, None sleeps until woken \n\
+            :type idle_wait: Float or None" },
+
+	{ "stop_run_forever",
+        (PyCFunction)SchedulerStopRunForever,
+        METH_NOARGS,
+        "Stop run_forever on this thread once the current pass over the run queue completes." },
+
+	{ "time_until_next_timeout",
+        (PyCFunction)SchedulerTimeUntilNextTimeout,
+        METH_NOARGS,
+        "Get the time until the earliest pending timeout of a blocked Tasklet on this thread expires. \n\n\
+            :return: Time in seconds or None if no timeouts are pending \n\
+            :rtype: Float or None" },
+
+	{ "wait_for_events",
+        (PyCFunction)SchedulerWaitForEvents,
+        METH_VARARGS | METH_KEYWORDS,
+        "Block the thread while no tasklets are runnable until a pending timeout expires or a file descriptor waited on becomes ready. \n\n\
+            Returns immediately if tasklets are already runnable or nothing is pending. \n\n\
+            :param timeout: Optional maximum time to block in seconds \n\
+            :type timeout: Float or None \n\
+            :return: True if tasklets are runnable afterwards \n\
+            :rtype: Bool" },
+
+	{ "wait_readable",
+        (PyCFunction)SchedulerWaitReadable,
+        METH_VARARGS | METH_KEYWORDS,
+        "Park the current tasklet until a file descriptor becomes readable. \n\n\
+            :param fd: File descriptor or object with a fileno() method \n\
+            :param timeout: Optional timeout in seconds, None waits indefinitely and 0 polls without blocking \n\
+            :type timeout: Float or None \n\
+            :return: True if readable, False if the timeout expired \n\
+            :rtype: Bool" },
+
+	{ "wait_writable",
+        (PyCFunction)SchedulerWaitWritable,
+        METH_VARARGS | METH_KEYWORDS,
+        "Park the current tasklet until a file descriptor becomes writable. \n\n\
+            :param fd: File descriptor or object with a fileno() method \n\
+            :param timeout: Optional timeout in seconds, None waits indefinitely and 0 polls without blocking \n\
+            :type timeout: Float or None \n\
+            :return: True if writable, False if the timeout expired \n\
+            :rtype: Bool" },
+
+	{ "tls_slot",
+        (PyCFunction)SchedulerTlsSlot,
         METH_NOARGS,
-        "Run scheduler to end of run queue." },
+        "Allocate a new tasklet-local storage slot. \n\n\
+            Each tasklet holds its own value for the slot, which is released when the tasklet is destroyed. \n\n\
+            :return: The new slot \n\
+            :rtype: TaskletLocalSlot" },
 
 	{ "run_n_tasklets",
         (PyCFunction)SchedulerRunNTasklets,
@@ -1151,6 +1629,29 @@ static PyMethodDef SchedulerMethods[] = {
 	  "Get total number of active Tasklets across all threads. Active here meaning a Python Tasklet Object exists, active does not indicate state eg. the active Tasklet can be alive or dead. \n\n\
             :return: Number of active Tasklets \n\
             :rtype: Integer" },
+
+    { "select",
+	  (PyCFunction)SchedulerSelect,
+	  METH_VARARGS | METH_KEYWORDS,
+	  "Wait on several channel operations and complete exactly one of them. \n\n\
+            Cases are tried in order, if none can complete immediately the current Tasklet blocks until one can. \n\n\
+            :param cases: Sequence of (channel, 'recv') or (channel, 'send', value) tuples \n\
+            :param timeout: Maximum time to wait in seconds, 0 polls without blocking, None waits indefinitely \n\
+            :return: (index, value) of the completed case, value is None for a send. None if the timeout expired \n\
+            :rtype: Tuple or None" },
+
+    { "kill_all",
+	  (PyCFunction)SchedulerKillAll,
+	  METH_VARARGS | METH_KEYWORDS,
+	  "Kill many Tasklets in one pass. \n\n\
+            Every victim is marked and inserted into the runnables queue together. Unless pending the victims are then run \n\
+            in a single pass of the scheduler, Tasklets that never started are removed without being switched to. \n\
+            If the current Tasklet is among the victims it is killed last. \n\n\
+            :param tasklets: Iterable of Tasklets to kill, None kills every Tasklet on this thread other than the main and current Tasklets \n\
+            :type tasklets: Iterable or None \n\
+            :param pending: If True the kills are left for the next run of the scheduler \n\
+            :type pending: Bool \n\
+            :throws: TaskletExit on the calling Tasklet if it is among the victims" },
 	
 	{ nullptr, nullptr, 0, nullptr } /* Sentinel */
 };
@@ -1196,6 +1697,16 @@ PyMODINIT_FUNC PyInit__scheduler(void)
     {
 		return nullptr;
     }
+
+    if( PyType_Ready( &TaskletLocalSlotType ) < 0 )
+    {
+		return nullptr;
+    }
+
+    if( PyType_Ready( &LockType ) < 0 || PyType_Ready( &EventType ) < 0 || PyType_Ready( &SemaphoreType ) < 0 || PyType_Ready( &ConditionType ) < 0 || PyType_Ready( &TaskGroupType ) < 0 )
+    {
+		return nullptr;
+    }
 		
     m = PyModule_Create( &schedulermodule );
     if (!m)
@@ -1203,6 +1714,12 @@ PyMODINIT_FUNC PyInit__scheduler(void)
 		return nullptr;
     }
 
+#ifdef Py_GIL_DISABLED
+	// Shared state is locked and tasklets woken from other threads are posted to their own thread
+	// Synchronisation primitives are unlocked and refuse use from any thread but the one that created them
+	PyUnstable_Module_SetGIL( m, Py_MOD_GIL_NOT_USED );
+#endif
+
     Py_INCREF( &CallableWrapperType );
     if (PyModule_AddObject(m, "callable_wrapper", (PyObject*)&CallableWrapperType) < 0)
     {
@@ -1241,6 +1758,22 @@ PyMODINIT_FUNC PyInit__scheduler(void)
 		return nullptr;
 	}
 
+	// Synchronisation primitives
+	if( PyModule_AddObjectRef( m, "TaskletLocalSlot", (PyObject*)&TaskletLocalSlotType ) < 0 ||
+		PyModule_AddObjectRef( m, "Lock", (PyObject*)&LockType ) < 0 ||
+		PyModule_AddObjectRef( m, "Event", (PyObject*)&EventType ) < 0 ||
+		PyModule_AddObjectRef( m, "Semaphore", (PyObject*)&SemaphoreType ) < 0 ||
+		PyModule_AddObjectRef( m, "Condition", (PyObject*)&ConditionType ) < 0 ||
+		PyModule_AddObjectRef( m, "TaskGroup", (PyObject*)&TaskGroupType ) < 0 )
+	{
+		Py_DECREF( &CallableWrapperType );
+		Py_DECREF( &TaskletType );
+		Py_DECREF( &ChannelType );
+		Py_DECREF( &ScheduleManagerType );
+		Py_DECREF( m );
+		return nullptr;
+	}
+
 	//Exceptions
 	auto exit_exception_string = "_scheduler.TaskletExit";
 	TaskletExit = PyErr_NewException( exit_exception_string, PyExc_SystemExit, nullptr );
@@ -1294,6 +1827,9 @@ PyMODINIT_FUNC PyInit__scheduler(void)
 	api.PyTasklet_Kill = PyTasklet_Kill;
 	api.PyTasklet_GetTimesSwitchedTo = PyTasklet_GetTimesSwitchedTo;
 	api.PyTasklet_GetContext = PyTasklet_GetContext;
+	api.PyTasklet_AllocateLocalSlot = PyTasklet_AllocateLocalSlot;
+	api.PyTasklet_GetLocal = PyTasklet_GetLocal;
+	api.PyTasklet_SetLocal = PyTasklet_SetLocal;
 
     // Channel Functions
 	api.PyChannel_New = PyChannel_New;
@@ -1324,6 +1860,8 @@ PyMODINIT_FUNC PyInit__scheduler(void)
 	api.PyScheduler_GetActiveTaskletCount = PyScheduler_GetActiveTaskletCount;
 	api.PyScheduler_GetTaskletsCompletedLastRunWithTimeout =  PyScheduler_GetTaskletsCompletedLastRunWithTimeout;
 	api.PyScheduler_GetTaskletsSwitchedLastRunWithTimeout = PyScheduler_GetTaskletsSwitchedLastRunWithTimeout;
+	api.PyScheduler_GetThreadStatistics = PyScheduler_GetThreadStatistics;
+	api.PyScheduler_GetProcessStatistics = PyScheduler_GetProcessStatistics;
 
 	/* Create a Capsule containing the API pointer array's address */
 	c_api_object = PyCapsule_New( (void*)&api, "scheduler._C_API", nullptr );
@@ -0,0 +1,509 @@
+#include "SynchronisationPrimitives.h"
+
+#include "Channel.h"
+#include "Tasklet.h"
+#include "ScheduleManager.h"
+
+SynchronisationPrimitive::SynchronisationPrimitive( PyObject* pythonObject, Channel* waitQueue ) :
+	PythonCppType( pythonObject ),
+	m_waitQueue( waitQueue ),
+	m_threadId( PyThread_get_thread_ident() )
+{
+	// Waking a waiter never switches away from the waking tasklet
+	m_waitQueue->SetPreferenceFromInt( 1 );
+
+	m_waitQueue->SetChannelCallbackEnabled( false );
+}
+
+SynchronisationPrimitive::~SynchronisationPrimitive()
+{
+	m_waitQueue->Decref();
+}
+
+int SynchronisationPrimitive::NumberOfWaiters() const
+{
+	return -m_waitQueue->Balance();
+}
+
+bool SynchronisationPrimitive::IsOnOwningThread() const
+{
+	return PyThread_get_thread_ident() == m_threadId;
+}
+
+// Block the current tasklet until woken, timeout is in nanoseconds and negative waits indefinitely
+// Returns 1 when woken, 0 if the timeout expired and -1 on error
+int SynchronisationPrimitive::Wait( long long timeout )
+{
+	if( timeout < 0 )
+	{
+		PyObject* received = m_waitQueue->Receive();
+
+		if( received == nullptr )
+		{
+			return -1;
+		}
+
+		Py_DecRef( received );
+
+		return 1;
+	}
+
+	std::vector<SelectCase> cases( 1 );
+
+	cases[0].m_channel = m_waitQueue;
+
+	cases[0].m_direction = ChannelDirection::RECEIVER;
+
+	int selectedIndex = -1;
+
+	PyObject* received = nullptr;
+
+	if( !Channel::Select( cases, timeout, selectedIndex, received ) )
+	{
+		return -1;
+	}
+
+	if( selectedIndex < 0 )
+	{
+		return 0;
+	}
+
+	Py_DecRef( received );
+
+	return 1;
+}
+
+// Wake the longest waiting tasklet without switching to it
+// Returns the woken tasklet or nullptr if there were no waiters
+Tasklet* SynchronisationPrimitive::WakeOne()
+{
+	Tasklet* waiter = m_waitQueue->BlockedQueueFront();
+
+	if( waiter != nullptr )
+	{
+		m_waitQueue->Send( Py_None );
+	}
+
+	return waiter;
+}
+
+int SynchronisationPrimitive::WakeAll()
+{
+	return m_waitQueue->Broadcast( Py_None );
+}
+
+bool SynchronisationPrimitive::HasWaiters() const
+{
+	return m_waitQueue->Balance() < 0;
+}
+
+Tasklet* SynchronisationPrimitive::CurrentTasklet()
+{
+	return ScheduleManager::GetThreadScheduleManager()->GetCurrentTasklet();
+}
+
+
+Lock::Lock( PyObject* pythonObject, Channel* waitQueue ) :
+	SynchronisationPrimitive( pythonObject, waitQueue ),
+	m_locked( false ),
+	m_owner( nullptr )
+{
+}
+
+// Returns 1 if acquired, 0 if not acquired and -1 on error
+int Lock::Acquire( bool blocking, long long timeout )
+{
+	Tasklet* current = CurrentTasklet();
+
+	if( !m_locked )
+	{
+		m_locked = true;
+
+		m_owner = current;
+
+		return 1;
+	}
+
+	if( !blocking || timeout == 0 )
+	{
+		return 0;
+	}
+
+	bool alreadyOwner = m_owner == current;
+
+	int result = SynchronisationPrimitive::Wait( timeout );
+
+	// Ownership is handed over on release, if the wait was interrupted after that pass it on
+	if( result != 1 && !alreadyOwner && m_owner == current )
+	{
+		Release();
+	}
+
+	return result;
+}
+
+bool Lock::Release()
+{
+	if( !m_locked )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "release unlocked lock" );
+
+		return false;
+	}
+
+	if( HasWaiters() )
+	{
+		// Hand the lock directly to the next waiter, it remains locked
+		m_owner = WakeOne();
+	}
+	else
+	{
+		m_locked = false;
+
+		m_owner = nullptr;
+	}
+
+	return true;
+}
+
+bool Lock::IsLocked() const
+{
+	return m_locked;
+}
+
+bool Lock::IsOwnedByCurrentTasklet() const
+{
+	return m_locked && m_owner == CurrentTasklet();
+}
+
+
+Semaphore::Semaphore( PyObject* pythonObject, Channel* waitQueue, long value ) :
+	SynchronisationPrimitive( pythonObject, waitQueue ),
+	m_value( value )
+{
+}
+
+// Returns 1 if acquired, 0 if not acquired and -1 on error
+int Semaphore::Acquire( bool blocking, long long timeout )
+{
+	if( m_value > 0 )
+	{
+		m_value--;
+
+		return 1;
+	}
+
+	if( !blocking || timeout == 0 )
+	{
+		return 0;
+	}
+
+	Tasklet* current = CurrentTasklet();
+
+	int result = SynchronisationPrimitive::Wait( timeout );
+
+	// A unit handed over before the wait was interrupted is passed on
+	if( TakeHandoff( current ) && result != 1 )
+	{
+		Release();
+	}
+
+	return result;
+}
+
+void Semaphore::Release()
+{
+	if( HasWaiters() )
+	{
+		// Hand the unit directly to the next waiter
+		m_handoffs.push_back( WakeOne() );
+	}
+	else
+	{
+		m_value++;
+	}
+}
+
+long Semaphore::Value() const
+{
+	return m_value;
+}
+
+bool Semaphore::TakeHandoff( Tasklet* tasklet )
+{
+	for( auto iter = m_handoffs.begin(); iter != m_handoffs.end(); iter++ )
+	{
+		if( *iter == tasklet )
+		{
+			m_handoffs.erase( iter );
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+Event::Event( PyObject* pythonObject, Channel* waitQueue ) :
+	SynchronisationPrimitive( pythonObject, waitQueue ),
+	m_set( false )
+{
+}
+
+// Returns 1 if the event is set, 0 if the timeout expired and -1 on error
+int Event::Wait( long long timeout )
+{
+	if( m_set )
+	{
+		return 1;
+	}
+
+	if( timeout == 0 )
+	{
+		return 0;
+	}
+
+	return SynchronisationPrimitive::Wait( timeout );
+}
+
+void Event::Set()
+{
+	m_set = true;
+
+	WakeAll();
+}
+
+void Event::Clear()
+{
+	m_set = false;
+}
+
+bool Event::IsSet() const
+{
+	return m_set;
+}
+
+
+Condition::Condition( PyObject* pythonObject, Channel* waitQueue, Lock* lock ) :
+	SynchronisationPrimitive( pythonObject, waitQueue ),
+	m_lock( lock )
+{
+}
+
+Condition::~Condition()
+{
+	m_lock->Decref();
+}
+
+// Release the lock and wait to be notified, the lock is always reacquired before returning
+// Returns 1 if notified, 0 if the timeout expired and -1 on error
+int Condition::Wait( long long timeout )
+{
+	if( !m_lock->IsOwnedByCurrentTasklet() )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "cannot wait on un-acquired lock" );
+
+		return -1;
+	}
+
+	m_lock->Release();
+
+	int result = SynchronisationPrimitive::Wait( timeout );
+
+	// Preserve any error raised while waiting
+	PyObject* exception = PyErr_GetRaisedException();
+
+	if( m_lock->Acquire( true, -1 ) != 1 )
+	{
+		Py_XDECREF( exception );
+
+		return -1;
+	}
+
+	if( exception )
+	{
+		PyErr_SetRaisedException( exception );
+	}
+
+	return result;
+}
+
+bool Condition::Notify( long numberToNotify )
+{
+	if( !m_lock->IsOwnedByCurrentTasklet() )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "cannot notify on un-acquired lock" );
+
+		return false;
+	}
+
+	for( long i = 0; i < numberToNotify && HasWaiters(); i++ )
+	{
+		WakeOne();
+	}
+
+	return true;
+}
+
+bool Condition::NotifyAll()
+{
+	if( !m_lock->IsOwnedByCurrentTasklet() )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "cannot notify on un-acquired lock" );
+
+		return false;
+	}
+
+	WakeAll();
+
+	return true;
+}
+
+Lock* Condition::GetLock() const
+{
+	return m_lock;
+}
+
+
+TaskGroup::TaskGroup( PyObject* pythonObject, Channel* waitQueue ) :
+	SynchronisationPrimitive( pythonObject, waitQueue ),
+	m_exception( nullptr )
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+	// Children keep the group alive so none remain here
+	Py_XDECREF( m_exception );
+}
+
+// Track tasklet until it exits, the group and child keep each other alive until then
+bool TaskGroup::AddChild( Tasklet* tasklet )
+{
+	if( tasklet->GetTaskGroup() != nullptr )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "Tasklet already belongs to a TaskGroup" );
+
+		return false;
+	}
+
+	if( !tasklet->IsAlive() )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "Cannot add a dead tasklet to a TaskGroup" );
+
+		return false;
+	}
+
+	tasklet->Incref();
+
+	Incref();
+
+	tasklet->SetTaskGroup( this );
+
+	m_children.insert( tasklet );
+
+	if( m_exception )
+	{
+		// Group is already failing so the child is cancelled straight away
+		if( !tasklet->Kill( true ) )
+		{
+			PyErr_Clear();
+		}
+	}
+
+	return true;
+}
+
+// Called by a child once it is no longer alive
+// Waiters are woken once the last child has exited
+void TaskGroup::OnChildExited( Tasklet* tasklet )
+{
+	if( m_children.erase( tasklet ) == 0 )
+	{
+		return;
+	}
+
+	if( m_children.empty() )
+	{
+		WakeAll();
+	}
+
+	tasklet->Decref();
+
+	// May release the last reference to the group
+	Decref();
+}
+
+// Called with the exception a child exited with, takes ownership of exception
+// Only the first exception is kept, remaining children are killed when it arrives
+void TaskGroup::OnChildFailed( PyObject* exception )
+{
+	if( m_exception )
+	{
+		Py_DecRef( exception );
+
+		return;
+	}
+
+	m_exception = exception;
+
+	KillChildren();
+}
+
+// Wait for every child to exit
+// Returns 1 once all have exited, 0 if the timeout expired and -1 on error
+// The exception of the first child to fail is raised once all have exited
+int TaskGroup::Join( long long timeout )
+{
+	if( !m_children.empty() )
+	{
+		if( timeout == 0 )
+		{
+			return 0;
+		}
+
+		int result = Wait( timeout );
+
+		if( result <= 0 )
+		{
+			return result;
+		}
+	}
+
+	if( m_exception )
+	{
+		PyErr_SetRaisedException( m_exception );
+
+		m_exception = nullptr;
+
+		return -1;
+	}
+
+	return 1;
+}
+
+// Kill every child still running, each child exits the next time it is scheduled
+void TaskGroup::KillChildren()
+{
+	// Killing never removes children synchronously but iterate over a copy to be safe
+	std::vector<Tasklet*> children( m_children.begin(), m_children.end() );
+
+	for( Tasklet* child : children )
+	{
+		if( !child->Kill( true ) )
+		{
+			PyErr_WriteUnraisable( child->PythonObject() );
+		}
+	}
+}
+
+long TaskGroup::NumberOfChildren() const
+{
+	return static_cast<long>( m_children.size() );
+}
+
+void TaskGroup::ClearException()
+{
+	Py_CLEAR( m_exception );
+}
@@ -0,0 +1,171 @@
+/*
+	*************************************************************************
+
+	SynchronisationPrimitives.h
+
+	Created:   Oct. 2026
+	Project:   Scheduler
+
+	Description:
+
+	  Lock, Event, Semaphore, Condition and TaskGroup implemented on Channel block lists
+
+	(c) CCP 2024
+
+	*************************************************************************
+*/
+#pragma once
+#ifndef SYNCHRONISATIONPRIMITIVES_H
+#define SYNCHRONISATIONPRIMITIVES_H
+
+#include "stdafx.h"
+
+#include <vector>
+#include <unordered_set>
+
+#include "PythonCppType.h"
+
+class Channel;
+class Tasklet;
+
+// Base for primitives that block Tasklets
+// Waiting Tasklets are parked on an internal Channel so blocking, killing
+// and timeouts behave exactly as for a channel receive
+// Primitive state is unlocked, so a primitive may only be used from the thread that created it
+class SynchronisationPrimitive : public PythonCppType
+{
+public:
+	SynchronisationPrimitive( PyObject* pythonObject, Channel* waitQueue );
+
+	~SynchronisationPrimitive();
+
+	int NumberOfWaiters() const;
+
+	bool IsOnOwningThread() const;
+
+protected:
+
+	int Wait( long long timeout );
+
+	Tasklet* WakeOne();
+
+	int WakeAll();
+
+	bool HasWaiters() const;
+
+	static Tasklet* CurrentTasklet();
+
+	Channel* m_waitQueue; // Owns a reference to the channel python object
+
+	unsigned long m_threadId; // Thread that created the primitive
+};
+
+class Lock : public SynchronisationPrimitive
+{
+public:
+	Lock( PyObject* pythonObject, Channel* waitQueue );
+
+	int Acquire( bool blocking, long long timeout );
+
+	bool Release();
+
+	bool IsLocked() const;
+
+	bool IsOwnedByCurrentTasklet() const;
+
+private:
+
+	bool m_locked;
+
+	Tasklet* m_owner; // Weak ref
+};
+
+class Semaphore : public SynchronisationPrimitive
+{
+public:
+	Semaphore( PyObject* pythonObject, Channel* waitQueue, long value );
+
+	int Acquire( bool blocking, long long timeout );
+
+	void Release();
+
+	long Value() const;
+
+private:
+
+	bool TakeHandoff( Tasklet* tasklet );
+
+	long m_value;
+
+	std::vector<Tasklet*> m_handoffs; // Weak refs, woken Tasklets that have been given a unit
+};
+
+class Event : public SynchronisationPrimitive
+{
+public:
+	Event( PyObject* pythonObject, Channel* waitQueue );
+
+	int Wait( long long timeout );
+
+	void Set();
+
+	void Clear();
+
+	bool IsSet() const;
+
+private:
+
+	bool m_set;
+};
+
+class Condition : public SynchronisationPrimitive
+{
+public:
+	Condition( PyObject* pythonObject, Channel* waitQueue, Lock* lock );
+
+	~Condition();
+
+	int Wait( long long timeout );
+
+	bool Notify( long numberToNotify );
+
+	bool NotifyAll();
+
+	Lock* GetLock() const;
+
+private:
+
+	Lock* m_lock; // Owns a reference to the lock python object
+};
+
+// Tracks child Tasklets so a parent can wait for all of them to exit
+// The first exception raised by a child is stored and its siblings are killed
+class TaskGroup : public SynchronisationPrimitive
+{
+public:
+	TaskGroup( PyObject* pythonObject, Channel* waitQueue );
+
+	~TaskGroup();
+
+	bool AddChild( Tasklet* tasklet );
+
+	void OnChildExited( Tasklet* tasklet );
+
+	void OnChildFailed( PyObject* exception );
+
+	int Join( long long timeout );
+
+	void KillChildren();
+
+	long NumberOfChildren() const;
+
+	void ClearException();
+
+private:
+
+	std::unordered_set<Tasklet*> m_children; // Owns a reference to each child until it exits
+
+	PyObject* m_exception; // First exception raised by a child, nullptr if none
+};
+
+#endif // SYNCHRONISATIONPRIMITIVES_H
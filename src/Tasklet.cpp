@@ -3,6 +3,7 @@
 #include "ScheduleManager.h"
 #include "Channel.h"
 #include "PyCallableWrapper.h"
+#include "SynchronisationPrimitives.h"
 #include "Utils.h"
 
 Tasklet::Tasklet( PyObject* pythonObject, PyObject* taskletExitException, bool isMain ) :
@@ -24,6 +25,7 @@ Tasklet::Tasklet( PyObject* pythonObject, PyObject* taskletExitException, bool i
 	m_channelBlockedOn( nullptr ),
 	m_blockedDirection( ChannelDirection::NEITHER ),
 	m_blocked( false ),
+	m_blockedSequence( 0 ),
 	m_exceptionState( Py_None ),
 	m_exceptionArguments( Py_None ),
 	m_taskletExitException( taskletExitException ),
@@ -39,6 +41,10 @@ Tasklet::Tasklet( PyObject* pythonObject, PyObject* taskletExitException, bool i
 	m_remove( false ),
 	m_killPending( false ),
 	m_restoreException( false ),
+	m_queuedFrame( 0 ),
+	m_fairShareQueue( nullptr ),
+	m_nextInFairShareQueue( nullptr ),
+	m_previousInFairShareQueue( nullptr ),
 	m_lineNumber( 0 ),
 	m_startTime( 0 ),
 	m_endTime( 0 ),
@@ -46,11 +52,29 @@ Tasklet::Tasklet( PyObject* pythonObject, PyObject* taskletExitException, bool i
 	m_highlighted( false ),
 	m_dontRaise( false ),
 	m_ContextManagerCallable( nullptr ),
-	m_exceptionHandler(nullptr)
+	m_exceptionHandler(nullptr),
+	m_hasTimeout( false ),
+	m_timedOut( false ),
+	m_hasCancelDeadline( false ),
+	m_selectCases( nullptr ),
+	m_numberOfSelectCases( 0 ),
+	m_selectedCase( -1 ),
+	m_ioWaitFd( -1 ),
+	m_ioReady( false ),
+	m_taskGroup( nullptr ),
+	m_result( nullptr ),
+	m_resultException( nullptr ),
+	m_firstJoiner( nullptr ),
+	m_lastJoiner( nullptr ),
+	m_joinedTasklet( nullptr ),
+	m_contextVarsContext( nullptr ),
+	m_pendingCallable( nullptr ),
+	m_bindContext( nullptr )
 {
     // Update Tasklet counters
-	s_totalAllTimeTaskletCount++;
-	s_totalActiveTasklets++;
+	m_statistics = ScheduleManager::GetThreadStatistics();
+	ThreadStatistics::Increment( m_statistics->m_allTimeTaskletCount );
+	m_statistics->m_activeTaskletCount.fetch_add( 1, std::memory_order_relaxed );
 
     // If tasklet is not a scheduler tasklet then register the tasklet with the thread's ScheduleManager
 	if( !m_isMain )
@@ -66,8 +90,12 @@ Tasklet::~Tasklet()
 		SetAlive( false );
 	}
 
-    // Decriment Tasklet Counter
-	s_totalActiveTasklets--;
+    // Decriment Tasklet Counter, the Tasklet may be released on another thread
+	// Sequentially consistent against the exiting thread so one of the two recycles the counters
+	if( m_statistics->m_activeTaskletCount.fetch_sub( 1 ) == 1 && m_statistics->m_threadExited.load() )
+	{
+		ScheduleManager::RecycleThreadStatistics( m_statistics );
+	}
 
 	Py_CLEAR( m_callable );
 
@@ -77,10 +105,20 @@ Tasklet::~Tasklet()
 
 	Py_XDECREF( m_greenlet );
 
+	Py_XDECREF( m_pendingCallable );
+
+	Py_XDECREF( m_bindContext );
+
 	Py_XDECREF( m_transferArguments );
 
     Py_XDECREF( m_ContextManagerCallable );
 
+	ClearLocals();
+
+	Py_XDECREF( m_contextVarsContext );
+
+	ClearResult();
+
 }
 
 void Tasklet::SetNextBlocked(Tasklet* tasklet)
@@ -158,25 +196,36 @@ void Tasklet::OnCallableExited()
 	m_endTime = current_time.time_since_epoch().count();
 }
 
+// The greenlet is not created until the first switch so Tasklets that sit in the queue,
+// or are killed before they run, only cost the Tasklet itself
 bool Tasklet::Initialise()
 {
-	Py_XDECREF( m_greenlet );
+	Py_CLEAR( m_greenlet );
 
-	m_greenlet = PyGreenlet_New( m_callable, nullptr );
+	if( m_callable )
+	{
+		Py_XSETREF( m_pendingCallable, m_callable );
 
-    SetCallable( nullptr );
+		m_callable = nullptr;
+	}
 
-    if (!m_greenlet)
-    {
-		return false;
-    }
-    else
-    {
-		m_paused = true;
-		m_firstRun = true;
+	// Capture the binding context now, the copy shares its variables with the original until either side sets one
+	Py_CLEAR( m_bindContext );
 
-		return true; 
-    }
+	if( !m_contextVarsContext )
+	{
+		m_bindContext = PyContext_CopyCurrent();
+
+		if( !m_bindContext )
+		{
+			return false;
+		}
+	}
+
+	m_paused = true;
+	m_firstRun = true;
+
+	return true;
 }
 
 void Tasklet::Uninitialise()
@@ -184,6 +233,34 @@ void Tasklet::Uninitialise()
 	Py_XDECREF( m_greenlet );
     
     m_greenlet = nullptr;
+
+	Py_CLEAR( m_pendingCallable );
+
+	Py_CLEAR( m_bindContext );
+}
+
+// Create the greenlet for a Tasklet that is about to run for the first time
+bool Tasklet::CreateGreenlet()
+{
+	PyGreenlet* parent = m_taskletParent ? m_taskletParent->m_greenlet : nullptr;
+
+	m_greenlet = PyGreenlet_New( m_pendingCallable, parent );
+
+	Py_CLEAR( m_pendingCallable );
+
+	// Run in the context given to set_context, otherwise in the copy of the binding context
+	PyObject* context = m_contextVarsContext ? m_contextVarsContext : m_bindContext;
+
+	if( !m_greenlet || ( context && PyObject_SetAttrString( reinterpret_cast<PyObject*>( m_greenlet ), "gr_context", context ) < 0 ) )
+	{
+		Uninitialise();
+
+		return false;
+	}
+
+	Py_CLEAR( m_bindContext );
+
+	return true;
 }
 
 bool Tasklet::Insert()
@@ -352,8 +429,17 @@ bool Tasklet::SwitchTo( )
 			// If tasklet exit has been raised then don't run tasklet and keep silent
 			if( PyErr_GivenExceptionMatches( m_exceptionState, m_taskletExitException ) )
 			{
+				SetResultTaskletExit();
+
 				SetAlive( false );
 
+				// The greenlet was never created, release what it would have run
+				SetArguments( nullptr );
+
+				SetKwArguments( nullptr );
+
+				Uninitialise();
+
 				return true;
             }
 			else
@@ -368,6 +454,14 @@ bool Tasklet::SwitchTo( )
 		
         }
 
+        if( !m_greenlet && !CreateGreenlet() )
+		{
+			// Inform scheduler to remove this tasklet
+			m_remove = true;
+
+			return false;
+		}
+
         m_timesSwitchedTo++;
 
         // Tasklet is on the same thread so can be switched to now
@@ -387,7 +481,9 @@ bool Tasklet::SwitchTo( )
 
         m_firstRun = false;
 
-		ret = PyGreenlet_Switch( m_greenlet, args, kwargs );
+		PyObject* result = PyGreenlet_Switch( m_greenlet, args, kwargs );
+
+		ret = result != nullptr;
 
         // Clear arguments
 		SetArguments( nullptr );
@@ -401,42 +497,474 @@ bool Tasklet::SwitchTo( )
 
 		Tasklet* currentTasklet = scheduleManager->GetCurrentTasklet();
 
-		if( currentTasklet->m_exceptionState != Py_None )
-		{
+		if( currentTasklet->m_exceptionState != Py_None )
+		{
+			Py_XDECREF( result );
+
+            currentTasklet->SetPythonExceptionStateFromTaskletExceptionState();
+
+            return false;
+  
+        }
+
+        // A channel handoff may have passed control on from this tasklet, in which case
+        // it is the tasklet that control was passed to that has now switched back
+		Tasklet* switchedTasklet = scheduleManager->SwitchedBackTasklet( this );
+
+		if( !PyGreenlet_ACTIVE( switchedTasklet->m_greenlet ) )
+		{
+			// The callable has exited, keep what it exited with for result
+			if( result )
+			{
+				switchedTasklet->SetResult( result, nullptr );
+
+				result = nullptr;
+			}
+			else
+			{
+				PyObject* exception = PyErr_GetRaisedException();
+
+				Py_XINCREF( exception );
+
+				switchedTasklet->SetResult( nullptr, exception );
+
+				// A TaskGroup child exiting with an error hands it to the group instead of propagating it
+				if( switchedTasklet->m_taskGroup && exception && !PyErr_GivenExceptionMatches( exception, m_taskletExitException ) )
+				{
+					switchedTasklet->m_taskGroup->OnChildFailed( exception );
+
+					ret = true;
+				}
+				else
+				{
+					PyErr_SetRaisedException( exception );
+				}
+			}
+		}
+
+		// Value passed back by a switch, unused
+		Py_XDECREF( result );
+
+        // Check state of tasklet
+        if( !switchedTasklet->m_blocked && !switchedTasklet->m_transferInProgress && !switchedTasklet->m_isMain && !switchedTasklet->m_paused && switchedTasklet->m_reschedule == RescheduleType::NONE && !switchedTasklet->m_taggedForRemoval ) 
+		{
+			switchedTasklet->SetAlive( false );
+
+			switchedTasklet->OnCallableExited();
+		}
+
+		// Removed tasklet is paused
+        if (switchedTasklet->m_taggedForRemoval)
+        {
+			switchedTasklet->m_paused = true;
+        }
+
+		// Reset tagging used to preserve alive status after removal
+        switchedTasklet->m_taggedForRemoval = false;
+
+        
+		if( !ret )
+		{
+			// Inform scheduler to remove this tasklet
+			switchedTasklet->m_remove = true;
+		}
+
+    }
+
+	return ret;
+}
+
+// Switch straight from the current Tasklet to this one without returning to the main tasklet
+// Used by channel handoffs, the ScheduleManager has already put this Tasklet at the front of the queue
+// Returns false if an exception has been raised on the current Tasklet once it is resumed
+bool Tasklet::SwitchDirectlyTo()
+{
+	if( !m_greenlet && !CreateGreenlet() )
+	{
+		return false;
+	}
+
+	m_timesSwitchedTo++;
+
+	m_paused = false;
+
+	// This Tasklet may have exited and been released by the time the current Tasklet is resumed
+	ScheduleManager* scheduleManager = m_scheduleManager;
+
+	// Keep the target greenlet alive for the duration of the switch
+	PyGreenlet* greenlet = m_greenlet;
+
+	Py_INCREF( greenlet );
+
+	PyObject* ret = PyGreenlet_Switch( greenlet, nullptr, nullptr );
+
+	Py_DECREF( greenlet );
+
+	if( !ret )
+	{
+		return false;
+	}
+
+	Py_DecRef( ret );
+
+	// Resumed by the run loop, check the exception state as after switching to the parent in Yield
+	Tasklet* currentTasklet = scheduleManager->GetCurrentTasklet();
+
+	if( currentTasklet->m_exceptionState != Py_None )
+	{
+		currentTasklet->SetPythonExceptionStateFromTaskletExceptionState();
+
+		return false;
+	}
+
+	return true;
+}
+
+// Block the current Tasklet until this Tasklet exits
+// timeout is in nanoseconds, a negative value waits indefinitely
+// On return exited is false if the timeout expired first
+bool Tasklet::Join( long long timeout, bool& exited )
+{
+	exited = !m_alive;
+
+	if( exited )
+	{
+		return true;
+	}
+
+	if( !BelongsToCurrentThread() )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "Cannot join tasklet from another thread" );
+
+		return false;
+	}
+
+	if( m_isMain )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "Cannot join the main tasklet" );
+
+		return false;
+	}
+
+	Tasklet* current = m_scheduleManager->GetCurrentTasklet();
+
+	if( current == this )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "Tasklet cannot join itself" );
+
+		return false;
+	}
+
+	bool cancelScoped = m_scheduleManager->ApplyCancelDeadline( current, timeout );
+
+	if( timeout == 0 )
+	{
+		if( cancelScoped )
+		{
+			PyErr_SetString( PyExc_TimeoutError, "join timed out" );
+
+			return false;
+		}
+
+		return true;
+	}
+
+	if( current->IsBlocktrapped() )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "Tasklet cannot block on join with block_trap set true" );
+
+		return false;
+	}
+
+	// The reference is held on behalf of the join and released once resumed
+	current->Incref();
+
+	AddJoiner( current );
+
+	current->Block( nullptr );
+
+	if( timeout > 0 )
+	{
+		m_scheduleManager->AddTimeout( current, timeout );
+	}
+
+	bool success = m_scheduleManager->Yield();
+
+	m_scheduleManager->RemoveTimeout( current );
+
+	RemoveJoiner( current );
+
+	current->SetTimedOut( false );
+
+	if( !success )
+	{
+		current->Unblock();
+	}
+
+	current->Decref();
+
+	exited = !m_alive;
+
+	if( success && !exited && cancelScoped )
+	{
+		PyErr_SetString( PyExc_TimeoutError, "join timed out" );
+
+		return false;
+	}
+
+	return success;
+}
+
+// Returns a new reference to the value the callable returned
+// Raises the exception the Tasklet exited with, or RuntimeError if it is still alive
+PyObject* Tasklet::Result() const
+{
+	if( m_alive )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "Tasklet has not exited" );
+
+		return nullptr;
+	}
+
+	if( m_resultException && PyExceptionClass_Check( m_resultException ) )
+	{
+		// Killed before it ran, the instance is only created if the result is asked for
+		PyErr_SetNone( m_resultException );
+
+		return nullptr;
+	}
+
+	if( m_resultException )
+	{
+		Py_IncRef( m_resultException );
+
+		PyErr_SetRaisedException( m_resultException );
+
+		return nullptr;
+	}
+
+	PyObject* result = m_result ? m_result : Py_None;
+
+	Py_IncRef( result );
+
+	return result;
+}
+
+PyObject* Tasklet::GetResultValue() const
+{
+	return m_result;
+}
+
+PyObject* Tasklet::GetResultException() const
+{
+	return m_resultException;
+}
+
+// Takes ownership of result and exception
+void Tasklet::SetResult( PyObject* result, PyObject* exception )
+{
+	ClearResult();
+
+	m_result = result;
+
+	m_resultException = exception;
+}
+
+// Record TaskletExit as the exception of a Tasklet killed without running
+// The exception type is stored so bulk kills create no instances and cannot fail
+void Tasklet::SetResultTaskletExit()
+{
+	Py_IncRef( m_taskletExitException );
+
+	SetResult( nullptr, m_taskletExitException );
+}
+
+void Tasklet::ClearResult()
+{
+	Py_CLEAR( m_result );
+
+	Py_CLEAR( m_resultException );
+}
+
+// Joiners are kept in wait order using their blocked links, which are free while not blocked on a channel
+void Tasklet::AddJoiner( Tasklet* joiner )
+{
+	joiner->SetPreviousBlocked( m_lastJoiner );
+
+	joiner->SetNextBlocked( nullptr );
+
+	if( m_lastJoiner )
+	{
+		m_lastJoiner->SetNextBlocked( joiner );
+	}
+	else
+	{
+		m_firstJoiner = joiner;
+	}
+
+	m_lastJoiner = joiner;
+
+	joiner->m_joinedTasklet = this;
+}
+
+void Tasklet::RemoveJoiner( Tasklet* joiner )
+{
+	if( joiner->m_joinedTasklet != this )
+	{
+		return;
+	}
+
+	Tasklet* previous = joiner->PreviousBlocked();
+
+	Tasklet* next = joiner->NextBlocked();
+
+	if( previous )
+	{
+		previous->SetNextBlocked( next );
+	}
+	else
+	{
+		m_firstJoiner = next;
+	}
+
+	if( next )
+	{
+		next->SetPreviousBlocked( previous );
+	}
+	else
+	{
+		m_lastJoiner = previous;
+	}
+
+	joiner->SetPreviousBlocked( nullptr );
+
+	joiner->SetNextBlocked( nullptr );
+
+	joiner->m_joinedTasklet = nullptr;
+}
+
+// Make every joining Tasklet runnable, the reference each holds is released once it resumes
+void Tasklet::WakeJoiners()
+{
+	while( m_firstJoiner )
+	{
+		Tasklet* joiner = m_firstJoiner;
+
+		RemoveJoiner( joiner );
+
+		joiner->Unblock();
+
+		// The main tasklet is never queued, it is resumed when the scheduler returns to it
+		if( !joiner->m_isMain )
+		{
+			m_scheduleManager->InsertTasklet( joiner );
+		}
+	}
+}
+
+TaskGroup* Tasklet::GetTaskGroup() const
+{
+	return m_taskGroup;
+}
+
+void Tasklet::SetTaskGroup( TaskGroup* taskGroup )
+{
+	m_taskGroup = taskGroup;
+}
+
+// Set the contextvars.Context the Tasklet runs in
+// Applies immediately if the Tasklet is bound, otherwise when it is next set up
+bool Tasklet::SetContextVarsContext( PyObject* context )
+{
+	if( m_greenlet && PyObject_SetAttrString( reinterpret_cast<PyObject*>( m_greenlet ), "gr_context", context ) < 0 )
+	{
+		return false;
+	}
+
+	Py_IncRef( context );
+
+	Py_XDECREF( m_contextVarsContext );
+
+	m_contextVarsContext = context;
+
+	return true;
+}
+
+PyObject* Tasklet::GetContextVarsContext() const
+{
+	return m_contextVarsContext;
+}
+
+// Reserve a tasklet-local storage slot, slots are shared by all Tasklets and never released
+int Tasklet::AllocateLocalSlot()
+{
+	return s_numberOfLocalSlots++;
+}
+
+// Returns a borrowed reference to the value stored in slot or nullptr if it is unset
+PyObject* Tasklet::GetLocal( int slot ) const
+{
+	if( slot < 0 || static_cast<size_t>( slot ) >= m_locals.size() )
+	{
+		return nullptr;
+	}
+
+	return m_locals[slot];
+}
+
+// Store value in slot, passing nullptr clears the slot
+// Returns false if slot has not been allocated
+bool Tasklet::SetLocal( int slot, PyObject* value )
+{
+	if( slot < 0 || slot >= s_numberOfLocalSlots )
+	{
+		PyErr_SetString( PyExc_ValueError, "Invalid tasklet-local storage slot" );
+
+		return false;
+	}
+
+	if( static_cast<size_t>( slot ) >= m_locals.size() )
+	{
+		if( value == nullptr )
+		{
+			return true;
+		}
+
+		m_locals.resize( s_numberOfLocalSlots, nullptr );
+	}
+
+	Py_XINCREF( value );
 
-            currentTasklet->SetPythonExceptionStateFromTaskletExceptionState();
+	PyObject* previous = m_locals[slot];
 
-            return false;
-  
-        }
+	m_locals[slot] = value;
 
-        // Check state of tasklet
-        if( !m_blocked && !m_transferInProgress && !m_isMain && !m_paused && m_reschedule == RescheduleType::NONE && !m_taggedForRemoval ) 
-		{
-			SetAlive( false );
+	// Released last as the previous value may reference this Tasklet
+	Py_XDECREF( previous );
 
-			OnCallableExited();
-		}
+	return true;
+}
 
-		// Removed tasklet is paused
-        if (m_taggedForRemoval)
-        {
-			m_paused = true;
-        }
+void Tasklet::ClearLocals()
+{
+	std::vector<PyObject*> locals;
 
-		// Reset tagging used to preserve alive status after removal
-        m_taggedForRemoval = false;
+	locals.swap( m_locals );
 
-        
-		if( !ret )
-		{
-			// Inform scheduler to remove this tasklet
-			m_remove = true;
-		}
+	for( PyObject* value : locals )
+	{
+		Py_XDECREF( value );
+	}
+}
 
-    }
+int Tasklet::VisitLocals( visitproc visit, void* arg )
+{
+	for( PyObject* value : m_locals )
+	{
+		Py_VISIT( value );
+	}
 
-	return ret;
+	return 0;
 }
 
 void Tasklet::ClearException()
@@ -485,6 +1013,9 @@ void Tasklet::SetPythonExceptionStateFromTaskletExceptionState()
 	}	
 
 	ClearException();
+
+	// A pending kill has now been delivered, the Tasklet may catch TaskletExit and need killing again
+	m_killPending = false;
 }
 
 bool Tasklet::Run()
@@ -563,6 +1094,14 @@ bool Tasklet::Kill( bool pending /*=false*/ )
 		return true;
 	}
 
+    // A Tasklet that has never run has nothing to unwind, so it is killed without entering the scheduler
+    if( !pending && IsUnstarted() )
+	{
+		KillUnstarted();
+
+		return true;
+	}
+
     // Quick out if kill is already pending
     if (m_killPending)
     {
@@ -599,9 +1138,9 @@ bool Tasklet::Kill( bool pending /*=false*/ )
 
             if( blockedStore )
 			{
-				blockChannelStore->UnblockTaskletFromChannel( this );
+				m_channelBlockedOn = blockChannelStore;
 
-				SetBlockedDirection( ChannelDirection::NEITHER );
+				DetachFromBlocker();
 			}
 
             return true;
@@ -633,6 +1172,70 @@ bool Tasklet::Kill( bool pending /*=false*/ )
     return false;
 }
 
+// True if the Tasklet has been set up but has not been switched to yet
+bool Tasklet::IsUnstarted() const
+{
+	return m_alive && m_firstRun && !m_isMain && m_scheduleManager->GetCurrentTasklet() != this;
+}
+
+// Kill a Tasklet that has never run without switching to it
+// The Tasklet is unlinked from the runnables queue and everything it would have run with is released
+void Tasklet::KillUnstarted()
+{
+	bool queued = m_scheduled && m_scheduleManager->RemoveTasklet( this );
+
+	ClearException();
+
+	m_killPending = false;
+
+	SetArguments( nullptr );
+
+	SetKwArguments( nullptr );
+
+	Uninitialise();
+
+	SetResultTaskletExit();
+
+	SetAlive( false );
+
+	// Release the reference relinquished by the runnables queue, last as it may be the final one
+	if( queued )
+	{
+		Decref();
+	}
+}
+
+// Detach the Tasklet from whatever it is blocked on and raise TaskletExit on it the next time it runs
+// Unlike Kill( true ) the Tasklet is not inserted, ScheduleManager::KillTasklets inserts its victims together
+void Tasklet::MarkKillPending()
+{
+	bool blocked = m_blocked;
+	Channel* blockChannel = m_channelBlockedOn;
+
+	if( m_blocked )
+	{
+		Unblock();
+	}
+
+	SetExceptionState( m_taskletExitException );
+
+	SetReschedule( RescheduleType::NONE );
+
+	m_killPending = true;
+
+	if( blocked )
+	{
+		m_channelBlockedOn = blockChannel;
+
+		DetachFromBlocker();
+	}
+}
+
+bool Tasklet::IsKillPending() const
+{
+	return m_killPending;
+}
+
 PyObject* Tasklet::GetTransferArguments()
 {
     //Ownership is relinquished
@@ -701,6 +1304,24 @@ void Tasklet::SetAlive( bool value )
 	}
 
 	m_alive = value;
+
+	if( value )
+	{
+		ClearResult();
+	}
+	else
+	{
+		WakeJoiners();
+	}
+
+	if( !value && m_taskGroup )
+	{
+		TaskGroup* taskGroup = m_taskGroup;
+
+		m_taskGroup = nullptr;
+
+		taskGroup->OnChildExited( this );
+	}
 }
 
 bool Tasklet::IsAlive() const
@@ -911,7 +1532,8 @@ bool Tasklet::SetParent( Tasklet* parent )
 	{
 		parent->Incref();
 
-	    int ret = PyGreenlet_SetParent( m_greenlet, parent->m_greenlet );
+		// A greenlet that has not been created yet takes the parent when it is
+	    int ret = m_greenlet ? PyGreenlet_SetParent( m_greenlet, parent->m_greenlet ) : 0;
 
 	    if( ret == -1 )
 	    {
@@ -923,10 +1545,9 @@ bool Tasklet::SetParent( Tasklet* parent )
     {
         if (!m_isMain && m_greenlet)
         {
+			// Only the greenlet is reparented, no Tasklet reference is taken as m_taskletParent is cleared below
 			Tasklet* main = m_scheduleManager->GetMainTasklet();
 
-            main->Incref();
-
 			int ret = PyGreenlet_SetParent( m_greenlet, main->m_greenlet );
 
 			if( ret == -1 )
@@ -995,6 +1616,16 @@ PyObject* Tasklet::GetCallable()
 	return m_callable;
 }
 
+PyObject* Tasklet::GetPendingCallable() const
+{
+	return m_pendingCallable;
+}
+
+PyObject* Tasklet::GetBindContext() const
+{
+	return m_bindContext;
+}
+
 bool Tasklet::RequiresRemoval()
 {
 	return m_remove;
@@ -1010,6 +1641,16 @@ void Tasklet::SetBlockedDirection( ChannelDirection direction )
 	m_blockedDirection = direction;
 }
 
+unsigned long long Tasklet::BlockedSequence() const
+{
+	return m_blockedSequence;
+}
+
+void Tasklet::SetBlockedSequence( unsigned long long sequence )
+{
+	m_blockedSequence = sequence;
+}
+
 void Tasklet::SetScheduleManager( ScheduleManager* scheduleManager )
 {
 	if( !scheduleManager )
@@ -1356,16 +1997,30 @@ void Tasklet::Clear()
 
     // Clear Arguments
 	SetKwArguments( nullptr );
+
+	// Clear tasklet-local storage
+	ClearLocals();
+
+	// Clear context set through set_context
+	Py_CLEAR( m_contextVarsContext );
+
+	// Clear what the greenlet would be created with
+	Py_CLEAR( m_pendingCallable );
+
+	Py_CLEAR( m_bindContext );
+
+	// Clear what the callable exited with
+	ClearResult();
 }
 
 long Tasklet::GetAllTimeTaskletCount()
 {
-	return s_totalAllTimeTaskletCount;
+	return ScheduleManager::AggregateStatistic( &ThreadStatistics::m_allTimeTaskletCount );
 }
 
 long Tasklet::GetActiveTaskletCount()
 {
-	return s_totalActiveTasklets;
+	return ScheduleManager::AggregateStatistic( &ThreadStatistics::m_activeTaskletCount );
 }
 
 bool Tasklet::BelongsToCurrentThread()
@@ -1427,6 +2082,75 @@ void Tasklet::SetLineNumber( long lineNumber )
 void Tasklet::SetContext(std::string& context)
 {
 	m_context = context;
+
+	UpdateFairShareQueue();
+}
+
+void Tasklet::SetGroup( std::string& group )
+{
+	m_group = group;
+
+	UpdateFairShareQueue();
+}
+
+// A queued Tasklet changes group queue straight away, from another thread it changes when next queued
+void Tasklet::UpdateFairShareQueue()
+{
+	if( m_fairShareQueue && m_threadId == PyThread_get_thread_ident() )
+	{
+		m_scheduleManager->RegroupFairShareTasklet( this );
+	}
+}
+
+std::string Tasklet::GetGroup()
+{
+	return m_group;
+}
+
+void Tasklet::SetQueuedFrame( unsigned long long frame )
+{
+	m_queuedFrame = frame;
+}
+
+unsigned long long Tasklet::QueuedFrame() const
+{
+	return m_queuedFrame;
+}
+
+// The group a Tasklet shares run time with in fair share mode, its context unless a group is set
+const std::string& Tasklet::FairShareGroup() const
+{
+	return m_group.empty() ? m_context : m_group;
+}
+
+FairShareQueue* Tasklet::GetFairShareQueue() const
+{
+	return m_fairShareQueue;
+}
+
+void Tasklet::SetFairShareQueue( FairShareQueue* queue )
+{
+	m_fairShareQueue = queue;
+}
+
+Tasklet* Tasklet::NextInFairShareQueue() const
+{
+	return m_nextInFairShareQueue;
+}
+
+void Tasklet::SetNextInFairShareQueue( Tasklet* next )
+{
+	m_nextInFairShareQueue = next;
+}
+
+Tasklet* Tasklet::PreviousInFairShareQueue() const
+{
+	return m_previousInFairShareQueue;
+}
+
+void Tasklet::SetPreviousInFairShareQueue( Tasklet* previous )
+{
+	m_previousInFairShareQueue = previous;
 }
 
 
@@ -1487,7 +2211,7 @@ bool Tasklet::GetDontRaise() const
 
 bool Tasklet::SetDontRaise( bool dontRaise )
 {
-	if( m_greenlet )
+	if( m_greenlet || m_pendingCallable )
 	{
 		PyErr_SetString( PyExc_RuntimeError, "dont_raise cannot be altered after the Tasklet has been bound" );
 		return false;
@@ -1527,3 +2251,199 @@ void Tasklet::SetExceptionHandler(PyObject* exceptionHander)
 
     m_exceptionHandler = exceptionHander;
 }
+
+
+void Tasklet::SetTimeoutDeadline( std::chrono::steady_clock::time_point deadline )
+{
+	m_timeoutDeadline = deadline;
+
+	m_hasTimeout = true;
+}
+
+std::chrono::steady_clock::time_point Tasklet::GetTimeoutDeadline() const
+{
+	return m_timeoutDeadline;
+}
+
+void Tasklet::ClearTimeoutDeadline()
+{
+	m_hasTimeout = false;
+}
+
+bool Tasklet::HasTimeout() const
+{
+	return m_hasTimeout;
+}
+
+bool Tasklet::TimedOut() const
+{
+	return m_timedOut;
+}
+
+void Tasklet::SetTimedOut( bool value )
+{
+	m_timedOut = value;
+}
+
+// Set the deadline of the cancel scope the Tasklet is running in
+// Blocking operations raise TimeoutError if still blocked once it passes
+void Tasklet::SetCancelDeadline( std::chrono::steady_clock::time_point deadline )
+{
+	m_cancelDeadline = deadline;
+
+	m_hasCancelDeadline = true;
+}
+
+std::chrono::steady_clock::time_point Tasklet::GetCancelDeadline() const
+{
+	return m_cancelDeadline;
+}
+
+void Tasklet::ClearCancelDeadline()
+{
+	m_hasCancelDeadline = false;
+}
+
+bool Tasklet::HasCancelDeadline() const
+{
+	return m_hasCancelDeadline;
+}
+
+// Called by the ScheduleManager when the deadline of a blocked Tasklet passes
+// The Tasklet is detached from what it is blocked on and made runnable again
+// The reference held while blocked is released by the Tasklet once resumed
+void Tasklet::OnTimeoutExpired()
+{
+	// A wakeup from another thread may race the timeout, the channel lock decides which
+	// of the two takes the Tasklet off its channel and only that one wakes it
+	Channel* channel = m_channelBlockedOn;
+
+	if( channel )
+	{
+		if( !channel->WithdrawTimedOutTasklet( this ) )
+		{
+			return;
+		}
+	}
+	else if( m_selectCases )
+	{
+		if( !Channel::WithdrawTimedOutSelect( this ) )
+		{
+			return;
+		}
+
+		SetBlockedDirection( ChannelDirection::NEITHER );
+	}
+	else if( m_blocked )
+	{
+		DetachFromBlocker();
+	}
+	else
+	{
+		return;
+	}
+
+	Unblock();
+
+	m_timedOut = true;
+
+    // The main tasklet is never queued, it is resumed when the scheduler returns to it
+	if( !m_isMain )
+	{
+		m_scheduleManager->InsertTasklet( this );
+	}
+}
+
+void Tasklet::SetSelectCases( SelectCase* cases, size_t numberOfCases )
+{
+	m_selectCases = cases;
+
+	m_numberOfSelectCases = numberOfCases;
+}
+
+SelectCase* Tasklet::SelectCases() const
+{
+	return m_selectCases;
+}
+
+size_t Tasklet::NumberOfSelectCases() const
+{
+	return m_numberOfSelectCases;
+}
+
+int Tasklet::SelectedCase() const
+{
+	return m_selectedCase;
+}
+
+void Tasklet::SetSelectedCase( int index )
+{
+	m_selectedCase = index;
+}
+
+int Tasklet::IoWaitFd() const
+{
+	return m_ioWaitFd;
+}
+
+void Tasklet::SetIoWaitFd( int fd )
+{
+	m_ioWaitFd = fd;
+}
+
+bool Tasklet::IoReady() const
+{
+	return m_ioReady;
+}
+
+void Tasklet::SetIoReady( bool value )
+{
+	m_ioReady = value;
+}
+
+// Called by the ScheduleManager when the file descriptor a Tasklet is parked on becomes ready
+// The reference held while parked is released by the Tasklet once resumed
+void Tasklet::OnIoReady()
+{
+	if( !m_blocked )
+	{
+		return;
+	}
+
+	DetachFromBlocker();
+
+	Unblock();
+
+	m_ioReady = true;
+
+	if( !m_isMain )
+	{
+		m_scheduleManager->InsertTasklet( this );
+	}
+}
+
+// Remove the Tasklet from any channel block lists or I/O wait it is waiting on
+// Does not release the reference held by the block list
+void Tasklet::DetachFromBlocker()
+{
+	if( Channel* channel = m_channelBlockedOn )
+	{
+		channel->UnblockTaskletFromChannel( this );
+
+		m_channelBlockedOn = nullptr;
+	}
+	else if( m_selectCases )
+	{
+		Channel::CancelSelect( this );
+	}
+	else if( m_ioWaitFd >= 0 )
+	{
+		m_scheduleManager->RemoveIoWait( this );
+	}
+	else if( m_joinedTasklet )
+	{
+		m_joinedTasklet->RemoveJoiner( this );
+	}
+
+	SetBlockedDirection( ChannelDirection::NEITHER );
+}
\ No newline at end of file
@@ -20,6 +20,9 @@
 #define Tasklet_H
 
 #include <string>
+#include <chrono>
+#include <vector>
+#include <atomic>
 
 #include "stdafx.h"
 
@@ -27,6 +30,10 @@
 
 class Channel;
 class ScheduleManager;
+struct ThreadStatistics;
+class TaskGroup;
+struct SelectCase;
+struct FairShareQueue;
 enum class ChannelDirection;
 
 // Specify the technique used when rescheduling
@@ -61,6 +68,14 @@ public:
 
     bool Kill( bool pending = false );
 
+    bool IsUnstarted() const;
+
+    void KillUnstarted();
+
+    void MarkKillPending();
+
+    bool IsKillPending() const;
+
     PyObject* GetTransferArguments();
 
 	void ClearTransferArguments();
@@ -139,12 +154,20 @@ public:
 
     PyObject* GetCallable();
 
+    PyObject* GetPendingCallable() const;
+
+    PyObject* GetBindContext() const;
+
     bool RequiresRemoval();
 
     ChannelDirection GetBlockedDirection();
 
     void SetBlockedDirection( ChannelDirection direction );
 
+    unsigned long long BlockedSequence() const;
+
+    void SetBlockedSequence( unsigned long long sequence );
+
     void SetScheduleManager( ScheduleManager* scheduleManager );
 
     ScheduleManager* GetScheduleManager( );
@@ -169,6 +192,30 @@ public:
 
     std::string GetContext();
 
+    void SetGroup( std::string& group );
+
+    std::string GetGroup();
+
+    const std::string& FairShareGroup() const;
+
+    void UpdateFairShareQueue();
+
+    FairShareQueue* GetFairShareQueue() const;
+
+    void SetFairShareQueue( FairShareQueue* queue );
+
+    Tasklet* NextInFairShareQueue() const;
+
+    void SetNextInFairShareQueue( Tasklet* next );
+
+    Tasklet* PreviousInFairShareQueue() const;
+
+    void SetPreviousInFairShareQueue( Tasklet* previous );
+
+    void SetQueuedFrame( unsigned long long frame );
+
+    unsigned long long QueuedFrame() const;
+
     std::string GetFilename();
 
     void SetFilename( std::string& fileName );
@@ -221,6 +268,82 @@ public:
 
     void SetExceptionHandler( PyObject* exceptionHandler );
 
+    void SetTimeoutDeadline( std::chrono::steady_clock::time_point deadline );
+
+    std::chrono::steady_clock::time_point GetTimeoutDeadline() const;
+
+    void ClearTimeoutDeadline();
+
+    bool HasTimeout() const;
+
+    bool TimedOut() const;
+
+    void SetTimedOut( bool value );
+
+    void OnTimeoutExpired();
+
+    void SetCancelDeadline( std::chrono::steady_clock::time_point deadline );
+
+    std::chrono::steady_clock::time_point GetCancelDeadline() const;
+
+    void ClearCancelDeadline();
+
+    bool HasCancelDeadline() const;
+
+    void SetSelectCases( SelectCase* cases, size_t numberOfCases );
+
+    SelectCase* SelectCases() const;
+
+    size_t NumberOfSelectCases() const;
+
+    int SelectedCase() const;
+
+    void SetSelectedCase( int index );
+
+    int IoWaitFd() const;
+
+    void SetIoWaitFd( int fd );
+
+    bool IoReady() const;
+
+    void SetIoReady( bool value );
+
+    void OnIoReady();
+
+    void DetachFromBlocker();
+
+    bool SwitchDirectlyTo();
+
+    bool Join( long long timeout, bool& exited );
+
+    PyObject* Result() const;
+
+    PyObject* GetResultValue() const;
+
+    PyObject* GetResultException() const;
+
+    void ClearResult();
+
+    void RemoveJoiner( Tasklet* joiner );
+
+    TaskGroup* GetTaskGroup() const;
+
+    void SetTaskGroup( TaskGroup* taskGroup );
+
+    bool SetContextVarsContext( PyObject* context );
+
+    PyObject* GetContextVarsContext() const;
+
+    static int AllocateLocalSlot();
+
+    PyObject* GetLocal( int slot ) const;
+
+    bool SetLocal( int slot, PyObject* value );
+
+    void ClearLocals();
+
+    int VisitLocals( visitproc visit, void* arg );
+
 private:
 
     void SetExceptionState( PyObject* exception, PyObject* arguments = Py_None );
@@ -241,8 +364,18 @@ private:
 
 	void Uninitialise();
 
+    bool CreateGreenlet();
+
     bool BelongsToCurrentThread();
 
+    void AddJoiner( Tasklet* joiner );
+
+    void WakeJoiners();
+
+    void SetResult( PyObject* result, PyObject* exception );
+
+    void SetResultTaskletExit();
+
 private:
 
 	PyGreenlet* m_greenlet;
@@ -279,12 +412,15 @@ private:
 
 	bool m_restoreException;
 
-    Channel* m_channelBlockedOn;
+    // Cleared under the channel lock by whichever thread takes the Tasklet off the channel
+    std::atomic<Channel*> m_channelBlockedOn;
 
-	bool m_blocked;
+	std::atomic<bool> m_blocked;
 
 	ChannelDirection m_blockedDirection;
 
+    unsigned long long m_blockedSequence; // Order the Tasklet started waiting on its channel
+
     bool m_paused;
 
     bool m_firstRun;
@@ -317,17 +453,62 @@ private:
     std::string m_methodName;
     std::string m_moduleName;
     std::string m_context;
+    std::string m_group;
+    unsigned long long m_queuedFrame; // Schedule manager frame the Tasklet was last queued in
+    FairShareQueue* m_fairShareQueue; // Weak ref, the group queue the Tasklet is linked into in fair share mode
+    Tasklet* m_nextInFairShareQueue;
+    Tasklet* m_previousInFairShareQueue;
     std::string m_fileName;
     long m_lineNumber;
     long long m_startTime;
     long long m_endTime;
     double m_runTime;
     bool m_highlighted;
-    inline static long s_totalAllTimeTaskletCount = 0;
-
-    inline static long s_totalActiveTasklets = 0;
+    ThreadStatistics* m_statistics; // Counters of the thread that created this Tasklet
 
     bool m_dontRaise;
+
+    std::chrono::steady_clock::time_point m_timeoutDeadline;
+
+    bool m_hasTimeout;
+
+    bool m_timedOut;
+
+    std::chrono::steady_clock::time_point m_cancelDeadline; // Bounds every blocking operation while set
+
+    bool m_hasCancelDeadline;
+
+    SelectCase* m_selectCases; // Weak ref, owned by the select call
+
+    size_t m_numberOfSelectCases;
+
+    int m_selectedCase;
+
+    int m_ioWaitFd; // -1 when not parked on a file descriptor
+
+    bool m_ioReady;
+
+    std::vector<PyObject*> m_locals; // Indexed by slot, grown on first set
+
+    TaskGroup* m_taskGroup; // Weak ref, the group owns a reference to this Tasklet until it exits
+
+    PyObject* m_result; // Value returned by the callable once the Tasklet has exited
+
+    PyObject* m_resultException; // Exception the Tasklet exited with, the TaskletExit type if killed before it ran
+
+    Tasklet* m_firstJoiner; // Tasklets blocked joining this Tasklet, linked through their blocked links
+
+    Tasklet* m_lastJoiner;
+
+    Tasklet* m_joinedTasklet; // Weak ref, Tasklet this Tasklet is blocked joining
+
+    PyObject* m_contextVarsContext; // contextvars.Context set through set_context, nullptr to copy the binding context
+
+    PyObject* m_pendingCallable; // Callable the greenlet is created with on the first switch
+
+    PyObject* m_bindContext; // Copy of the context current at bind time, used when the greenlet is created
+
+    inline static std::atomic<int> s_numberOfLocalSlots{ 0 };
 };
 
 #endif // Tasklet_H
\ No newline at end of file
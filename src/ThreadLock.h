@@ -0,0 +1,85 @@
+/*
+	*************************************************************************
+
+	ThreadLock.h
+
+	Project:   Scheduler
+
+	Description:
+
+	  Lock for state shared between scheduler threads
+
+	  With the GIL every access is already serialised so locking compiles
+	  away. Free-threaded builds use a PyMutex, which detaches the thread
+	  state while waiting so a blocked thread never stalls the interpreter.
+	  Python code must never be run while a ThreadLock is held.
+
+	(c) CCP 2024
+
+	*************************************************************************
+*/
+#pragma once
+#ifndef THREADLOCK_H
+#define THREADLOCK_H
+
+#include "stdafx.h"
+
+class ThreadLock
+{
+public:
+	void Lock()
+	{
+#ifdef Py_GIL_DISABLED
+		PyMutex_Lock( &m_mutex );
+#endif
+	}
+
+	void Unlock()
+	{
+#ifdef Py_GIL_DISABLED
+		PyMutex_Unlock( &m_mutex );
+#endif
+	}
+
+private:
+#ifdef Py_GIL_DISABLED
+	PyMutex m_mutex = { 0 };
+#endif
+};
+
+class ThreadLockRAII
+{
+private:
+	ThreadLock& m_lock;
+
+	bool m_locked;
+
+public:
+	ThreadLockRAII( ThreadLock& lock ) :
+		m_lock( lock ),
+		m_locked( true )
+	{
+		m_lock.Lock();
+	}
+
+	~ThreadLockRAII()
+	{
+		Unlock();
+	}
+
+	// Release before the end of the scope, for example before switching away
+	void Unlock()
+	{
+		if( m_locked )
+		{
+			m_locked = false;
+
+			m_lock.Unlock();
+		}
+	}
+
+	ThreadLockRAII( ThreadLockRAII& other ) = delete;
+	ThreadLockRAII( ThreadLockRAII&& other ) = delete;
+};
+
+#endif // THREADLOCK_H
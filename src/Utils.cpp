@@ -32,3 +32,33 @@ bool StdStringFromPyObject( PyObject* obj, std::string& str )
 
 	return true;
 }
+
+// Convert a timeout in seconds to nanoseconds
+// None is converted to -1 indicating no timeout
+bool TimeoutFromPyObject( PyObject* obj, long long& timeout )
+{
+	if( obj == nullptr || obj == Py_None )
+	{
+		timeout = -1;
+
+		return true;
+	}
+
+	double seconds = PyFloat_AsDouble( obj );
+
+	if( seconds == -1.0 && PyErr_Occurred() )
+	{
+		return false;
+	}
+
+	if( seconds < 0.0 )
+	{
+		PyErr_SetString( PyExc_ValueError, "timeout must be a non-negative number or None" );
+
+		return false;
+	}
+
+	timeout = static_cast<long long>( seconds * 1e9 );
+
+	return true;
+}
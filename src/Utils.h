@@ -25,4 +25,6 @@
 
 bool StdStringFromPyObject( PyObject* obj, std::string& str );
 
+bool TimeoutFromPyObject( PyObject* obj, long long& timeout );
+
 #endif //UTILS_H
\ No newline at end of file
@@ -495,4 +495,56 @@ TEST_F( SchedulerCapi, PyScheduler_GetTaskletsSwitchedLastRunWithTimeout )
 	// Check tasklets completed since last timeout
 	// This shows a switchting to and from the main tasklet
 	EXPECT_EQ( m_api->PyScheduler_GetTaskletsSwitchedLastRunWithTimeout(), 6 );
-}
\ No newline at end of file
+}
+
+TEST_F( SchedulerCapi, PyScheduler_GetThreadStatistics )
+{
+	EXPECT_EQ( PyRun_SimpleString( "t1 = scheduler.tasklet(lambda:None)()\n"
+								   "t2 = scheduler.tasklet(lambda:None)()\n" ),
+			   0 );
+
+	EXPECT_EQ( m_api->PyScheduler_RunWithTimeout( 10000 ), Py_None );
+
+	SchedulerStatistics statistics;
+
+	m_api->PyScheduler_GetThreadStatistics( &statistics );
+
+	// Main tasklet and the two created
+	EXPECT_EQ( statistics.allTimeTaskletCount, 3 );
+
+	EXPECT_EQ( statistics.activeTaskletCount, 3 );
+
+	EXPECT_EQ( statistics.taskletsCompletedLastRunWithTimeout, 2 );
+
+	EXPECT_EQ( statistics.taskletsSwitchedLastRunWithTimeout, 4 );
+}
+
+TEST_F( SchedulerCapi, PyScheduler_GetProcessStatistics )
+{
+	// Tasklets created on another thread are counted against that thread
+	EXPECT_EQ( PyRun_SimpleString( "import threading\n"
+								   "def worker():\n"
+								   "   scheduler.tasklet(lambda:None)()\n"
+								   "   scheduler.run()\n"
+								   "thread = threading.Thread(target=worker)\n"
+								   "thread.start()\n"
+								   "thread.join()\n" ),
+			   0 );
+
+	SchedulerStatistics threadStatistics;
+
+	m_api->PyScheduler_GetThreadStatistics( &threadStatistics );
+
+	SchedulerStatistics processStatistics;
+
+	m_api->PyScheduler_GetProcessStatistics( &processStatistics );
+
+	EXPECT_EQ( threadStatistics.allTimeTaskletCount, 1 );
+
+	// Main tasklet of each thread and the worker's tasklet
+	EXPECT_EQ( processStatistics.allTimeTaskletCount, 3 );
+
+	EXPECT_EQ( processStatistics.allTimeTaskletCount, m_api->PyScheduler_GetAllTimeTaskletCount() );
+
+	EXPECT_EQ( processStatistics.activeTaskletCount, m_api->PyScheduler_GetActiveTaskletCount() );
+}
@@ -310,4 +310,37 @@ TEST_F( TaskletCapi, PyTasklet_Kill )
 
     // Clean
 	Py_XDECREF( tasklet );
-}
\ No newline at end of file
+}
+
+TEST_F( TaskletCapi, PyTasklet_LocalStorage )
+{
+	int slot = m_api->PyTasklet_AllocateLocalSlot();
+	EXPECT_GE( slot, 0 );
+	EXPECT_NE( m_api->PyTasklet_AllocateLocalSlot(), slot );
+
+	EXPECT_EQ( PyRun_SimpleString( "tasklet = scheduler.tasklet(lambda: None)\n" ), 0 );
+	PyObject* tasklet = PyObject_GetAttrString( m_mainModule, "tasklet" );
+	EXPECT_NE( tasklet, nullptr );
+
+	// Unset slot returns NULL without raising
+	EXPECT_EQ( m_api->PyTasklet_GetLocal( reinterpret_cast<PyTaskletObject*>( tasklet ), slot ), nullptr );
+	EXPECT_EQ( PyErr_Occurred(), nullptr );
+
+	PyObject* value = PyLong_FromLong( 101 );
+	EXPECT_EQ( m_api->PyTasklet_SetLocal( reinterpret_cast<PyTaskletObject*>( tasklet ), slot, value ), 0 );
+	EXPECT_EQ( m_api->PyTasklet_GetLocal( reinterpret_cast<PyTaskletObject*>( tasklet ), slot ), value );
+
+	// Clear slot
+	EXPECT_EQ( m_api->PyTasklet_SetLocal( reinterpret_cast<PyTaskletObject*>( tasklet ), slot, nullptr ), 0 );
+	EXPECT_EQ( m_api->PyTasklet_GetLocal( reinterpret_cast<PyTaskletObject*>( tasklet ), slot ), nullptr );
+
+	// Unallocated slot
+	EXPECT_EQ( m_api->PyTasklet_SetLocal( reinterpret_cast<PyTaskletObject*>( tasklet ), 1 << 30, value ), -1 );
+	EXPECT_NE( PyErr_Occurred(), nullptr );
+	PyErr_Clear();
+
+	// Clean
+	Py_DecRef( value );
+	EXPECT_EQ( PyRun_SimpleString( "tasklet = None\n" ), 0 );
+	Py_XDECREF( tasklet );
+}
@@ -0,0 +1,83 @@
+''' Benchmark of the runnables queue operations at increasing queue lengths.
+
+Every operation should cost the same whatever the length of the queue.
+
+Run with the scheduler module on the path:
+    python runnables_queue.py [queue length ...]
+'''
+import statistics
+import sys
+import timeit
+
+import scheduler
+
+
+NUMBER_OF_CALLS = 1000
+
+REPEATS = 9
+
+
+def nanoseconds_per_call(function):
+    times = timeit.repeat(function, number=NUMBER_OF_CALLS, repeat=REPEATS)
+    return statistics.median(times) / NUMBER_OF_CALLS * 1e9
+
+
+def fill_queue(length):
+    return [scheduler.tasklet(lambda: None)() for i in range(length)]
+
+
+def bench_calculate_run_count(length):
+    ''' Length of the queue, a read of the maintained count. '''
+    fill_queue(length)
+    return nanoseconds_per_call(scheduler.calculateruncount)
+
+
+def bench_remove_and_insert(length):
+    ''' Unlink a tasklet from the back of the queue and link it in again. '''
+    tasklets = fill_queue(length)
+    back = tasklets[-1]
+
+    def remove_and_insert():
+        back.remove()
+        back.insert()
+
+    return nanoseconds_per_call(remove_and_insert)
+
+
+def bench_schedule(length):
+    ''' Switch to the front tasklet, which moves itself to the back of the queue by scheduling. '''
+    running = [True]
+
+    def worker():
+        while running[0]:
+            scheduler.schedule()
+
+    for i in range(length):
+        scheduler.tasklet(worker)()
+
+    result = nanoseconds_per_call(lambda: scheduler.run_n_tasklets(1))
+
+    running[0] = False
+    return result
+
+
+BENCHMARKS = [bench_calculate_run_count, bench_remove_and_insert, bench_schedule]
+
+
+def main(lengths):
+    print("%-28s" % "queue length" + "".join("%12d" % length for length in lengths))
+
+    for benchmark in BENCHMARKS:
+        results = []
+
+        for length in lengths:
+            results.append(benchmark(length))
+
+            # Leave an empty queue for the next measurement
+            scheduler.run()
+
+        print("%-28s" % benchmark.__name__[len("bench_"):] + "".join("%9.0f ns" % result for result in results))
+
+
+if __name__ == '__main__':
+    main([int(argument) for argument in sys.argv[1:]] or [10, 1000, 100000])
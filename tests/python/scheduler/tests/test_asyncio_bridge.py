@@ -0,0 +1,103 @@
+import asyncio
+import scheduler
+from scheduler import asyncio_bridge
+from test_utils import SchedulerTestCaseBase
+
+
+class TestAsyncioBridge(SchedulerTestCaseBase):
+    def setUp(self):
+        super().setUp()
+        self.loop = asyncio.new_event_loop()
+        self.driver = asyncio_bridge.AsyncioDriver(self.loop, budget=0.001)
+        self.driver.start()
+
+    def tearDown(self):
+        self.driver.stop()
+        self.loop.close()
+        self.loop = None
+        self.driver = None
+        super().tearDown()
+
+    def test_receive_async_from_tasklet(self):
+        ''' Test that a coroutine receives a value sent by a tasklet. '''
+        c = scheduler.channel()
+
+        def sender():
+            scheduler.schedule()
+            c.send('value')
+
+        scheduler.tasklet(sender)()
+
+        result = self.loop.run_until_complete(asyncio.wait_for(c.receive_async(), 1))
+
+        self.assertEqual(result, 'value')
+        self.assertEqual(c.balance, 0)
+
+    def test_receive_async_with_waiting_sender(self):
+        ''' Test that receive_async completes immediately when a sender is waiting. '''
+        c = scheduler.channel()
+
+        scheduler.tasklet(c.send)(5)
+        scheduler.run()
+
+        result = self.loop.run_until_complete(c.receive_async())
+
+        self.assertEqual(result, 5)
+
+    def test_receive_async_cancelled(self):
+        ''' Test that cancelling the await removes the helper tasklet from the channel. '''
+        c = scheduler.channel()
+
+        async def cancel():
+            task = asyncio.ensure_future(c.receive_async())
+            await asyncio.sleep(0)
+            self.assertEqual(c.balance, -1)
+            task.cancel()
+            with self.assertRaises(asyncio.CancelledError):
+                await task
+
+        self.loop.run_until_complete(cancel())
+        self.assertEqual(c.balance, 0)
+
+    def test_tasklet_waits_on_future(self):
+        ''' Test that a tasklet blocked on an asyncio future is woken when it resolves. '''
+        results = []
+        future = self.loop.create_future()
+
+        scheduler.tasklet(lambda: results.append(asyncio_bridge.wait_future(future)))()
+
+        async def resolve():
+            await asyncio.sleep(0.001)
+            self.assertEqual(results, [])
+            future.set_result(42)
+            while not results:
+                await asyncio.sleep(0.001)
+
+        self.loop.run_until_complete(asyncio.wait_for(resolve(), 1))
+
+        self.assertEqual(results, [42])
+
+    def test_driver_runs_tasklets(self):
+        ''' Test that the driver runs tasklets within the loop. '''
+        ran = []
+
+        for i in range(3):
+            scheduler.tasklet(ran.append)(i)
+
+        self.loop.run_until_complete(asyncio.sleep(0.01))
+
+        self.assertEqual(ran, [0, 1, 2])
+        self.assertEqual(self.getruncount(), 1)
+
+    def test_run_with_timeout(self):
+        ''' Test that run with a timeout always runs at least one tasklet. '''
+        ran = []
+
+        for i in range(3):
+            scheduler.tasklet(ran.append)(i)
+
+        scheduler.run(0)
+
+        self.assertTrue(len(ran) >= 1)
+        scheduler.run()
+        self.assertEqual(ran, [0, 1, 2])
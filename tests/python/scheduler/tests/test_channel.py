@@ -1377,3 +1377,712 @@ class TestChannels(SchedulerTestCaseBase):
         # There should now only be one reference remaining (2 for sys.getrefcount)
         self.assertEqual(sys.getrefcount(tasklet[0]),2)
         tasklet[0] = None
+
+    def test_cross_thread_send_posts_receiver(self):
+        ''' Test that a send from another thread leaves the receiver to be queued by its own thread. '''
+        import threading
+        c = scheduler.channel()
+        received = []
+
+        scheduler.tasklet(lambda: received.append(c.receive()))()
+        scheduler.run()
+        self.assertEqual(c.balance, -1)
+
+        thread = threading.Thread(target=c.send, args=('value',))
+        thread.start()
+        thread.join()
+
+        # The runnables queue of this thread is untouched until it next runs the scheduler
+        self.assertEqual(c.balance, 0)
+        self.assertEqual(received, [])
+        self.assertEqual(self.getruncount(), 1)
+
+        scheduler.run()
+        self.assertEqual(received, ['value'])
+
+    def test_main_tasklet_woken_by_cross_thread_send(self):
+        ''' Test that the main tasklet waiting with nothing to run is woken by a send from another thread. '''
+        import threading
+        c = scheduler.channel()
+
+        thread = threading.Timer(0.01, c.send, ('value',))
+        thread.start()
+        try:
+            self.assertEqual(c.receive(timeout=5), 'value')
+        finally:
+            thread.join()
+
+
+class TestSelect(SchedulerTestCaseBase):
+    def test_select_ready_receive(self):
+        ''' Test that select completes immediately on a channel with a waiting sender. '''
+        c1 = scheduler.channel()
+        c2 = scheduler.channel()
+
+        scheduler.tasklet(c2.send)(5)
+        scheduler.run()
+        self.assertEqual(c2.balance, 1)
+
+        result = scheduler.select([(c1, 'recv'), (c2, 'recv')])
+
+        self.assertEqual(result, (1, 5))
+        self.assertEqual(c1.balance, 0)
+        self.assertEqual(c2.balance, 0)
+
+    def test_select_ready_send(self):
+        ''' Test that select completes immediately on a channel with a waiting receiver. '''
+        c = scheduler.channel()
+        received = []
+
+        scheduler.tasklet(lambda: received.append(c.receive()))()
+        scheduler.run()
+
+        result = scheduler.select([(c, 'send', 'value')])
+        scheduler.run()
+
+        self.assertEqual(result, (0, None))
+        self.assertEqual(received, ['value'])
+
+    def test_select_blocks_until_one_case_completes(self):
+        ''' Test that a blocked select is completed by a sender and withdraws its other cases. '''
+        c1 = scheduler.channel()
+        c2 = scheduler.channel()
+        results = []
+
+        def selector():
+            results.append(scheduler.select([(c1, 'recv'), (c2, 'recv')]))
+
+        t = scheduler.tasklet(selector)()
+        scheduler.run()
+
+        self.assertTrue(t.blocked)
+        self.assertEqual(c1.balance, -1)
+        self.assertEqual(c2.balance, -1)
+        self.assertEqual(c1.queue, t)
+
+        c2.send('hello')
+        scheduler.run()
+
+        self.assertEqual(results, [(1, 'hello')])
+        self.assertFalse(t.blocked)
+        self.assertEqual(c1.balance, 0)
+        self.assertEqual(c2.balance, 0)
+
+    def test_blocked_select_send_case(self):
+        ''' Test that a blocked select send case delivers its value to a receiver. '''
+        c1 = scheduler.channel()
+        c2 = scheduler.channel()
+        results = []
+
+        def selector():
+            results.append(scheduler.select([(c1, 'recv'), (c2, 'send', 42)]))
+
+        scheduler.tasklet(selector)()
+        scheduler.run()
+
+        self.assertEqual(c1.balance, -1)
+        self.assertEqual(c2.balance, 1)
+
+        self.assertEqual(c2.receive(), 42)
+        scheduler.run()
+
+        self.assertEqual(results, [(1, None)])
+        self.assertEqual(c1.balance, 0)
+        self.assertEqual(c2.balance, 0)
+
+    def test_select_waiters_served_in_arrival_order(self):
+        ''' Test that a select waiter queued before plain waiters is served first. '''
+        c = scheduler.channel()
+        received = []
+
+        def selector():
+            received.append(("select", scheduler.select([(c, 'recv')])[1]))
+
+        def receiver():
+            received.append(("receive", c.receive()))
+
+        scheduler.tasklet(selector)()
+        scheduler.tasklet(receiver)()
+        scheduler.run()
+        self.assertEqual(c.balance, -2)
+
+        c.send('first')
+        c.send('second')
+        scheduler.run()
+
+        self.assertEqual(received, [("select", 'first'), ("receive", 'second')])
+
+        # Senders are served in arrival order too
+        def sender(value):
+            c.send(value)
+
+        scheduler.tasklet(sender)('plain')
+        scheduler.tasklet(scheduler.select)([(c, 'send', 'selected')])
+        scheduler.run()
+        self.assertEqual(c.balance, 2)
+
+        self.assertEqual(c.receive(), 'plain')
+        self.assertEqual(c.receive(), 'selected')
+        scheduler.run()
+
+    def test_select_poll(self):
+        ''' Test that a zero timeout polls without blocking. '''
+        c = scheduler.channel()
+
+        self.assertIsNone(scheduler.select([(c, 'recv')], timeout=0))
+        self.assertEqual(c.balance, 0)
+
+    def test_select_poll_counterpart_taken_by_other_thread(self):
+        ''' Test that a polling select never falls back to blocking when another thread can take its counterpart. '''
+        import threading
+        c = scheduler.channel()
+        blocked = threading.Event()
+        finish = threading.Event()
+        mainThread = threading.get_ident()
+        stolen = []
+
+        def sender_thread():
+            scheduler.tasklet(c.send)('value')
+            scheduler.run()
+            blocked.set()
+            finish.wait()
+            scheduler.run()
+
+        def steal():
+            try:
+                stolen.append(c.receive(timeout=0.01))
+            except TimeoutError:
+                stolen.append(None)
+
+        def callback(channel, tasklet, sending, willBlock):
+            # Another thread receives while the select is between its cases and the transfer
+            if threading.get_ident() == mainThread and not stolen:
+                thief = threading.Thread(target=steal)
+                thief.start()
+                thief.join()
+
+        thread = threading.Thread(target=sender_thread)
+        thread.start()
+        blocked.wait()
+
+        scheduler.set_channel_callback(callback)
+        try:
+            result = scheduler.select([(c, 'recv')], timeout=0)
+        finally:
+            scheduler.set_channel_callback(None)
+            finish.set()
+            thread.join()
+
+        self.assertEqual(result, (0, 'value'))
+        self.assertEqual(stolen, [None])
+        self.assertEqual(c.balance, 0)
+
+    def test_select_timeout_on_main(self):
+        ''' Test that select on the main tasklet returns None once the timeout expires. '''
+        c = scheduler.channel()
+
+        self.assertIsNone(scheduler.select([(c, 'recv')], timeout=0.01))
+        self.assertEqual(c.balance, 0)
+
+    def test_select_timeout_on_tasklet(self):
+        ''' Test that a blocked select in a tasklet is resumed once the timeout expires. '''
+        c = scheduler.channel()
+        results = []
+
+        def selector():
+            results.append(scheduler.select([(c, 'recv')], timeout=0.01))
+
+        t = scheduler.tasklet(selector)()
+        scheduler.run()
+        self.assertTrue(t.blocked)
+
+        # Blocking the main tasklet lets the scheduler wait for the pending timeout
+        self.assertIsNone(scheduler.select([(scheduler.channel(), 'recv')], timeout=0.05))
+
+        self.assertEqual(results, [None])
+        self.assertFalse(t.alive)
+        self.assertEqual(c.balance, 0)
+
+    def test_kill_blocked_select(self):
+        ''' Test that killing a tasklet blocked in select removes all of its cases. '''
+        c1 = scheduler.channel()
+        c2 = scheduler.channel()
+
+        t = scheduler.tasklet(lambda: scheduler.select([(c1, 'recv'), (c2, 'send', 1)]))()
+        scheduler.run()
+
+        self.assertEqual(c1.balance, -1)
+        self.assertEqual(c2.balance, 1)
+
+        t.kill()
+
+        self.assertFalse(t.alive)
+        self.assertEqual(c1.balance, 0)
+        self.assertEqual(c2.balance, 0)
+        self.assertEqual(sys.getrefcount(t), 2)
+
+    def test_select_closed_channel(self):
+        ''' Test that select raises ValueError rather than blocking on a closed channel. '''
+        c = scheduler.channel()
+        c.close()
+
+        self.assertRaises(ValueError, scheduler.select, [(c, 'recv')])
+
+    def test_select_invalid_case(self):
+        ''' Test that malformed cases raise errors. '''
+        c = scheduler.channel()
+
+        self.assertRaises(TypeError, scheduler.select, [(1, 'recv')])
+        self.assertRaises(ValueError, scheduler.select, [(c, 'push')])
+        self.assertRaises(ValueError, scheduler.select, [(c, 'send')])
+        self.assertRaises(TypeError, scheduler.select, 5)
+
+
+class TestBatchedTransfer(SchedulerTestCaseBase):
+    def test_send_many_to_waiting_receivers(self):
+        ''' Test that send_many hands values to all waiting receivers in order. '''
+        c = scheduler.channel()
+        received = []
+
+        for _ in range(3):
+            scheduler.tasklet(lambda: received.append(c.receive()))()
+        scheduler.run()
+        self.assertEqual(c.balance, -3)
+
+        c.send_many([1, 2, 3])
+        scheduler.run()
+
+        self.assertEqual(received, [1, 2, 3])
+        self.assertEqual(c.balance, 0)
+
+    def test_send_many_blocks_for_remaining_values(self):
+        ''' Test that send_many blocks for values once no receivers remain. '''
+        c = scheduler.channel()
+
+        t = scheduler.tasklet(c.send_many)(iter(range(4)))
+        scheduler.run()
+
+        self.assertTrue(t.blocked)
+        self.assertEqual(c.balance, 1)
+        self.assertEqual(c.receive_many(10), [0])
+
+        scheduler.run()
+        self.assertEqual([c.receive() for _ in range(3)], [1, 2, 3])
+        scheduler.run()
+        self.assertFalse(t.alive)
+
+    def test_receive_many_from_waiting_senders(self):
+        ''' Test that receive_many takes up to max_n values from waiting senders. '''
+        c = scheduler.channel()
+
+        for i in range(5):
+            scheduler.tasklet(c.send)(i)
+        scheduler.run()
+        self.assertEqual(c.balance, 5)
+
+        self.assertEqual(c.receive_many(3), [0, 1, 2])
+        self.assertEqual(c.balance, 2)
+        self.assertEqual(c.receive_many(3), [3, 4])
+        self.assertEqual(c.balance, 0)
+
+    def test_receive_many_blocks_for_first_value(self):
+        ''' Test that receive_many blocks when there are no waiting senders. '''
+        c = scheduler.channel()
+        received = []
+
+        scheduler.tasklet(lambda: received.append(c.receive_many(4)))()
+        scheduler.run()
+        self.assertEqual(c.balance, -1)
+
+        c.send('a')
+        scheduler.run()
+
+        self.assertEqual(received, [['a']])
+
+    def test_receive_many_stops_at_exception(self):
+        ''' Test that a sent exception ends the batch and is raised by the following receive. '''
+        c = scheduler.channel()
+
+        scheduler.tasklet(c.send)(1)
+        scheduler.tasklet(c.send_exception)(ValueError, 'error')
+        scheduler.tasklet(c.send)(2)
+        scheduler.run()
+
+        self.assertEqual(c.receive_many(3), [1])
+        self.assertRaises(ValueError, c.receive_many, 3)
+        self.assertEqual(c.receive_many(3), [2])
+
+    def test_receive_many_invalid_count(self):
+        ''' Test that receive_many requires a positive count. '''
+        c = scheduler.channel()
+
+        self.assertRaises(ValueError, c.receive_many, 0)
+
+
+class TestBroadcast(SchedulerTestCaseBase):
+    def test_broadcast_wakes_all_receivers(self):
+        ''' Test that broadcast delivers one value to every waiting receiver in order. '''
+        c = scheduler.channel()
+        received = []
+
+        for i in range(4):
+            scheduler.tasklet(lambda i=i: received.append((i, c.receive())))()
+        scheduler.run()
+        self.assertEqual(c.balance, -4)
+
+        self.assertEqual(c.broadcast('event'), 4)
+        self.assertEqual(c.balance, 0)
+        self.assertEqual(self.getruncount(), 1)
+
+        self.assertEqual(received, [(0, 'event'), (1, 'event'), (2, 'event'), (3, 'event')])
+
+    def test_broadcast_prefer_sender(self):
+        ''' Test that with sender preference broadcast queues the receivers without switching. '''
+        c = scheduler.channel()
+        c.preference = 1
+        received = []
+
+        for i in range(3):
+            scheduler.tasklet(lambda: received.append(c.receive()))()
+        scheduler.run()
+
+        self.assertEqual(c.broadcast(7), 3)
+        self.assertEqual(self.getruncount(), 4)
+        self.assertEqual(received, [])
+
+        scheduler.run()
+        self.assertEqual(received, [7, 7, 7])
+
+    def test_broadcast_without_receivers(self):
+        ''' Test that broadcast does not block when no receivers are waiting. '''
+        c = scheduler.channel()
+
+        self.assertEqual(c.broadcast(1), 0)
+        self.assertEqual(c.balance, 0)
+
+    def test_broadcast_value_refcount(self):
+        ''' Test that broadcast only holds transient references to the value. '''
+        c = scheduler.channel()
+        value = object()
+
+        def receiver():
+            c.receive()
+
+        for _ in range(3):
+            scheduler.tasklet(receiver)()
+        scheduler.run()
+
+        before = sys.getrefcount(value)
+        c.broadcast(value)
+        scheduler.run()
+
+        self.assertEqual(sys.getrefcount(value), before)
+
+
+class TestDirectHandoff(SchedulerTestCaseBase):
+    def setUp(self):
+        super().setUp()
+        scheduler.set_use_nested_tasklets(False)
+
+    def tearDown(self):
+        super().tearDown()
+        scheduler.set_use_nested_tasklets(True)
+
+    def test_handoff_keeps_queue_order(self):
+        ''' Test that a send handed straight to the receiver leaves the queue as a reschedule would. '''
+        c = scheduler.channel()
+        order = []
+
+        def receiver():
+            order.append(('received', c.receive()))
+
+        def sender():
+            c.send(1)
+            order.append('sender resumed')
+
+        scheduler.tasklet(receiver)()
+        scheduler.run()
+
+        scheduler.tasklet(sender)()
+        scheduler.tasklet(order.append)('other')
+        scheduler.run()
+
+        self.assertEqual(order, [('received', 1), 'other', 'sender resumed'])
+
+    def test_handoff_skips_main_tasklet(self):
+        ''' Test that messages to a waiting receiver no longer switch through the main tasklet. '''
+        c = scheduler.channel()
+
+        def consumer():
+            for i in range(10):
+                c.receive()
+
+        def producer():
+            for i in range(10):
+                c.send(i)
+
+        main = scheduler.getmain()
+        scheduler.tasklet(consumer)()
+        scheduler.tasklet(producer)()
+
+        before = main.times_switched_to
+        scheduler.run()
+
+        self.assertEqual(main.times_switched_to - before, 10)
+
+    def test_handoff_receiver_raises(self):
+        ''' Test that an error raised by a receiver after a handoff is reported by run. '''
+        c = scheduler.channel()
+
+        def receiver():
+            c.receive()
+            raise ValueError('boom')
+
+        def sender():
+            c.send(None)
+
+        r = scheduler.tasklet(receiver)()
+        scheduler.run()
+
+        scheduler.tasklet(sender)()
+        self.assertRaises(ValueError, scheduler.run)
+
+        self.assertFalse(r.alive)
+        scheduler.run()
+        self.assertEqual(self.getruncount(), 1)
+
+    def test_receiver_kills_sender(self):
+        ''' Test that a sender suspended by a handoff can be killed by the receiver. '''
+        c = scheduler.channel()
+        results = []
+
+        def sender():
+            c.send(None)
+            results.append('sender resumed')
+
+        def receiver():
+            c.receive()
+            s.kill()
+            results.append('killed')
+
+        scheduler.tasklet(receiver)()
+        scheduler.run()
+
+        s = scheduler.tasklet(sender)()
+        scheduler.run()
+
+        self.assertEqual(results, ['killed'])
+        self.assertEqual(self.getruncount(), 1)
+
+    def test_schedule_callback_sees_main_tasklet(self):
+        ''' Test that handoffs are not used while a schedule callback is installed. '''
+        c = scheduler.channel()
+        main = scheduler.getmain()
+        switches = []
+
+        r = scheduler.tasklet(c.receive)()
+        scheduler.run()
+        s = scheduler.tasklet(c.send)(None)
+
+        scheduler.set_schedule_callback(lambda prev, next: switches.append((prev, next)))
+        try:
+            scheduler.run()
+        finally:
+            scheduler.set_schedule_callback(None)
+
+        self.assertIn((s, main), switches)
+        self.assertIn((main, r), switches)
+
+
+class TestChannelTimeouts(SchedulerTestCaseBase):
+    def test_receive_timeout(self):
+        ''' Test that a timed out receive raises TimeoutError and leaves the channel. '''
+        c = scheduler.channel()
+        results = []
+
+        def receiver():
+            try:
+                c.receive(timeout=0.01)
+            except TimeoutError:
+                results.append('timeout')
+
+        scheduler.tasklet(receiver)()
+        scheduler.run()
+        self.assertEqual(c.balance, -1)
+
+        while not results:
+            scheduler.wait_for_events()
+            scheduler.run()
+
+        self.assertEqual(results, ['timeout'])
+        self.assertEqual(c.balance, 0)
+
+    def test_timeouts_race_cross_thread_sends(self):
+        ''' Test that timed receives racing timed sends from other threads transfer every value exactly once. '''
+        import threading
+        c = scheduler.channel()
+        numberOfThreads = 4
+        numberPerThread = 250
+        total = numberOfThreads * numberPerThread
+        received = []
+        finished = []
+
+        def receiver(useSelect):
+            while len(received) < total:
+                if useSelect:
+                    result = scheduler.select([(c, 'recv')], timeout=0.0001)
+                    if result is not None:
+                        received.append(result[1])
+                else:
+                    try:
+                        received.append(c.receive(timeout=0.0001))
+                    except TimeoutError:
+                        pass
+            finished.append(useSelect)
+
+        def sender(thread):
+            for i in range(numberPerThread):
+                while True:
+                    try:
+                        c.send((thread, i), timeout=0.0001)
+                        break
+                    except TimeoutError:
+                        pass
+
+        for i in range(4):
+            scheduler.tasklet(receiver)(i % 2 == 0)
+
+        threads = [threading.Thread(target=sender, args=(i,)) for i in range(numberOfThreads)]
+        for thread in threads:
+            thread.start()
+
+        while len(finished) < 4:
+            scheduler.wait_for_events()
+            scheduler.run()
+
+        for thread in threads:
+            thread.join()
+
+        self.assertEqual(sorted(received), [(thread, i) for thread in range(numberOfThreads) for i in range(numberPerThread)])
+        self.assertEqual(c.balance, 0)
+
+    def test_receive_before_timeout(self):
+        ''' Test that a value sent before the timeout is received normally. '''
+        c = scheduler.channel()
+        results = []
+
+        scheduler.tasklet(lambda: results.append(c.receive(timeout=5)))()
+        scheduler.run()
+
+        c.send('value')
+        scheduler.run()
+
+        self.assertEqual(results, ['value'])
+
+    def test_zero_timeout(self):
+        ''' Test that a zero timeout completes a waiting transfer or raises immediately. '''
+        c = scheduler.channel()
+
+        self.assertRaises(TimeoutError, c.receive, timeout=0)
+        self.assertRaises(TimeoutError, c.send, 1, timeout=0)
+        self.assertEqual(c.balance, 0)
+
+        scheduler.tasklet(c.send)(5)
+        scheduler.run()
+        self.assertEqual(c.receive(timeout=0), 5)
+
+    def test_send_timeout_on_main(self):
+        ''' Test that the main tasklet can time out a blocking send. '''
+        c = scheduler.channel()
+
+        self.assertRaises(TimeoutError, c.send, 'value', timeout=0.01)
+        self.assertEqual(c.balance, 0)
+
+    def test_kill_after_timeout_expired(self):
+        ''' Test that killing a tasklet whose timeout expired before it resumed is safe. '''
+        c = scheduler.channel()
+
+        t = scheduler.tasklet(c.receive)(timeout=0.001)
+        t.run()
+
+        import time
+        time.sleep(0.005)
+        scheduler.wait_for_events(timeout=0)
+        t.kill()
+
+        self.assertFalse(t.alive)
+        self.assertEqual(c.balance, 0)
+
+
+class TestCancelScope(SchedulerTestCaseBase):
+    def test_fail_after(self):
+        ''' Test that a blocking operation inside fail_after raises TimeoutError once the deadline passes. '''
+        c = scheduler.channel()
+
+        with self.assertRaises(TimeoutError):
+            with scheduler.fail_after(0.01):
+                c.receive()
+
+        self.assertIsNone(scheduler.getcurrent().deadline)
+        self.assertEqual(c.balance, 0)
+
+    def test_move_on_after(self):
+        ''' Test that move_on_after abandons its block when the deadline passes. '''
+        c = scheduler.channel()
+        lock = scheduler.Lock()
+        lock.acquire()
+
+        with scheduler.move_on_after(0.01) as scope:
+            lock.acquire()
+        self.assertTrue(scope.cancelled_caught)
+
+        with scheduler.move_on_after(0.01) as scope:
+            scheduler.select([(c, 'recv')])
+        self.assertTrue(scope.cancelled_caught)
+
+        lock.release()
+
+    def test_nested_scopes(self):
+        ''' Test that the outer scope catches a timeout caused by its shorter deadline. '''
+        c = scheduler.channel()
+
+        with scheduler.move_on_after(0.01) as outer:
+            with scheduler.move_on_after(5) as inner:
+                self.assertEqual(scheduler.getcurrent().deadline, outer.deadline)
+                c.receive()
+
+        self.assertFalse(inner.cancelled_caught)
+        self.assertTrue(outer.cancelled_caught)
+
+    def test_operation_timeout_shorter_than_scope(self):
+        ''' Test that an operation timeout within a scope behaves as without the scope. '''
+        lock = scheduler.Lock()
+        lock.acquire()
+
+        with scheduler.fail_after(5):
+            self.assertFalse(lock.acquire(timeout=0.01))
+
+        lock.release()
+
+    def test_scope_in_tasklet(self):
+        ''' Test that the scope only bounds the tasklet that entered it. '''
+        c = scheduler.channel()
+        results = []
+
+        def worker():
+            with scheduler.move_on_after(0.01) as scope:
+                c.receive()
+            results.append(scope.cancelled_caught)
+
+        scheduler.tasklet(worker)()
+        scheduler.tasklet(c.receive)()
+        scheduler.run()
+
+        while not results:
+            scheduler.wait_for_events()
+            scheduler.run()
+
+        self.assertEqual(results, [True])
+        self.assertEqual(c.balance, -1)
+
+        c.send(None)
@@ -0,0 +1,123 @@
+import os
+import socket
+import sys
+import unittest
+import scheduler
+from test_utils import SchedulerTestCaseBase
+
+
+@unittest.skipUnless(sys.platform.startswith('linux'), 'file descriptor waits require epoll')
+class TestIoWait(SchedulerTestCaseBase):
+    def setUp(self):
+        super().setUp()
+        self.reader, self.writer = os.pipe()
+
+    def tearDown(self):
+        os.close(self.reader)
+        os.close(self.writer)
+        super().tearDown()
+
+    def test_wait_readable_parks_tasklet(self):
+        ''' Test that a tasklet waiting on a descriptor leaves the runnables queue until data arrives. '''
+        results = []
+
+        def waiter():
+            results.append(scheduler.wait_readable(self.reader))
+            results.append(os.read(self.reader, 5))
+
+        scheduler.tasklet(waiter)()
+        scheduler.run()
+
+        self.assertEqual(results, [])
+        self.assertEqual(self.getruncount(), 1)
+
+        os.write(self.writer, b'hello')
+        scheduler.run()
+
+        self.assertEqual(results, [True, b'hello'])
+
+    def test_wait_writable(self):
+        ''' Test that an empty pipe is immediately writable. '''
+        self.assertTrue(scheduler.wait_writable(self.writer))
+        self.assertTrue(scheduler.wait_writable(self.writer, timeout=0))
+
+    def test_wait_readable_timeout(self):
+        ''' Test that waiting returns False once the timeout expires. '''
+        self.assertFalse(scheduler.wait_readable(self.reader, timeout=0))
+        self.assertFalse(scheduler.wait_readable(self.reader, timeout=0.01))
+
+        os.write(self.writer, b'x')
+        self.assertTrue(scheduler.wait_readable(self.reader, timeout=0.01))
+
+    def test_main_tasklet_blocks_in_epoll(self):
+        ''' Test that the main tasklet waiting with nothing runnable is woken by another thread writing. '''
+        import threading
+
+        thread = threading.Timer(0.01, os.write, (self.writer, b'x'))
+        thread.start()
+        try:
+            self.assertTrue(scheduler.wait_readable(self.reader, timeout=5))
+        finally:
+            thread.join()
+
+    def test_socket_object(self):
+        ''' Test that objects with a fileno method can be waited on. '''
+        a, b = socket.socketpair()
+        try:
+            received = []
+
+            def waiter():
+                scheduler.wait_readable(a)
+                received.append(a.recv(16))
+
+            scheduler.tasklet(waiter)()
+            scheduler.run()
+
+            b.send(b'ping')
+            scheduler.run()
+
+            self.assertEqual(received, [b'ping'])
+        finally:
+            a.close()
+            b.close()
+
+    def test_second_waiter_raises(self):
+        ''' Test that only one tasklet may wait for each direction of a descriptor. '''
+        first = scheduler.tasklet(scheduler.wait_readable)(self.reader)
+        first.run()
+
+        self.assertRaises(RuntimeError, scheduler.wait_readable, self.reader)
+
+        first.kill()
+
+    def test_kill_waiting_tasklet(self):
+        ''' Test that killing a parked tasklet removes its wait. '''
+        t = scheduler.tasklet(scheduler.wait_readable)(self.reader)
+        t.run()
+
+        t.kill()
+        self.assertFalse(t.alive)
+
+        # The descriptor can be waited on again
+        os.write(self.writer, b'x')
+        self.assertTrue(scheduler.wait_readable(self.reader))
+
+    def test_wait_for_events(self):
+        ''' Test that the thread idles until a parked tasklet becomes runnable. '''
+        import threading
+
+        scheduler.tasklet(scheduler.wait_readable)(self.reader)
+        scheduler.run()
+
+        self.assertFalse(scheduler.wait_for_events(timeout=0.001))
+
+        thread = threading.Timer(0.01, os.write, (self.writer, b'x'))
+        thread.start()
+        try:
+            self.assertTrue(scheduler.wait_for_events(timeout=5))
+        finally:
+            thread.join()
+
+        self.assertEqual(self.getruncount(), 2)
+        scheduler.run()
+        self.assertEqual(self.getruncount(), 1)
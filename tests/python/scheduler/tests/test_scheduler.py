@@ -347,6 +347,35 @@ class TestSchedule(test_utils.SchedulerTestCaseBase):
         self.assertEqual(self.getruncount(), 1)
         self.assertEqual(self.events, ["foo"])
 
+    def test_queue_links(self):
+        ''' Test that next and prev follow the runnables queue and stop at either end. '''
+        main = scheduler.getcurrent()
+        self.assertIsNone(main.next)
+        self.assertIsNone(main.prev)
+
+        t1 = scheduler.tasklet(lambda: None)()
+        t2 = scheduler.tasklet(lambda: None)()
+        self.assertIs(main.next, t1)
+        self.assertIs(t1.prev, main)
+        self.assertIs(t1.next, t2)
+        self.assertIs(t2.prev, t1)
+        self.assertIsNone(t2.next)
+
+        t1.remove()
+        self.assertIs(main.next, t2)
+        self.assertIs(t2.prev, main)
+        self.assertIsNone(t1.next)
+        self.assertIsNone(t1.prev)
+        self.assertEqual(self.getruncount(), 2)
+
+        t1.insert()
+        self.assertIs(t2.next, t1)
+        self.assertIsNone(t1.next)
+        self.assertEqual(self.getruncount(), 3)
+
+        scheduler.run()
+        self.assertIsNone(main.next)
+
     def test_schedule_remove_fail(self):
 
         def nested_tasklet():
@@ -443,6 +472,473 @@ class TestRun(test_utils.SchedulerTestCaseBase):
         scheduler.run()
         self.assertEqual(values, ["a", "b", "c", "d", "e", "f", "g"])
 
+class TestRunForever(test_utils.SchedulerTestCaseBase):
+    def test_stop_from_tasklet(self):
+        ''' Test that run_forever runs queued tasklets and returns once stopped. '''
+        values = []
+
+        def foo(x):
+            values.append(x)
+            if x == 2:
+                scheduler.stop_run_forever()
+
+        for i in range(3):
+            scheduler.tasklet(foo)(i)
+
+        scheduler.run_forever()
+
+        self.assertEqual(values, [0, 1, 2])
+        self.assertEqual(self.getruncount(), 1)
+
+    def test_woken_by_timeout(self):
+        ''' Test that an idle run_forever wakes for a tasklet timeout. '''
+        def waiter():
+            scheduler.select([(scheduler.channel(), 'recv')], timeout=0.01)
+            scheduler.stop_run_forever()
+
+        scheduler.tasklet(waiter)()
+
+        scheduler.run_forever()
+
+        self.assertEqual(self.getruncount(), 1)
+
+    def test_woken_by_cross_thread_send(self):
+        ''' Test that a send from another thread wakes the idle receiving thread. '''
+        import threading
+        import time
+
+        c = scheduler.channel()
+        c.preference = 1
+        received = []
+
+        def receiver():
+            received.append(c.receive())
+            scheduler.stop_run_forever()
+
+        scheduler.tasklet(receiver)()
+
+        def sender():
+            time.sleep(0.01)
+            c.send('value')
+
+        thread = threading.Thread(target=sender)
+        thread.start()
+
+        scheduler.run_forever()
+        thread.join()
+
+        self.assertEqual(received, ['value'])
+
+    def test_stop_from_another_thread(self):
+        ''' Test that the schedule manager can stop run_forever from another thread. '''
+        import threading
+
+        manager = scheduler.get_schedule_manager()
+        thread = threading.Timer(0.01, manager.stop_run_forever)
+        thread.start()
+
+        scheduler.run_forever()
+        thread.join()
+
+    def test_idle_wait(self):
+        ''' Test that an idle_wait bounds each sleep so the loop keeps checking. '''
+        import threading
+        import time
+
+        start = time.monotonic()
+        thread = threading.Timer(0.02, scheduler.get_schedule_manager().stop_run_forever)
+        thread.start()
+
+        scheduler.run_forever(idle_wait=0.001)
+        thread.join()
+
+        self.assertLess(time.monotonic() - start, 5)
+        self.assertRaises(ValueError, scheduler.run_forever, idle_wait=-1)
+
+class TestDetachQueue(test_utils.SchedulerTestCaseBase):
+    def test_detach_and_attach_keeps_order(self):
+        ''' Test that an attached queue runs in the order it was detached. '''
+        values = []
+        manager = scheduler.get_schedule_manager()
+
+        for i in range(5):
+            scheduler.tasklet(values.append)(i)
+
+        handle = manager.detach_queue()
+        self.assertEqual(self.getruncount(), 1)
+
+        scheduler.tasklet(values.append)('new')
+        scheduler.run()
+        self.assertEqual(values, ['new'])
+
+        manager.attach_queue(handle)
+        self.assertEqual(self.getruncount(), 6)
+
+        scheduler.run()
+        self.assertEqual(values, ['new', 0, 1, 2, 3, 4])
+
+        # A handle is emptied by attaching it
+        manager.attach_queue(handle)
+        self.assertEqual(self.getruncount(), 1)
+
+    def test_blocked_tasklets_stay_blocked(self):
+        ''' Test that tasklets blocked on a channel keep their place while the queue is detached. '''
+        c = scheduler.channel()
+        received = []
+        manager = scheduler.get_schedule_manager()
+
+        for i in range(2):
+            scheduler.tasklet(lambda: received.append(c.receive()))()
+        scheduler.run()
+        scheduler.tasklet(c.send)('a')
+
+        handle = manager.detach_queue()
+        self.assertEqual(c.balance, -2)
+
+        manager.attach_queue(handle)
+        scheduler.run()
+        self.assertEqual(received, ['a'])
+        self.assertEqual(c.balance, -1)
+
+        c.send('b')
+        self.assertEqual(received, ['a', 'b'])
+
+    def test_killed_tasklets_are_dropped(self):
+        ''' Test that tasklets killed while detached are not attached. '''
+        values = []
+        manager = scheduler.get_schedule_manager()
+
+        t = scheduler.tasklet(values.append)(0)
+        scheduler.tasklet(values.append)(1)
+
+        handle = manager.detach_queue()
+        t.kill()
+
+        manager.attach_queue(handle)
+        scheduler.run()
+        self.assertEqual(values, [1])
+
+    def test_detach_in_fair_share_and_frame_budget_mode(self):
+        ''' Test that group queues and frame bookkeeping release detached tasklets. '''
+        values = []
+        manager = scheduler.get_schedule_manager()
+        manager.set_fair_share(True)
+        manager.set_frame_budget(True)
+        try:
+            for i in range(4):
+                scheduler.tasklet(values.append)(i).group = "ab"[i % 2]
+
+            handle = manager.detach_queue()
+            scheduler.run(timeout=1)
+            self.assertEqual(values, [])
+
+            manager.attach_queue(handle)
+            scheduler.run(timeout=1)
+            self.assertEqual(self.getruncount(), 1)
+            self.assertEqual(sorted(values), [0, 1, 2, 3])
+        finally:
+            manager.set_frame_budget(False)
+            manager.set_fair_share(False)
+
+    def test_attach_unstarted_to_another_thread(self):
+        ''' Test that tasklets that have not started can move to the schedule manager of another thread. '''
+        import threading
+        threadIds = []
+        handles = []
+        detached = threading.Event()
+        attached = threading.Event()
+
+        def detach():
+            for i in range(3):
+                scheduler.tasklet(lambda: threadIds.append(scheduler.getcurrent().thread_id))()
+            handles.append(scheduler.get_schedule_manager().detach_queue())
+            detached.set()
+            # Tasklets still belong to this thread until attached, exiting would kill them
+            attached.wait()
+
+        thread = threading.Thread(target=detach)
+        thread.start()
+        detached.wait()
+        try:
+            scheduler.get_schedule_manager().attach_queue(handles[0])
+        finally:
+            attached.set()
+            thread.join()
+
+        scheduler.run()
+
+        self.assertEqual(threadIds, [threading.get_ident()] * 3)
+
+    def test_attach_started_to_another_thread(self):
+        ''' Test that a queue holding a started tasklet cannot move to another thread. '''
+        import threading
+        handles = []
+        detached = threading.Event()
+        attempted = threading.Event()
+
+        def detach():
+            # Prefer the sender so the woken receiver is left started and runnable
+            c = scheduler.channel()
+            c.preference = 1
+            scheduler.tasklet(c.receive)().run()
+            c.send(None)
+            handles.append(scheduler.get_schedule_manager().detach_queue())
+            detached.set()
+            attempted.wait()
+
+        thread = threading.Thread(target=detach)
+        thread.start()
+        detached.wait()
+        try:
+            self.assertRaises(RuntimeError, scheduler.get_schedule_manager().attach_queue, handles[0])
+            self.assertEqual(self.getruncount(), 1)
+        finally:
+            attempted.set()
+            thread.join()
+
+    def test_detach_from_tasklet(self):
+        ''' Test that only the main tasklet can detach the queue. '''
+        errors = []
+
+        def detach():
+            try:
+                scheduler.get_schedule_manager().detach_queue()
+            except RuntimeError:
+                errors.append(True)
+
+        scheduler.tasklet(detach)()
+        scheduler.run()
+
+        self.assertEqual(errors, [True])
+        self.assertRaises(TypeError, scheduler.get_schedule_manager().attach_queue, object())
+
+
+class TestFairShare(test_utils.SchedulerTestCaseBase):
+    def tearDown(self):
+        scheduler.get_schedule_manager().set_fair_share(False)
+        super().tearDown()
+
+    @staticmethod
+    def busy(ran, name, duration=0.005):
+        import time
+        end = time.perf_counter() + duration
+        while time.perf_counter() < end:
+            pass
+        ran.append(name)
+
+    def test_group_defaults_to_empty(self):
+        ''' Test that a tasklet has no group until one is set. '''
+        t = scheduler.tasklet(lambda: None)
+        t.context = "context"
+        self.assertEqual(t.group, "")
+
+        t.group = "group"
+        self.assertEqual(t.group, "group")
+        self.assertEqual(t.context, "context")
+
+    def test_groups_share_run_budget(self):
+        ''' Test that a group queued behind a larger group still runs within the budget. '''
+        manager = scheduler.get_schedule_manager()
+        self.assertFalse(manager.get_fair_share())
+        manager.set_fair_share(True)
+        self.assertTrue(manager.get_fair_share())
+
+        ran = []
+        for i in range(10):
+            scheduler.tasklet(self.busy)(ran, ("a", i)).context = "a"
+        for i in range(10):
+            scheduler.tasklet(self.busy)(ran, ("b", i)).group = "b"
+
+        scheduler.run(timeout=0.02)
+
+        a = [i for group, i in ran if group == "a"]
+        b = [i for group, i in ran if group == "b"]
+        self.assertTrue(a)
+        self.assertTrue(b)
+        self.assertLess(len(ran), 20)
+
+        # Each group keeps its queue order
+        self.assertEqual(a, list(range(len(a))))
+        self.assertEqual(b, list(range(len(b))))
+
+        runTimes = manager.get_group_run_times()
+        self.assertEqual(set(runTimes), {"a", "b"})
+        self.assertTrue(all(runTime > 0 for runTime in runTimes.values()))
+
+        scheduler.run()
+        self.assertEqual(len(ran), 20)
+
+    def test_group_weight_share(self):
+        ''' Test that a group with twice the weight gets about twice the run time. '''
+        manager = scheduler.get_schedule_manager()
+        manager.set_fair_share(True)
+        manager.set_group_weight("heavy", 2.0)
+        running = [True]
+
+        def worker():
+            while running[0]:
+                self.busy([], None, 0.001)
+                scheduler.schedule()
+
+        for i in range(4):
+            scheduler.tasklet(worker)().group = "heavy"
+            scheduler.tasklet(worker)().group = "light"
+
+        totals = {"heavy": 0, "light": 0}
+        for i in range(5):
+            scheduler.run(timeout=0.03)
+            for group, runTime in manager.get_group_run_times().items():
+                totals[group] += runTime
+
+        running[0] = False
+        scheduler.run()
+        manager.set_group_weight("heavy", 1.0)
+
+        ratio = totals["heavy"] / totals["light"]
+        self.assertGreater(ratio, 1.5)
+        self.assertLess(ratio, 2.7)
+
+    def test_group_weight(self):
+        ''' Test that weights must be positive. '''
+        manager = scheduler.get_schedule_manager()
+        manager.set_group_weight("a", 2.0)
+        self.assertRaises(ValueError, manager.set_group_weight, "a", 0)
+        self.assertRaises(ValueError, manager.set_group_weight, "a", -1.0)
+
+
+class TestFrameBudget(test_utils.SchedulerTestCaseBase):
+    def setUp(self):
+        super().setUp()
+        scheduler.get_schedule_manager().set_frame_budget(True)
+
+    def tearDown(self):
+        scheduler.get_schedule_manager().set_frame_budget(False)
+        super().tearDown()
+
+    def test_overrun_is_taken_from_next_frame(self):
+        ''' Test that a frame overrun is paid off by the next frame before anything else runs. '''
+        manager = scheduler.get_schedule_manager()
+        self.assertTrue(manager.get_frame_budget())
+        ran = []
+
+        scheduler.tasklet(TestFairShare.busy)(ran, 0, 0.03)
+        scheduler.run(timeout=0.01)
+        self.assertEqual(ran, [0])
+
+        # Debt is capped at a single frame
+        self.assertAlmostEqual(manager.get_frame_debt(), 0.01)
+
+        scheduler.tasklet(ran.append)(1)
+        scheduler.run(timeout=0.01)
+        self.assertEqual(ran, [0])
+        self.assertEqual(manager.get_frame_debt(), 0.0)
+
+        scheduler.run(timeout=0.01)
+        self.assertEqual(ran, [0, 1])
+
+    def test_skipped_tasklets_run_first(self):
+        ''' Test that tasklets skipped by a frame run before tasklets that became runnable during it. '''
+        self.check_skipped_tasklets_run_first()
+
+    def test_skipped_tasklets_run_first_in_fair_share_mode(self):
+        ''' Test that group queues also run tasklets skipped by a frame first. '''
+        manager = scheduler.get_schedule_manager()
+        manager.set_fair_share(True)
+        try:
+            self.check_skipped_tasklets_run_first()
+        finally:
+            manager.set_fair_share(False)
+
+    def check_skipped_tasklets_run_first(self):
+        events = []
+        c = scheduler.channel()
+
+        def receiver():
+            events.append(("receiver", c.receive()))
+
+        def worker(i):
+            events.append(("worker", i))
+            if i == 0:
+                TestFairShare.busy([], i, 0.01)
+            # Receiver preference queues the receiver to run next, ahead of any skipped tasklets
+            c.send(i)
+            events.append(("resumed", i))
+
+        for i in range(5):
+            scheduler.tasklet(receiver)()
+        scheduler.run()
+        for i in range(5):
+            scheduler.tasklet(worker)(i)
+
+        scheduler.run(timeout=0.001)
+        started = [i for name, i in events if name == "worker"]
+        self.assertLess(len(started), 5)
+
+        frame = len(events)
+        scheduler.run(timeout=1)
+        self.assertEqual(self.getruncount(), 1)
+
+        # Everything left over from the first frame runs after the workers it skipped have started
+        nextFrame = events[frame:]
+        lastSkipped = max(nextFrame.index(("worker", i)) for i in range(len(started), 5))
+        leftOver = [nextFrame.index(("resumed", i)) for i in started]
+        leftOver += [nextFrame.index(("receiver", i)) for i in started if ("receiver", i) in nextFrame]
+        self.assertTrue(all(index > lastSkipped for index in leftOver))
+
+
+class TestAdaptiveBatching(test_utils.SchedulerTestCaseBase):
+    def setUp(self):
+        super().setUp()
+        scheduler.get_schedule_manager().set_adaptive_batching(True)
+
+    def tearDown(self):
+        scheduler.get_schedule_manager().set_adaptive_batching(False, 64)
+        super().tearDown()
+
+    def test_short_tasklets(self):
+        ''' Test that batching runs every short tasklet within the timeout. '''
+        self.assertTrue(scheduler.get_schedule_manager().get_adaptive_batching())
+        ran = []
+        for i in range(1000):
+            scheduler.tasklet(ran.append)(i)
+
+        scheduler.run(timeout=1)
+
+        self.assertEqual(ran, list(range(1000)))
+        self.assertEqual(self.getruncount(), 1)
+
+    def test_timeout_respected(self):
+        ''' Test that batches shrink as the budget runs out so the timeout still stops the run. '''
+        ran = []
+        for i in range(200):
+            scheduler.tasklet(TestFairShare.busy)(ran, i, 0.001)
+
+        scheduler.run(timeout=0.02)
+
+        self.assertGreater(len(ran), 0)
+        self.assertLess(len(ran), 40)
+
+        scheduler.run()
+        self.assertEqual(len(ran), 200)
+
+    def test_run_n_tasklets_unaffected(self):
+        ''' Test that tasklet count limits are still exact. '''
+        ran = []
+        for i in range(10):
+            scheduler.tasklet(ran.append)(i)
+
+        scheduler.run_n_tasklets(3)
+        self.assertEqual(ran, [0, 1, 2])
+
+        scheduler.run()
+
+    def test_max_batch_size(self):
+        ''' Test that the maximum batch size must be positive. '''
+        manager = scheduler.get_schedule_manager()
+        manager.set_adaptive_batching(True, max_batch_size=1)
+        self.assertRaises(ValueError, manager.set_adaptive_batching, True, 0)
+
+
 class TestSwitch(test_utils.SchedulerTestCaseBase):
     """Test the new tasklet.switch() method, which allows
     explicit switching
@@ -695,3 +1191,25 @@ class TestSwitchTrap(test_utils.SchedulerTestCaseBase):
         with self.assertRaises(RuntimeError):
             scheduler.run()
 
+
+
+class TestTaskletCounts(test_utils.SchedulerTestCaseBase):
+    def test_counts_kept_after_threads_exit(self):
+        ''' Test that the counts of exited threads are kept once their tasklets are released. '''
+        import threading
+
+        def worker():
+            scheduler.tasklet(lambda: None)()
+            scheduler.run()
+
+        allTimeCount = scheduler.get_all_time_tasklet_count()
+        activeCount = scheduler.get_active_tasklet_count()
+
+        for i in range(3):
+            thread = threading.Thread(target=worker)
+            thread.start()
+            thread.join()
+
+        # Main tasklet of each thread and the worker's tasklet
+        self.assertEqual(scheduler.get_all_time_tasklet_count(), allTimeCount + 6)
+        self.assertEqual(scheduler.get_active_tasklet_count(), activeCount)
@@ -0,0 +1,404 @@
+import sys
+import scheduler
+from test_utils import SchedulerTestCaseBase
+
+
+class TestLock(SchedulerTestCaseBase):
+    def test_uncontended_acquire_does_not_switch(self):
+        ''' Test that acquiring a free lock never schedules. '''
+        lock = scheduler.Lock()
+        switches = []
+
+        scheduler.set_schedule_callback(lambda prev, next: switches.append(next))
+        try:
+            self.assertTrue(lock.acquire())
+            self.assertTrue(lock.locked())
+            lock.release()
+        finally:
+            scheduler.set_schedule_callback(None)
+
+        self.assertFalse(lock.locked())
+        self.assertEqual(switches, [])
+
+    def test_non_blocking_acquire(self):
+        ''' Test that a non blocking acquire of a held lock fails immediately. '''
+        lock = scheduler.Lock()
+        lock.acquire()
+
+        self.assertFalse(lock.acquire(False))
+        self.assertFalse(lock.acquire(timeout=0))
+
+        lock.release()
+
+    def test_release_unlocked(self):
+        ''' Test that releasing an unlocked lock raises RuntimeError. '''
+        lock = scheduler.Lock()
+
+        self.assertRaises(RuntimeError, lock.release)
+
+    def test_contended_lock_hands_over_in_order(self):
+        ''' Test that waiting tasklets acquire the lock in the order they blocked. '''
+        lock = scheduler.Lock()
+        order = []
+
+        def worker(i):
+            with lock:
+                order.append(i)
+
+        lock.acquire()
+        for i in range(3):
+            scheduler.tasklet(worker)(i)
+        scheduler.run()
+
+        self.assertEqual(order, [])
+        self.assertEqual(self.getruncount(), 1)
+
+        # Release does not switch, ownership passes to the first waiter
+        lock.release()
+        self.assertTrue(lock.locked())
+        self.assertEqual(order, [])
+
+        scheduler.run()
+        self.assertEqual(order, [0, 1, 2])
+        self.assertFalse(lock.locked())
+
+    def test_acquire_timeout(self):
+        ''' Test that acquire returns False once the timeout expires. '''
+        lock = scheduler.Lock()
+        lock.acquire()
+
+        self.assertFalse(lock.acquire(timeout=0.01))
+        self.assertTrue(lock.locked())
+
+        lock.release()
+
+    def test_timed_waiter_keeps_its_place(self):
+        ''' Test that a waiter with a timeout acquires ahead of waiters that blocked after it. '''
+        lock = scheduler.Lock()
+        order = []
+
+        def worker(i, timeout):
+            if lock.acquire(timeout=timeout):
+                order.append(i)
+                lock.release()
+
+        lock.acquire()
+        scheduler.tasklet(worker)(0, 10)
+        scheduler.tasklet(worker)(1, None)
+        scheduler.run()
+
+        lock.release()
+        scheduler.run()
+        self.assertEqual(order, [0, 1])
+
+    def test_timed_waiter_owns_handed_over_lock(self):
+        ''' Test that a lock handed to a waiter with a timeout ahead of a plain waiter is owned by it. '''
+        lock = scheduler.Lock()
+        condition = scheduler.Condition(lock)
+        results = []
+
+        def timed():
+            results.append(lock.acquire(timeout=10))
+            condition.notify()
+            lock.release()
+
+        def plain():
+            lock.acquire()
+            results.append("plain")
+            lock.release()
+
+        lock.acquire()
+        scheduler.tasklet(timed)()
+        scheduler.tasklet(plain)()
+        scheduler.run()
+
+        lock.release()
+        scheduler.run()
+        self.assertEqual(results, [True, "plain"])
+        self.assertFalse(lock.locked())
+
+    def test_other_thread_refused(self):
+        ''' Test that a primitive cannot be used from a thread other than the one that created it. '''
+        import threading
+        lock = scheduler.Lock()
+        event = scheduler.Event()
+        errors = []
+
+        def thread_func():
+            for operation in (lock.acquire, event.set, lambda: scheduler.Condition(lock)):
+                try:
+                    operation()
+                except RuntimeError:
+                    errors.append(operation)
+
+        thread = threading.Thread(target=thread_func)
+        thread.start()
+        thread.join()
+
+        self.assertEqual(len(errors), 3)
+        self.assertFalse(lock.locked())
+        self.assertFalse(event.is_set())
+
+    def test_kill_waiter_after_handover(self):
+        ''' Test that a lock handed to a tasklet killed before running passes to the next waiter. '''
+        lock = scheduler.Lock()
+        acquired = []
+
+        def worker(i):
+            with lock:
+                acquired.append(i)
+
+        lock.acquire()
+        t1 = scheduler.tasklet(worker)(1)
+        t2 = scheduler.tasklet(worker)(2)
+        scheduler.run()
+
+        lock.release()
+        t1.kill()
+
+        scheduler.run()
+        self.assertEqual(acquired, [2])
+        self.assertFalse(lock.locked())
+        self.assertFalse(t2.alive)
+
+
+class TestSemaphore(SchedulerTestCaseBase):
+    def test_semaphore_counts(self):
+        ''' Test that a semaphore allows value concurrent holders. '''
+        semaphore = scheduler.Semaphore(2)
+
+        self.assertTrue(semaphore.acquire())
+        self.assertTrue(semaphore.acquire())
+        self.assertFalse(semaphore.acquire(blocking=False))
+        self.assertEqual(semaphore.value, 0)
+
+        semaphore.release()
+        semaphore.release()
+        self.assertEqual(semaphore.value, 2)
+
+    def test_semaphore_wakes_waiters(self):
+        ''' Test that releases hand units directly to waiting tasklets. '''
+        semaphore = scheduler.Semaphore(0)
+        done = []
+
+        for i in range(3):
+            scheduler.tasklet(lambda i=i: semaphore.acquire() and done.append(i))()
+        scheduler.run()
+
+        semaphore.release()
+        semaphore.release()
+        self.assertEqual(semaphore.value, 0)
+
+        scheduler.run()
+        self.assertEqual(done, [0, 1])
+
+        semaphore.release()
+        scheduler.run()
+        self.assertEqual(done, [0, 1, 2])
+
+    def test_invalid_value(self):
+        ''' Test that a negative initial value raises ValueError. '''
+        self.assertRaises(ValueError, scheduler.Semaphore, -1)
+
+
+class TestEvent(SchedulerTestCaseBase):
+    def test_wait_on_set_event(self):
+        ''' Test that waiting on a set event returns immediately. '''
+        event = scheduler.Event()
+        event.set()
+
+        self.assertTrue(event.is_set())
+        self.assertTrue(event.wait())
+
+        event.clear()
+        self.assertFalse(event.is_set())
+        self.assertFalse(event.wait(timeout=0))
+
+    def test_set_wakes_all_waiters(self):
+        ''' Test that setting the event wakes every waiter without switching. '''
+        event = scheduler.Event()
+        woken = []
+
+        for i in range(3):
+            scheduler.tasklet(lambda i=i: event.wait() and woken.append(i))()
+        scheduler.run()
+
+        event.set()
+        self.assertEqual(woken, [])
+        self.assertEqual(self.getruncount(), 4)
+
+        scheduler.run()
+        self.assertEqual(woken, [0, 1, 2])
+
+    def test_wait_timeout(self):
+        ''' Test that waiting returns False once the timeout expires. '''
+        event = scheduler.Event()
+
+        self.assertFalse(event.wait(timeout=0.01))
+
+
+class TestCondition(SchedulerTestCaseBase):
+    def test_wait_requires_lock(self):
+        ''' Test that waiting or notifying without holding the lock raises RuntimeError. '''
+        condition = scheduler.Condition()
+
+        self.assertRaises(RuntimeError, condition.wait)
+        self.assertRaises(RuntimeError, condition.notify)
+        self.assertRaises(RuntimeError, condition.notify_all)
+
+    def test_producer_consumer(self):
+        ''' Test that notify wakes a waiting consumer which reacquires the lock. '''
+        condition = scheduler.Condition()
+        items = []
+        consumed = []
+
+        def consumer():
+            with condition:
+                while not items:
+                    condition.wait()
+                consumed.append(items.pop())
+
+        scheduler.tasklet(consumer)()
+        scheduler.tasklet(consumer)()
+        scheduler.run()
+
+        with condition:
+            items.append(1)
+            items.append(2)
+            condition.notify_all()
+
+        scheduler.run()
+        self.assertEqual(sorted(consumed), [1, 2])
+
+    def test_shared_lock(self):
+        ''' Test that a condition can be built on an existing lock. '''
+        lock = scheduler.Lock()
+        condition = scheduler.Condition(lock)
+
+        with condition:
+            self.assertTrue(lock.locked())
+        self.assertFalse(lock.locked())
+
+        self.assertRaises(TypeError, scheduler.Condition, object())
+
+    def test_wait_timeout_reacquires(self):
+        ''' Test that a timed out wait still holds the lock. '''
+        condition = scheduler.Condition()
+
+        with condition:
+            self.assertFalse(condition.wait(timeout=0.01))
+            self.assertTrue(condition.acquire(blocking=False) is False)
+
+
+class TestTaskGroup(SchedulerTestCaseBase):
+    def test_join_waits_for_children(self):
+        ''' Test that joining parks the current tasklet until every child has exited. '''
+        c = scheduler.channel()
+        done = []
+
+        def worker(i):
+            c.receive()
+            done.append(i)
+
+        group = scheduler.TaskGroup()
+        for i in range(3):
+            group.spawn(worker, i)
+        scheduler.run()
+
+        self.assertEqual(group.pending, 3)
+        self.assertFalse(group.join(timeout=0))
+
+        def sender():
+            for i in range(3):
+                c.send(None)
+
+        scheduler.tasklet(sender)()
+
+        self.assertTrue(group.join())
+        self.assertEqual(done, [0, 1, 2])
+        self.assertEqual(group.pending, 0)
+
+    def test_spawn_arguments(self):
+        ''' Test that spawn passes positional and keyword arguments to the callable. '''
+        results = []
+
+        with scheduler.TaskGroup() as group:
+            t = group.spawn(lambda a, b=None: results.append((a, b)), 1, b=2)
+            self.assertIsInstance(t, scheduler.tasklet)
+
+        self.assertEqual(results, [(1, 2)])
+
+    def test_child_exception_cancels_siblings(self):
+        ''' Test that the first failing child kills its siblings and its exception is raised from join. '''
+        c = scheduler.channel()
+        exited = []
+
+        def waiter():
+            try:
+                c.receive()
+            except scheduler.TaskletExit:
+                exited.append(True)
+                raise
+
+        def failer():
+            raise ValueError('failed')
+
+        with self.assertRaises(ValueError):
+            with scheduler.TaskGroup() as group:
+                siblings = [group.spawn(waiter) for i in range(2)]
+                group.spawn(failer)
+
+        self.assertEqual(exited, [True, True])
+        self.assertFalse(any(t.alive for t in siblings))
+        self.assertEqual(c.balance, 0)
+        self.assertEqual(self.getruncount(), 1)
+
+    def test_body_exception_kills_children(self):
+        ''' Test that an exception raised by the with block kills the children and propagates. '''
+        c = scheduler.channel()
+
+        with self.assertRaises(KeyError):
+            with scheduler.TaskGroup() as group:
+                t = group.spawn(c.receive)
+                scheduler.run()
+                raise KeyError()
+
+        self.assertFalse(t.alive)
+        self.assertEqual(c.balance, 0)
+
+    def test_join_from_tasklet(self):
+        ''' Test that a tasklet can join a group of its own children. '''
+        results = []
+
+        def parent():
+            with scheduler.TaskGroup() as group:
+                for i in range(3):
+                    group.spawn(results.append, i)
+            results.append('joined')
+
+        scheduler.tasklet(parent)()
+        scheduler.run()
+
+        self.assertEqual(results, [0, 1, 2, 'joined'])
+
+    def test_cancel(self):
+        ''' Test that cancel kills every child. '''
+        c = scheduler.channel()
+
+        group = scheduler.TaskGroup()
+        children = [group.spawn(c.receive) for i in range(3)]
+        scheduler.run()
+
+        group.cancel()
+        self.assertTrue(group.join())
+        self.assertFalse(any(t.alive for t in children))
+
+    def test_children_released(self):
+        ''' Test that the group does not keep exited children alive. '''
+        import weakref
+
+        group = scheduler.TaskGroup()
+        ref = weakref.ref(group.spawn(lambda: None))
+        group.join()
+
+        self.assertIsNone(ref())
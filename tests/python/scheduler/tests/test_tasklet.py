@@ -99,10 +99,14 @@ class TestTasklets(test_utils.SchedulerTestCaseBase):
 
         tasklet1.kill()
 
-        self.assertEqual(self.getruncount(), 1)
+        # Tasklet 1 had not started so it is killed without running the scheduler
+        self.assertEqual(self.getruncount(), 3)
+        self.assertEqual(value[0],0)
+
+        scheduler.run()
 
-        # Tasklet 1 was killed, tasklets were run from this point
-        # So tasklet 2 and 3 will run and value should be 2
+        # Tasklet 2 and 3 run and value should be 2
+        self.assertEqual(self.getruncount(), 1)
         self.assertEqual(value[0],2)
 
     def test_paused(self):
@@ -803,8 +807,163 @@ class TestKill(test_utils.SchedulerTestCaseBase):
     #@testcase_leaks_references("chatches TaskletExit and does not die in its own thread")
     #def test_kill_without_thread_state_blocked_nl1(self):
     #    return self._test_kill_without_thread_state(1, True)
+
+    def test_kill_unstarted_does_not_run_scheduler(self):
+        ''' Test that killing a tasklet that never ran marks it dead without switching to anything. '''
+        switches = []
+        results = []
+
+        t = scheduler.tasklet(results.append)(1)
+        other = scheduler.tasklet(results.append)(2)
+
+        scheduler.set_schedule_callback(lambda prev, next: switches.append(next))
+        try:
+            t.kill()
+        finally:
+            scheduler.set_schedule_callback(None)
+
+        self.assertFalse(t.alive)
+        self.assertTrue(other.alive)
+        self.assertEqual(switches, [])
+        self.assertEqual(results, [])
+        self.assertRaises(scheduler.TaskletExit, t.result)
+        self.assertEqual(self.getruncount(), 2)
+
+        scheduler.run()
+        self.assertEqual(results, [2])
+
+    def test_kill_before_run_releases_callable(self):
+        ''' Test that killing a tasklet that never ran releases its callable without running it. '''
+        import weakref
+
+        class Callable(object):
+            def __call__(self):
+                self.ran = True
+
+        callable = Callable()
+        ref = weakref.ref(callable)
+        t = scheduler.tasklet(callable)()
+        del callable
+
+        self.assertIsNotNone(ref())
+        t.kill()
+
+        self.assertFalse(t.alive)
+        self.assertIsNone(ref())
             
 
+class TestKillAll(test_utils.SchedulerTestCaseBase):
+
+    def test_kill_all(self):
+        ''' Test that started, blocked and unstarted tasklets are all killed in one call. '''
+        c = scheduler.channel()
+        killed = []
+        ran = []
+
+        def blocked(i):
+            try:
+                c.receive()
+            except scheduler.TaskletExit:
+                killed.append(i)
+                raise
+
+        def started(i):
+            try:
+                scheduler.schedule()
+            except scheduler.TaskletExit:
+                killed.append(i)
+                raise
+
+        tasklets = [scheduler.tasklet(blocked)(i) for i in range(3)]
+        tasklets.append(scheduler.tasklet(started)(3))
+        scheduler.run_n_tasklets(4)
+        tasklets += [scheduler.tasklet(ran.append)(i) for i in range(3)]
+
+        scheduler.kill_all(tasklets, pending=False)
+
+        self.assertEqual(sorted(killed), [0, 1, 2, 3])
+        self.assertEqual(ran, [])
+        self.assertFalse(any(t.alive for t in tasklets))
+        self.assertEqual(c.balance, 0)
+        self.assertEqual(self.getruncount(), 1)
+
+    def test_kill_all_pending(self):
+        ''' Test that pending kills are delivered by the next run. '''
+        c = scheduler.channel()
+
+        tasklets = [scheduler.tasklet(c.receive)() for i in range(3)]
+        scheduler.run()
+
+        scheduler.kill_all(tasklets)
+
+        self.assertEqual(c.balance, 0)
+        self.assertTrue(all(t.alive for t in tasklets))
+        self.assertEqual(self.getruncount(), 4)
+
+        scheduler.run()
+
+        self.assertFalse(any(t.alive for t in tasklets))
+        self.assertEqual(self.getruncount(), 1)
+
+    def test_kill_all_thread(self):
+        ''' Test that with no tasklets every other tasklet on the thread is killed. '''
+        c = scheduler.channel()
+        tasklets = [scheduler.tasklet(c.receive)() for i in range(3)]
+        scheduler.run()
+        tasklets += [scheduler.tasklet(lambda: None)() for i in range(3)]
+
+        scheduler.kill_all(pending=False)
+
+        self.assertFalse(any(t.alive for t in tasklets))
+        self.assertEqual(self.getruncount(), 1)
+
+    def test_kill_all_including_current(self):
+        ''' Test that the current tasklet is killed after the other victims. '''
+        c = scheduler.channel()
+        others = [scheduler.tasklet(c.receive)() for i in range(2)]
+        scheduler.run()
+        results = []
+
+        def killer():
+            try:
+                scheduler.kill_all(others + [scheduler.getcurrent()], pending=False)
+            except scheduler.TaskletExit:
+                results.append([t.alive for t in others])
+                raise
+
+        t = scheduler.tasklet(killer)()
+        scheduler.run()
+
+        self.assertEqual(results, [[False, False]])
+        self.assertFalse(t.alive)
+
+    def test_kill_survivor_again(self):
+        ''' Test that a tasklet that survives a kill can be killed again. '''
+        c = scheduler.channel()
+
+        def stubborn():
+            try:
+                c.receive()
+            except scheduler.TaskletExit:
+                pass
+            c.receive()
+
+        t = scheduler.tasklet(stubborn)()
+        scheduler.run()
+
+        scheduler.kill_all([t])
+        scheduler.run()
+        self.assertTrue(t.alive)
+
+        scheduler.kill_all([t], pending=False)
+        self.assertFalse(t.alive)
+
+    def test_kill_all_type_error(self):
+        ''' Test that anything other than tasklets raises TypeError. '''
+        self.assertRaises(TypeError, scheduler.kill_all, [object()])
+        self.assertRaises(TypeError, scheduler.kill_all, 5)
+
+
 class TestExceptions(test_utils.SchedulerTestCaseBase):
 
     def test_raise_exception(self):
@@ -1507,4 +1666,315 @@ class TestTaskletDontRaise(test_utils.SchedulerTestCaseBase):
 
         # There should now only be one reference remaining (2 for sys.getrefcount)
         self.assertEqual(sys.getrefcount(tasklet[0]),2)
-        tasklet[0] = None
\ No newline at end of file
+        tasklet[0] = None
+
+class TestTaskletLocalStorage(test_utils.SchedulerTestCaseBase):
+    def test_values_are_per_tasklet(self):
+        ''' Test that each tasklet sees only the value it stored in a slot. '''
+        slot = scheduler.tls_slot()
+        seen = []
+
+        def worker(value):
+            slot.set(value)
+            scheduler.schedule()
+            seen.append(slot.get())
+
+        scheduler.tasklet(worker)('a')
+        scheduler.tasklet(worker)('b')
+        scheduler.run()
+
+        self.assertEqual(seen, ['a', 'b'])
+        self.assertIsNone(slot.get())
+        self.assertEqual(slot.get('default'), 'default')
+
+    def test_slots_are_distinct(self):
+        ''' Test that separately allocated slots do not share values. '''
+        first = scheduler.tls_slot()
+        second = scheduler.tls_slot()
+
+        self.assertNotEqual(first.index, second.index)
+
+        first.set(1)
+        try:
+            self.assertIsNone(second.get())
+        finally:
+            first.clear()
+
+        self.assertIsNone(first.get())
+
+    def test_descriptor(self):
+        ''' Test that a slot used as a class attribute reads the current tasklet's value. '''
+        class Context(object):
+            request = scheduler.tls_slot()
+
+        context = Context()
+        results = []
+
+        def worker(value):
+            context.request = value
+            scheduler.schedule()
+            results.append(context.request)
+            del context.request
+
+        scheduler.tasklet(worker)(1)
+        scheduler.tasklet(worker)(2)
+        scheduler.run()
+
+        self.assertEqual(results, [1, 2])
+        self.assertIsInstance(Context.request, scheduler.TaskletLocalSlot)
+        self.assertRaises(AttributeError, getattr, context, 'request')
+
+    def test_values_released_with_tasklet(self):
+        ''' Test that values are released once the tasklet is destroyed. '''
+        import weakref
+        import gc
+
+        slot = scheduler.tls_slot()
+
+        class Value(object):
+            pass
+
+        value = Value()
+        ref = weakref.ref(value)
+
+        t = scheduler.tasklet(slot.set)(value)
+        scheduler.run()
+        del value
+
+        self.assertIsNotNone(ref())
+        del t
+        gc.collect()
+        self.assertIsNone(ref())
+
+    def test_cycle_through_tasklet_is_collected(self):
+        ''' Test that a stored value referencing its tasklet does not leak. '''
+        import weakref
+        import gc
+
+        slot = scheduler.tls_slot()
+
+        def worker():
+            slot.set(scheduler.getcurrent())
+
+        t = scheduler.tasklet(worker)()
+        scheduler.run()
+        ref = weakref.ref(t)
+        del t
+        gc.collect()
+
+        self.assertIsNone(ref())
+
+
+class TestTaskletContextVars(test_utils.SchedulerTestCaseBase):
+    def setUp(self):
+        super().setUp()
+        import contextvars
+        self.var = contextvars.ContextVar('var', default='default')
+
+    def test_tasklet_inherits_creator_context(self):
+        ''' Test that a tasklet sees the values set by its creator when it was set up. '''
+        seen = []
+
+        token = self.var.set('creator')
+        try:
+            scheduler.tasklet(lambda: seen.append(self.var.get()))()
+        finally:
+            self.var.reset(token)
+
+        scheduler.run()
+
+        self.assertEqual(seen, ['creator'])
+
+    def test_values_do_not_leak_between_tasklets(self):
+        ''' Test that values set by a tasklet stay local to it across switches. '''
+        seen = []
+
+        def worker(value):
+            self.var.set(value)
+            scheduler.schedule()
+            seen.append(self.var.get())
+
+        scheduler.tasklet(worker)('a')
+        scheduler.tasklet(worker)('b')
+        scheduler.run()
+
+        self.assertEqual(seen, ['a', 'b'])
+        self.assertEqual(self.var.get(), 'default')
+
+    def test_set_context(self):
+        ''' Test that a tasklet runs in the context passed to set_context. '''
+        import contextvars
+        context = contextvars.Context()
+        context.run(self.var.set, 'explicit')
+        seen = []
+
+        def worker():
+            seen.append(self.var.get())
+            self.var.set('changed')
+
+        t = scheduler.tasklet(worker)
+        self.assertIs(t.set_context(context), t)
+        t()
+        scheduler.run()
+
+        self.assertEqual(seen, ['explicit'])
+        self.assertEqual(context[self.var], 'changed')
+        self.assertEqual(self.var.get(), 'default')
+
+    def test_set_context_after_setup(self):
+        ''' Test that set_context applies to a tasklet that has already been set up. '''
+        import contextvars
+        context = contextvars.Context()
+        context.run(self.var.set, 'explicit')
+        seen = []
+
+        t = scheduler.tasklet(lambda: seen.append(self.var.get()))()
+        t.set_context(context)
+        scheduler.run()
+
+        self.assertEqual(seen, ['explicit'])
+
+    def test_set_context_invalid(self):
+        ''' Test that set_context raises TypeError when not given a Context. '''
+        t = scheduler.tasklet(lambda: None)
+
+        self.assertRaises(TypeError, t.set_context, {})
+
+
+class TestTaskletJoin(test_utils.SchedulerTestCaseBase):
+    def test_result(self):
+        ''' Test that result returns the value returned by the callable. '''
+        t = scheduler.tasklet(lambda x: x * 2)(21)
+
+        self.assertRaises(RuntimeError, t.result)
+
+        scheduler.run()
+
+        self.assertEqual(t.result(), 42)
+
+    def test_result_exception(self):
+        ''' Test that result raises the exception the tasklet exited with. '''
+        def fail():
+            raise ValueError('failed')
+
+        t = scheduler.tasklet(fail)()
+        self.assertRaises(ValueError, scheduler.run)
+
+        self.assertRaises(ValueError, t.result)
+
+    def test_result_killed(self):
+        ''' Test that result raises TaskletExit for a killed tasklet. '''
+        c = scheduler.channel()
+
+        t = scheduler.tasklet(c.receive)()
+        scheduler.run()
+        t.kill()
+        self.assertRaises(scheduler.TaskletExit, t.result)
+
+        t = scheduler.tasklet(c.receive)()
+        t.kill()
+        self.assertRaises(scheduler.TaskletExit, t.result)
+
+    def test_join_from_main(self):
+        ''' Test that the main tasklet joining runs the scheduler until the tasklet exits. '''
+        c = scheduler.channel()
+
+        def worker():
+            return c.receive()
+
+        t = scheduler.tasklet(worker)()
+        scheduler.tasklet(c.send)('value')
+
+        self.assertTrue(t.join())
+        self.assertFalse(t.alive)
+        self.assertEqual(t.result(), 'value')
+
+    def test_multiple_joiners(self):
+        ''' Test that every joining tasklet is woken in the order it joined. '''
+        c = scheduler.channel()
+        order = []
+
+        target = scheduler.tasklet(c.receive)()
+
+        def joiner(i):
+            target.join()
+            order.append(i)
+
+        for i in range(3):
+            scheduler.tasklet(joiner)(i)
+        scheduler.run()
+
+        self.assertEqual(order, [])
+        self.assertEqual(self.getruncount(), 1)
+
+        c.send(None)
+        scheduler.run()
+
+        self.assertEqual(order, [0, 1, 2])
+
+    def test_join_timeout(self):
+        ''' Test that join returns False once the timeout expires. '''
+        c = scheduler.channel()
+
+        t = scheduler.tasklet(c.receive)()
+        scheduler.run()
+
+        self.assertFalse(t.join(timeout=0))
+        self.assertFalse(t.join(timeout=0.01))
+        self.assertTrue(t.alive)
+
+        c.send(None)
+        self.assertTrue(t.join(timeout=0))
+
+    def test_kill_joiner(self):
+        ''' Test that killing a joining tasklet removes it from the join. '''
+        c = scheduler.channel()
+        order = []
+
+        target = scheduler.tasklet(c.receive)()
+
+        def joiner(i):
+            target.join()
+            order.append(i)
+
+        first = scheduler.tasklet(joiner)(1)
+        scheduler.tasklet(joiner)(2)
+        scheduler.run()
+
+        first.kill()
+        c.send(None)
+        scheduler.run()
+
+        self.assertEqual(order, [2])
+
+    def test_join_invalid(self):
+        ''' Test that joining itself or the main tasklet raises RuntimeError. '''
+        results = []
+
+        def worker():
+            self.assertRaises(RuntimeError, scheduler.getcurrent().join)
+            self.assertRaises(RuntimeError, scheduler.getmain().join)
+            results.append(True)
+
+        scheduler.tasklet(worker)()
+        scheduler.run()
+
+        self.assertEqual(results, [True])
+
+    def test_result_released(self):
+        ''' Test that a stored result does not keep a cycle through the tasklet alive. '''
+        import gc
+        import weakref
+
+        def worker():
+            return scheduler.getcurrent()
+
+        t = scheduler.tasklet(worker)()
+        scheduler.run()
+        self.assertIs(t.result(), t)
+
+        ref = weakref.ref(t)
+        del t
+        gc.collect()
+
+        self.assertIsNone(ref())
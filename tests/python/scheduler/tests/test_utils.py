@@ -50,6 +50,14 @@ class SchedulerTestCaseBase(unittest.TestCase):
         #Ensure that running value matches calculated value
         self.assertEqual(runCount, scheduler.calculateruncount())
 
+        #Ensure that running value matches the length of the queue
+        queueLength = 1
+        tasklet = scheduler.getmain().next
+        while tasklet is not None:
+            queueLength += 1
+            tasklet = tasklet.next
+        self.assertEqual(runCount, queueLength)
+
         return runCount
 
 